@@ -10,6 +10,7 @@
 #include "config.h"
 #include <ctype.h>
 #include <stdlib.h>
+#include "cutter.h"
 #include "device.h"
 #include "i18n.h"
 #include "interface.h"
@@ -403,6 +404,9 @@ cSetup::cSetup(void)
   EPGScanTimeout = 5;
   EPGBugfixLevel = 3;
   EPGLinger = 0;
+  EPGBinaryData = 0;
+  EPGJournal = 0;
+  EPGCompression = 0;
   SVDRPTimeout = 300;
   ZapTimeout = 3;
   ChannelEntryTimeout = 1000;
@@ -446,6 +450,11 @@ cSetup::cSetup(void)
   FontFixSize = 20;
   MaxVideoFileSize = MAXVIDEOFILESIZEDEFAULT;
   SplitEditedFiles = 0;
+  MaxCuttingJobs = 2;
+  CuttingBandwidth = 0;
+  RemovalStep = 0;
+  RemovalBandwidth = 50;
+  StripeVideoFiles = 0;
   DelTimeshiftRec = 0;
   DumpNaluFill = 0;
   MinEventTimeout = 30;
@@ -598,6 +607,9 @@ bool cSetup::Parse(const char *Name, const char *Value)
   else if (!strcasecmp(Name, "EPGScanTimeout"))      EPGScanTimeout     = atoi(Value);
   else if (!strcasecmp(Name, "EPGBugfixLevel"))      EPGBugfixLevel     = atoi(Value);
   else if (!strcasecmp(Name, "EPGLinger"))           EPGLinger          = atoi(Value);
+  else if (!strcasecmp(Name, "EPGBinaryData"))       EPGBinaryData      = atoi(Value);
+  else if (!strcasecmp(Name, "EPGJournal"))          EPGJournal         = atoi(Value);
+  else if (!strcasecmp(Name, "EPGCompression"))      EPGCompression     = atoi(Value);
   else if (!strcasecmp(Name, "SVDRPTimeout"))        SVDRPTimeout       = atoi(Value);
   else if (!strcasecmp(Name, "ZapTimeout"))          ZapTimeout         = atoi(Value);
   else if (!strcasecmp(Name, "ChannelEntryTimeout")) ChannelEntryTimeout= atoi(Value);
@@ -641,6 +653,11 @@ bool cSetup::Parse(const char *Name, const char *Value)
   else if (!strcasecmp(Name, "FontFixSize"))         FontFixSize        = atoi(Value);
   else if (!strcasecmp(Name, "MaxVideoFileSize"))    MaxVideoFileSize   = atoi(Value);
   else if (!strcasecmp(Name, "SplitEditedFiles"))    SplitEditedFiles   = atoi(Value);
+  else if (!strcasecmp(Name, "MaxCuttingJobs"))      MaxCuttingJobs     = constrain(atoi(Value), 1, MAXCUTTINGJOBS);
+  else if (!strcasecmp(Name, "CuttingBandwidth"))    CuttingBandwidth   = max(atoi(Value), 0);
+  else if (!strcasecmp(Name, "RemovalStep"))         RemovalStep        = max(atoi(Value), 0);
+  else if (!strcasecmp(Name, "RemovalBandwidth"))    RemovalBandwidth   = max(atoi(Value), 0);
+  else if (!strcasecmp(Name, "StripeVideoFiles"))    StripeVideoFiles   = atoi(Value);
   else if (!strcasecmp(Name, "DelTimeshiftRec"))     DelTimeshiftRec    = atoi(Value);
   else if (!strcasecmp(Name, "DumpNaluFill"))        DumpNaluFill       = atoi(Value);
   else if (!strcasecmp(Name, "MinEventTimeout"))     MinEventTimeout    = atoi(Value);
@@ -696,6 +713,9 @@ bool cSetup::Save(void)
   Store("EPGScanTimeout",     EPGScanTimeout);
   Store("EPGBugfixLevel",     EPGBugfixLevel);
   Store("EPGLinger",          EPGLinger);
+  Store("EPGBinaryData",      EPGBinaryData);
+  Store("EPGJournal",         EPGJournal);
+  Store("EPGCompression",     EPGCompression);
   Store("SVDRPTimeout",       SVDRPTimeout);
   Store("ZapTimeout",         ZapTimeout);
   Store("ChannelEntryTimeout",ChannelEntryTimeout);
@@ -739,6 +759,11 @@ bool cSetup::Save(void)
   Store("FontFixSize",        FontFixSize);
   Store("MaxVideoFileSize",   MaxVideoFileSize);
   Store("SplitEditedFiles",   SplitEditedFiles);
+  Store("MaxCuttingJobs",     MaxCuttingJobs);
+  Store("CuttingBandwidth",   CuttingBandwidth);
+  Store("RemovalStep",        RemovalStep);
+  Store("RemovalBandwidth",   RemovalBandwidth);
+  Store("StripeVideoFiles",   StripeVideoFiles);
   Store("DelTimeshiftRec",    DelTimeshiftRec);
   Store("DumpNaluFill",       DumpNaluFill);
   Store("MinEventTimeout",    MinEventTimeout);
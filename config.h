@@ -27,8 +27,8 @@
 
 // The plugin API's version number:
 
-#define APIVERSION  "1.7.27"
-#define APIVERSNUM   10727  // Version * 10000 + Major * 100 + Minor
+#define APIVERSION  "1.7.28"
+#define APIVERSNUM   10728  // Version * 10000 + Major * 100 + Minor
 
 // When loading plugins, VDR searches them by their APIVERSION, which
 // may be smaller than VDRVERSION in case there have been no changes to
@@ -265,6 +265,9 @@ public:
   int EPGScanTimeout;
   int EPGBugfixLevel;
   int EPGLinger;
+  int EPGBinaryData;
+  int EPGJournal;
+  int EPGCompression;
   int SVDRPTimeout;
   int ZapTimeout;
   int ChannelEntryTimeout;
@@ -300,6 +303,11 @@ public:
   int FontFixSize;
   int MaxVideoFileSize;
   int SplitEditedFiles;
+  int MaxCuttingJobs;
+  int CuttingBandwidth;
+  int RemovalStep;
+  int RemovalBandwidth;
+  int StripeVideoFiles;
   int DelTimeshiftRec;
   int DumpNaluFill;
   int MinEventTimeout, MinUserInactivity;
@@ -8,43 +8,422 @@
  */
 
 #include "cutter.h"
+#include <sys/stat.h>
 #include "menu.h"
 #include "recording.h"
 #include "remux.h"
 #include "videodir.h"
 
+#define MAXREADCHUNK     MEGABYTE(4)  // max. number of bytes read from the original recording in one go
+#define MAXEXTENTCOPY    MEGABYTE(64) // max. number of bytes copied in one go
+#define MAXCUTTERBUFFER  MEGABYTE(32) // max. number of bytes buffered between reader and writer
+#define MAXCUTTERCHUNKS  64           // max. number of chunks buffered between reader and writer
+#define CUTTERQUEUEWAIT  100          // ms to wait for the reader or writer
+#define CUTTERSTATSDELTA 60           // seconds between log entries about the editing throughput
+
+// --- cCuttingChunk ---------------------------------------------------------
+
+// A run of frames that are stored contiguously in one file of the original
+// recording. The data of the frames is either read into memory, or (if 'data'
+// is NULL) copied by the writer directly from the original file.
+
+class cCuttingChunk : public cListObject {
+private:
+  struct tFrame {
+    int index;
+    int length;
+    bool independent;
+    } *frames;
+  int numFrames;
+  int allocated;
+  uint16_t fileNumber;
+  off_t fileOffset;
+  int length;
+  uchar *data;
+  bool extent;
+public:
+  cCuttingChunk(uint16_t FileNumber, off_t FileOffset, bool Extent);
+  virtual ~cCuttingChunk();
+  void AddFrame(int Index, int Length, bool Independent);
+  bool Read(cUnbufferedFile *File);
+       ///< Reads the data of all frames of this chunk from File, which must be
+       ///< positioned at the offset of the first frame. If the file is shorter
+       ///< than expected, the lengths of the frames are reduced accordingly.
+       ///< Returns false in case of an error.
+  int NumFrames(void) const { return numFrames; }
+  int Index(int i) const { return frames[i].index; }
+  int Length(int i) const { return frames[i].length; }
+  bool Independent(int i) const { return frames[i].independent; }
+  uint16_t FileNumber(void) const { return fileNumber; }
+  off_t FileOffset(void) const { return fileOffset; }
+  int TotalLength(void) const { return length; }
+  uchar *Data(void) { return data; }
+  bool Extent(void) const { return extent; }
+  bool Unbounded(void) const { return numFrames && frames[numFrames - 1].length < 0; }
+       ///< Returns true if the last frame extends up to the end of its file.
+  };
+
+cCuttingChunk::cCuttingChunk(uint16_t FileNumber, off_t FileOffset, bool Extent)
+{
+  frames = NULL;
+  numFrames = allocated = 0;
+  fileNumber = FileNumber;
+  fileOffset = FileOffset;
+  length = 0;
+  data = NULL;
+  extent = Extent;
+}
+
+cCuttingChunk::~cCuttingChunk()
+{
+  free(frames);
+  free(data);
+}
+
+void cCuttingChunk::AddFrame(int Index, int Length, bool Independent)
+{
+  if (numFrames >= allocated) {
+     int NewAllocated = allocated ? allocated * 2 : 64;
+     if (tFrame *NewFrames = (tFrame *)realloc(frames, NewAllocated * sizeof(tFrame))) {
+        frames = NewFrames;
+        allocated = NewAllocated;
+        }
+     else {
+        esyslog("ERROR: out of memory");
+        return;
+        }
+     }
+  frames[numFrames].index = Index;
+  frames[numFrames].length = Length;
+  frames[numFrames].independent = Independent;
+  numFrames++;
+  if (Length > 0)
+     length += Length;
+}
+
+bool cCuttingChunk::Read(cUnbufferedFile *File)
+{
+  int Size = Unbounded() ? length + MAXFRAMESIZE : length;
+  data = MALLOC(uchar, max(Size, 1));
+  if (!data) {
+     esyslog("ERROR: can't allocate cutting buffer");
+     return false;
+     }
+  int r = 0;
+  while (r < Size) {
+        int n = File->Read(data + r, Size - r);
+        if (n < 0) {
+           LOG_ERROR;
+           return false;
+           }
+        if (n == 0)
+           break;
+        r += n;
+        }
+  if (r != length) {
+     // the file is shorter than expected, or the last frame extends to the end of the file:
+     int Rest = r;
+     for (int i = 0; i < numFrames; i++) {
+         int l = frames[i].length < 0 ? Rest : min(frames[i].length, Rest);
+         frames[i].length = l;
+         Rest -= l;
+         }
+     length = r;
+     }
+  return true;
+}
+
+// --- cCuttingQueue ---------------------------------------------------------
+
+class cCuttingQueue {
+private:
+  cMutex mutex;
+  cCondVar chunkAdded;
+  cCondVar chunkRemoved;
+  cList<cCuttingChunk> chunks;
+  int bytes;
+  bool done;
+public:
+  cCuttingQueue(void);
+  bool Put(cCuttingChunk *Chunk, int TimeoutMs);
+       ///< Appends Chunk to the queue. If the queue is full, waits up to TimeoutMs
+       ///< milliseconds for the writer to fetch data. Returns false (and leaves
+       ///< Chunk to the caller) if there is still no room after that time.
+  cCuttingChunk *Get(int TimeoutMs);
+       ///< Returns the next chunk from the queue, waiting up to TimeoutMs milliseconds
+       ///< for it if necessary. The caller takes ownership of the returned chunk.
+  void SetDone(void);
+       ///< Tells the queue that no more chunks will be put into it.
+  bool Done(void);
+       ///< Returns true if SetDone() has been called and all chunks have been fetched.
+  };
+
+cCuttingQueue::cCuttingQueue(void)
+{
+  bytes = 0;
+  done = false;
+}
+
+bool cCuttingQueue::Put(cCuttingChunk *Chunk, int TimeoutMs)
+{
+  cMutexLock MutexLock(&mutex);
+  if (chunks.Count() >= MAXCUTTERCHUNKS || bytes >= MAXCUTTERBUFFER) {
+     chunkRemoved.TimedWait(mutex, TimeoutMs);
+     if (chunks.Count() >= MAXCUTTERCHUNKS || bytes >= MAXCUTTERBUFFER)
+        return false;
+     }
+  chunks.Add(Chunk);
+  if (!Chunk->Extent())
+     bytes += Chunk->TotalLength();
+  chunkAdded.Broadcast();
+  return true;
+}
+
+cCuttingChunk *cCuttingQueue::Get(int TimeoutMs)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!chunks.First() && !done)
+     chunkAdded.TimedWait(mutex, TimeoutMs);
+  cCuttingChunk *Chunk = chunks.First();
+  if (Chunk) {
+     chunks.Del(Chunk, false);
+     if (!Chunk->Extent())
+        bytes -= Chunk->TotalLength();
+     chunkRemoved.Broadcast();
+     }
+  return Chunk;
+}
+
+void cCuttingQueue::SetDone(void)
+{
+  cMutexLock MutexLock(&mutex);
+  done = true;
+  chunkAdded.Broadcast();
+}
+
+bool cCuttingQueue::Done(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return done && !chunks.First();
+}
+
+// --- cCuttingReader --------------------------------------------------------
+
+// Reads the frames that are to be copied into the edited version, using large
+// reads that span as many frames as possible, and passes them on to the writer
+// through a cCuttingQueue.
+
+class cCuttingReader : public cThread {
+private:
+  const char *error;
+  cFileName *fileName;
+  cIndexFile *index;
+  cMarks *marks;
+  cCuttingQueue *queue;
+  volatile bool *extentCopy;
+  cUnbufferedFile *file;
+  uint16_t fileNumber;
+  off_t filePos;
+  bool Deliver(cCuttingChunk *Chunk);
+protected:
+  virtual void Action(void);
+public:
+  cCuttingReader(const char *FileName, bool IsPesRecording, cMarks *Marks, cCuttingQueue *Queue, volatile bool *ExtentCopy);
+  virtual ~cCuttingReader();
+  void Stop(void) { Cancel(3); }
+  int Frames(void);
+       ///< Returns the number of frames that will be copied into the edited version
+       ///< (as far as the index of the original recording is currently known).
+  const char *Error(void) { return error; }
+  };
+
+cCuttingReader::cCuttingReader(const char *FileName, bool IsPesRecording, cMarks *Marks, cCuttingQueue *Queue, volatile bool *ExtentCopy)
+:cThread("video cutting reader")
+{
+  error = NULL;
+  fileName = new cFileName(FileName, false, true, IsPesRecording);
+  index = new cIndexFile(FileName, false, IsPesRecording);
+  marks = Marks;
+  queue = Queue;
+  extentCopy = ExtentCopy;
+  file = NULL;
+  fileNumber = 0;
+  filePos = 0;
+}
+
+cCuttingReader::~cCuttingReader()
+{
+  Cancel(3);
+  delete fileName;
+  delete index;
+}
+
+int cCuttingReader::Frames(void)
+{
+  int Frames = 0;
+  for (cMark *Mark = marks->First(); Mark; Mark = marks->Next(Mark)) {
+      int CutIn = Mark->Position();
+      Mark = marks->Next(Mark);
+      int CutOut = Mark ? Mark->Position() : index->Last() + 1;
+      Frames += max(CutOut - CutIn, 0);
+      if (!Mark)
+         break;
+      }
+  return Frames;
+}
+
+bool cCuttingReader::Deliver(cCuttingChunk *Chunk)
+{
+  if (!Chunk->Extent()) {
+     if (!file || Chunk->FileNumber() != fileNumber || Chunk->FileOffset() != filePos) {
+        file = fileName->SetOffset(Chunk->FileNumber(), Chunk->FileOffset());
+        if (!file) {
+           error = "fromFile";
+           delete Chunk;
+           return false;
+           }
+        file->SetReadAhead(MEGABYTE(20));
+        fileNumber = Chunk->FileNumber();
+        }
+     if (!Chunk->Read(file)) {
+        error = "ReadFrame";
+        delete Chunk;
+        return false;
+        }
+     filePos = Chunk->FileOffset() + Chunk->TotalLength();
+     }
+  while (!queue->Put(Chunk, CUTTERQUEUEWAIT)) {
+        if (!Running()) {
+           delete Chunk;
+           return false;
+           }
+        }
+  return true;
+}
+
+void cCuttingReader::Action(void)
+{
+  SetPriority(19);
+  SetIOPriority(7);
+  cMark *Mark = marks->First();
+  while (Mark && Running()) {
+        // Determine the range of frames between this cut-in and the next cut-out:
+        int Index = Mark->Position();
+        int First = Index;
+        Mark = marks->Next(Mark);
+        int CutOut = Mark ? Mark->Position() : INT_MAX; // without a cut-out, the rest of the recording is copied
+        if (Mark)
+           Mark = marks->Next(Mark);
+        bool LastRange = !Mark;
+        bool CutIn = true; // the writer modifies the frames up to the first independent one
+        cCuttingChunk *Chunk = NULL;
+        while (Running()) {
+              // The cut-in frame is always delivered (even if the cut-out is at the
+              // same frame), because the writer only checks the marks after a frame:
+              if (Index > First && Index >= CutOut && !LastRange)
+                 break;
+              uint16_t FileNumber;
+              off_t FileOffset;
+              int Length;
+              bool Independent;
+              if (!index->Get(Index, &FileNumber, &FileOffset, &Independent, &Length)) {
+                 // Error, unless we're past the last cut-in and there's no cut-out
+                 if (CutOut != INT_MAX)
+                    error = "index";
+                 Mark = NULL;
+                 break;
+                 }
+              if (Index > First && Index >= CutOut && Independent)
+                 break; // edited version shall end before next I-frame
+              bool Extent = *extentCopy && !CutIn && Length >= 0;
+              if (CutIn && Independent)
+                 CutIn = false;
+              if (Chunk) {
+                 if (Chunk->FileNumber() != FileNumber || FileOffset != Chunk->FileOffset() + Chunk->TotalLength() || Chunk->Unbounded()
+                    || Extent != Chunk->Extent() || Chunk->TotalLength() >= (Chunk->Extent() ? MAXEXTENTCOPY : MAXREADCHUNK)) {
+                    if (!Deliver(Chunk)) {
+                       Chunk = NULL;
+                       Mark = NULL;
+                       break;
+                       }
+                    Chunk = NULL;
+                    }
+                 }
+              if (!Chunk)
+                 Chunk = new cCuttingChunk(FileNumber, FileOffset, Extent);
+              Chunk->AddFrame(Index++, Length, Independent);
+              }
+        if (Chunk && !(Running() && Deliver(Chunk)))
+           break;
+        if (error)
+           break;
+        }
+  queue->SetDone();
+}
+
 // --- cCuttingThread --------------------------------------------------------
 
 class cCuttingThread : public cThread {
 private:
   const char *error;
   bool isPesRecording;
-  cUnbufferedFile *fromFile, *toFile;
-  cFileName *fromFileName, *toFileName;
-  cIndexFile *fromIndex, *toIndex;
+  cUnbufferedFile *copyFile, *toFile;
+  cFileName *copyFileName, *toFileName;
+  cIndexFile *toIndex;
   cMarks fromMarks, toMarks;
   off_t maxVideoFileSize;
+  cCuttingQueue queue;
+  cCuttingReader *reader;
+  volatile bool extentCopy;
+  uchar *copyBuffer;
+  int frames;
+  int totalFrames;
+  off_t bytes;
+  cTimeMs timer;
+  time_t lastStats;
+  bool CopyExtent(cCuttingChunk *Chunk, off_t Offset, size_t Size, size_t &Buffered);
+       ///< Copies Size bytes, starting at Offset in the original file of Chunk,
+       ///< to toFile, without passing the data through user space if the file
+       ///< system supports this. Buffered is set to the number of bytes that had
+       ///< to be copied through the buffer. Returns false in case of an error.
+  bool Flush(cCuttingChunk *Chunk, int &First, int Last, off_t &Offset, off_t &FileSize, int &LastIFrame);
+       ///< Writes the frames First...Last - 1 of Chunk (which start at Offset in the
+       ///< chunk's data) to toFile in one go and adds their entries to toIndex.
+       ///< First, Offset, FileSize and LastIFrame are updated accordingly.
+  void Throttle(int Bytes);
+       ///< Waits as long as necessary to keep the data rate of all cutting threads
+       ///< together within Setup.CuttingBandwidth.
+  void LogStats(bool Final);
 protected:
   virtual void Action(void);
 public:
   cCuttingThread(const char *FromFileName, const char *ToFileName);
   virtual ~cCuttingThread();
   const char *Error(void) { return error; }
+  int Progress(void) { return totalFrames > 0 ? min(frames * 100 / totalFrames, 100) : 0; }
+       ///< Returns the percentage of the frames that have already been copied.
   };
 
 cCuttingThread::cCuttingThread(const char *FromFileName, const char *ToFileName)
 :cThread("video cutting")
 {
   error = NULL;
-  fromFile = toFile = NULL;
-  fromFileName = toFileName = NULL;
-  fromIndex = toIndex = NULL;
+  copyFile = toFile = NULL;
+  copyFileName = toFileName = NULL;
+  toIndex = NULL;
+  reader = NULL;
+  extentCopy = true;
+  copyBuffer = NULL;
+  frames = totalFrames = 0;
+  bytes = 0;
+  lastStats = 0;
   cRecording Recording(FromFileName);
   isPesRecording = Recording.IsPesRecording();
   if (fromMarks.Load(FromFileName, Recording.FramesPerSecond(), isPesRecording) && fromMarks.Count()) {
-     fromFileName = new cFileName(FromFileName, false, true, isPesRecording);
+     reader = new cCuttingReader(FromFileName, isPesRecording, &fromMarks, &queue, &extentCopy);
+     totalFrames = reader->Frames();
+     copyFileName = new cFileName(FromFileName, false, true, isPesRecording);
      toFileName = new cFileName(ToFileName, true, true, isPesRecording);
-     fromIndex = new cIndexFile(FromFileName, false, isPesRecording);
      toIndex = new cIndexFile(ToFileName, true, isPesRecording);
      toMarks.Load(ToFileName, Recording.FramesPerSecond(), isPesRecording); // doesn't actually load marks, just sets the file name
      maxVideoFileSize = MEGABYTE(Setup.MaxVideoFileSize);
@@ -59,10 +438,135 @@ cCuttingThread::cCuttingThread(const char *FromFileName, const char *ToFileName)
 cCuttingThread::~cCuttingThread()
 {
   Cancel(3);
-  delete fromFileName;
+  delete reader;
+  delete copyFileName;
   delete toFileName;
-  delete fromIndex;
   delete toIndex;
+  free(copyBuffer);
+}
+
+bool cCuttingThread::CopyExtent(cCuttingChunk *Chunk, off_t Offset, size_t Size, size_t &Buffered)
+{
+  Buffered = 0;
+  if (!copyFile || copyFileName->Number() != Chunk->FileNumber()) {
+     copyFile = copyFileName->SetOffset(Chunk->FileNumber(), Offset);
+     if (!copyFile) {
+        error = "fromFile";
+        return false;
+        }
+     }
+  if (extentCopy) {
+     ssize_t Copied = toFile->CopyFrom(copyFile, Offset, Size);
+     if (Copied == ssize_t(Size))
+        return true;
+     if (Copied >= 0) {
+        // A short copy is not an error - the rest goes through the buffer:
+        Offset += Copied;
+        Size -= Copied;
+        }
+     else if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) {
+        dsyslog("extent copy not possible (%m) - copying through buffer");
+        extentCopy = false;
+        }
+     else {
+        LOG_ERROR;
+        error = "CopyFrom";
+        return false;
+        }
+     }
+  // The file system can't copy extents, so we do it the conventional way:
+  if (!copyBuffer && !(copyBuffer = MALLOC(uchar, MAXREADCHUNK))) {
+     esyslog("ERROR: can't allocate cutting buffer");
+     error = "CopyFrom";
+     return false;
+     }
+  if (copyFile->Seek(Offset, SEEK_SET) != Offset) {
+     error = "fromFile";
+     return false;
+     }
+  Buffered = Size;
+  while (Size > 0) {
+        int n = copyFile->Read(copyBuffer, min(Size, size_t(MAXREADCHUNK)));
+        if (n <= 0) {
+           if (n < 0)
+              LOG_ERROR;
+           error = "ReadFrame";
+           return false;
+           }
+        if (toFile->Write(copyBuffer, n) < 0) {
+           error = "safe_write";
+           return false;
+           }
+        Size -= n;
+        }
+  return true;
+}
+
+bool cCuttingThread::Flush(cCuttingChunk *Chunk, int &First, int Last, off_t &Offset, off_t &FileSize, int &LastIFrame)
+{
+  if (First >= Last)
+     return true;
+  off_t Size = 0;
+  for (int i = First; i < Last; i++)
+      Size += Chunk->Length(i);
+  size_t Buffered = Size;
+  if (Chunk->Extent()) {
+     if (!CopyExtent(Chunk, Chunk->FileOffset() + Offset, Size, Buffered))
+        return false;
+     }
+  else if (toFile->Write(Chunk->Data() + Offset, Size) < 0) {
+     error = "safe_write";
+     return false;
+     }
+  for (int i = First; i < Last; i++) {
+      bool Independent = Chunk->Independent(i);
+      if (!toIndex->Write(Independent, toFileName->Number(), FileSize)) {
+         error = "toIndex";
+         return false;
+         }
+      FileSize += Chunk->Length(i);
+      if (Independent || !LastIFrame)
+         LastIFrame = toIndex->Last();
+      }
+  Offset += Size;
+  frames += Last - First;
+  bytes += Size;
+  First = Last;
+  Throttle(Buffered); // data copied by the file system itself doesn't count
+  return true;
+}
+
+static cMutex CuttingBudgetMutex;
+static uint64_t CuttingBudgetNext = 0; // the time (in ms) at which the next data may be written
+
+void cCuttingThread::Throttle(int Bytes)
+{
+  if (Setup.CuttingBandwidth <= 0 || Bytes <= 0)
+     return;
+  CuttingBudgetMutex.Lock();
+  uint64_t Now = cTimeMs::Now();
+  if (CuttingBudgetNext < Now)
+     CuttingBudgetNext = Now;
+  int Wait = CuttingBudgetNext - Now;
+  CuttingBudgetNext += uint64_t(Bytes) * 1000 / MEGABYTE(Setup.CuttingBandwidth);
+  CuttingBudgetMutex.Unlock();
+  while (Wait > 0 && Running()) {
+        cCondWait::SleepMs(min(Wait, CUTTERQUEUEWAIT));
+        Wait -= CUTTERQUEUEWAIT;
+        }
+}
+
+void cCuttingThread::LogStats(bool Final)
+{
+  if (!Final && time(NULL) - lastStats < CUTTERSTATSDELTA)
+     return;
+  lastStats = time(NULL);
+  double Seconds = max(timer.Elapsed(), uint64_t(1)) / 1000.0;
+  double MB = double(bytes) / MEGABYTE(1);
+  if (Final)
+     isyslog("editing: %d frames, %.1f MB in %.1fs (%.1f MB/s, %.0f frames/s)", frames, MB, Seconds, MB / Seconds, frames / Seconds);
+  else
+     dsyslog("editing: %d frames, %.1f MB (%.1f MB/s, %.0f frames/s)", frames, MB, MB / Seconds, frames / Seconds);
 }
 
 void cCuttingThread::Action(void)
@@ -71,213 +575,360 @@ void cCuttingThread::Action(void)
   if (Mark) {
      SetPriority(19);
      SetIOPriority(7);
-     fromFile = fromFileName->Open();
      toFile = toFileName->Open();
-     if (!fromFile || !toFile)
+     if (!toFile)
         return;
-     fromFile->SetReadAhead(MEGABYTE(20));
      int Index = Mark->Position();
      Mark = fromMarks.Next(Mark);
      off_t FileSize = 0;
-     int CurrentFileNumber = 0;
      int LastIFrame = 0;
      toMarks.Add(0);
      toMarks.Save();
-     uchar buffer[MAXFRAMESIZE];
      bool LastMark = false;
      bool cutIn = true;
-     while (Running()) {
-           uint16_t FileNumber;
-           off_t FileOffset;
-           int Length;
-           bool Independent;
+     bool Done = false;
+     timer.Set();
+     lastStats = time(NULL);
+     reader->Start();
+     while (Running() && !Done) {
+
+           // Fetch the next frames from the reader:
+
+           cCuttingChunk *Chunk = queue.Get(CUTTERQUEUEWAIT);
+           if (!Chunk) {
+              if (queue.Done()) {
+                 error = reader->Error();
+                 break;
+                 }
+              continue;
+              }
 
            // Make sure there is enough disk space:
 
            AssertFreeDiskSpace(-1);
 
-           // Read one frame:
+           // Write the frames, as many as possible in one go:
 
-           if (fromIndex->Get(Index++, &FileNumber, &FileOffset, &Independent, &Length)) {
-              if (FileNumber != CurrentFileNumber) {
-                 fromFile = fromFileName->SetOffset(FileNumber, FileOffset);
-                 if (fromFile)
-                    fromFile->SetReadAhead(MEGABYTE(20));
-                 CurrentFileNumber = FileNumber;
-                 }
-              if (fromFile) {
-                 int len = ReadFrame(fromFile, buffer,  Length, sizeof(buffer));
-                 if (len < 0) {
-                    error = "ReadFrame";
-                    break;
-                    }
-                 if (len != Length) {
-                    CurrentFileNumber = 0; // this re-syncs in case the frame was larger than the buffer
-                    Length = len;
-                    }
-                 }
-              else {
-                 error = "fromFile";
-                 break;
-                 }
-              }
-           else {
-              // Error, unless we're past the last cut-in and there's no cut-out
-              if (Mark || LastMark)
-                 error = "index";
-              break;
-              }
+           int First = 0;
+           int Last = Chunk->NumFrames();
+           off_t Offset = 0;
+           for (int i = 0; i < Last; i++) {
+               if (Chunk->Index(i) != Index) {
+                  esyslog("ERROR: cutter expected frame %d, got %d", Index, Chunk->Index(i));
+                  error = "reader";
+                  Done = true;
+                  break;
+                  }
+               Index++;
+               if (Chunk->Independent(i)) { // every file shall start with an independent frame
+                  if (LastMark) { // edited version shall end before next I-frame
+                     Last = i;
+                     Done = true;
+                     break;
+                     }
+                  off_t Pending = 0;
+                  for (int j = First; j < i; j++)
+                      Pending += Chunk->Length(j);
+                  if (FileSize + Pending > maxVideoFileSize) {
+                     if (!Flush(Chunk, First, i, Offset, FileSize, LastIFrame)) {
+                        Done = true;
+                        break;
+                        }
+                     toFile = toFileName->NextFile();
+                     if (!toFile) {
+                        error = "toFile 1";
+                        Done = true;
+                        break;
+                        }
+                     FileSize = 0;
+                     }
+                  LastIFrame = 0;
 
-           // Write one frame:
+                  if (cutIn) {
+                     if (uchar *Data = Chunk->Data()) {
+                        off_t o = Offset;
+                        for (int j = First; j < i; j++)
+                            o += Chunk->Length(j);
+                        if (isPesRecording)
+                           cRemux::SetBrokenLink(Data + o, Chunk->Length(i));
+                        else
+                           TsSetTeiOnBrokenPackets(Data + o, Chunk->Length(i));
+                        }
+                     cutIn = false;
+                     }
+                  }
 
-           if (Independent) { // every file shall start with an independent frame
-              if (LastMark) // edited version shall end before next I-frame
-                 break;
-              if (FileSize > maxVideoFileSize) {
-                 toFile = toFileName->NextFile();
-                 if (!toFile) {
-                    error = "toFile 1";
-                    break;
-                    }
-                 FileSize = 0;
-                 }
-              LastIFrame = 0;
-
-              if (cutIn) {
-                 if (isPesRecording)
-                    cRemux::SetBrokenLink(buffer, Length);
-                 else
-                    TsSetTeiOnBrokenPackets(buffer, Length);
-                 cutIn = false;
-                 }
-              }
-           if (toFile->Write(buffer, Length) < 0) {
-              error = "safe_write";
-              break;
-              }
-           if (!toIndex->Write(Independent, toFileName->Number(), FileSize)) {
-              error = "toIndex";
+               // Check editing marks:
+
+               if (Mark && Index >= Mark->Position()) {
+                  if (!Flush(Chunk, First, i + 1, Offset, FileSize, LastIFrame)) {
+                     Done = true;
+                     break;
+                     }
+                  Mark = fromMarks.Next(Mark);
+                  toMarks.Add(LastIFrame);
+                  if (Mark)
+                     toMarks.Add(toIndex->Last() + 1);
+                  toMarks.Save();
+                  if (Mark) {
+                     Index = Mark->Position();
+                     Mark = fromMarks.Next(Mark);
+                     cutIn = true;
+                     if (Setup.SplitEditedFiles) {
+                        toFile = toFileName->NextFile();
+                        if (!toFile) {
+                           error = "toFile 2";
+                           Done = true;
+                           break;
+                           }
+                        FileSize = 0;
+                        }
+                     }
+                  else
+                     LastMark = true;
+                  }
+               }
+           if (!error && !Flush(Chunk, First, Last, Offset, FileSize, LastIFrame))
+              Done = true;
+           delete Chunk;
+           if (error)
               break;
-              }
-           FileSize += Length;
-           if (!LastIFrame)
-              LastIFrame = toIndex->Last();
-
-           // Check editing marks:
-
-           if (Mark && Index >= Mark->Position()) {
-              Mark = fromMarks.Next(Mark);
-              toMarks.Add(LastIFrame);
-              if (Mark)
-                 toMarks.Add(toIndex->Last() + 1);
-              toMarks.Save();
-              if (Mark) {
-                 Index = Mark->Position();
-                 Mark = fromMarks.Next(Mark);
-                 CurrentFileNumber = 0; // triggers SetOffset before reading next frame
-                 cutIn = true;
-                 if (Setup.SplitEditedFiles) {
-                    toFile = toFileName->NextFile();
-                    if (!toFile) {
-                       error = "toFile 2";
-                       break;
-                       }
-                    FileSize = 0;
-                    }
-                 }
-              else
-                 LastMark = true;
-              }
+           LogStats(false);
            }
+     reader->Stop();
+     LogStats(true);
      Recordings.TouchUpdate();
      }
   else
      esyslog("no editing marks found!");
 }
 
-// --- cCutter ---------------------------------------------------------------
+// --- cCuttingJob -----------------------------------------------------------
 
-cMutex cCutter::mutex;
-cString cCutter::originalVersionName;
-cString cCutter::editedVersionName;
-cCuttingThread *cCutter::cuttingThread = NULL;
-bool cCutter::error = false;
-bool cCutter::ended = false;
+class cCuttingJob : public cListObject {
+private:
+  cString originalVersionName;
+  cString editedVersionName;
+  cCuttingThread *cuttingThread;
+  dev_t device;
+  const char *error;
+public:
+  cCuttingJob(const char *FileName);
+  virtual ~cCuttingJob();
+  bool Start(void);
+       ///< Prepares the directory of the edited version and starts the cutting thread.
+  void Stop(void);
+       ///< Stops the cutting thread. If it has been interrupted or ended with
+       ///< an error, the edited version is removed.
+  bool Started(void) { return cuttingThread != NULL; }
+  bool Finished(void) { return cuttingThread && !cuttingThread->Active(); }
+  bool Concerns(const char *FileName);
+  dev_t Device(void) { return device; }
+  const char *Error(void) { return error; }
+  const char *OriginalVersionName(void) { return originalVersionName; }
+  const char *EditedVersionName(void) { return editedVersionName; }
+  cString Status(void);
+  };
 
-bool cCutter::Start(const char *FileName)
+cCuttingJob::cCuttingJob(const char *FileName)
 {
-  cMutexLock MutexLock(&mutex);
-  if (!cuttingThread) {
-     error = false;
-     ended = false;
-     originalVersionName = FileName;
-     cRecording Recording(FileName);
+  originalVersionName = FileName;
+  cuttingThread = NULL;
+  error = NULL;
+  // Jobs on the same file system are run one after the other:
+  cRecording Recording(FileName);
+  cFileName fn(FileName, false, false, Recording.IsPesRecording());
+  struct stat st;
+  device = stat(fn.Name(), &st) == 0 || stat(FileName, &st) == 0 ? st.st_dev : 0;
+}
 
-     cMarks FromMarks;
-     FromMarks.Load(FileName, Recording.FramesPerSecond(), Recording.IsPesRecording());
-     if (cMark *First = FromMarks.First())
-        Recording.SetStartTime(Recording.Start() + (int(First->Position() / Recording.FramesPerSecond() + 30) / 60) * 60);
-
-     const char *evn = Recording.PrefixFileName('%');
-     if (evn && RemoveVideoFile(evn) && MakeDirs(evn, true)) {
-        // XXX this can be removed once RenameVideoFile() follows symlinks (see videodir.c)
-        // remove a possible deleted recording with the same name to avoid symlink mixups:
-        char *s = strdup(evn);
-        char *e = strrchr(s, '.');
-        if (e) {
-           if (strcmp(e, ".rec") == 0) {
-              strcpy(e, ".del");
-              RemoveVideoFile(s);
-              }
+cCuttingJob::~cCuttingJob()
+{
+  Stop();
+}
+
+bool cCuttingJob::Start(void)
+{
+  cRecording Recording(originalVersionName);
+
+  cMarks FromMarks;
+  FromMarks.Load(originalVersionName, Recording.FramesPerSecond(), Recording.IsPesRecording());
+  if (cMark *First = FromMarks.First())
+     Recording.SetStartTime(Recording.Start() + (int(First->Position() / Recording.FramesPerSecond() + 30) / 60) * 60);
+
+  const char *evn = Recording.PrefixFileName('%');
+  if (evn && RemoveVideoFile(evn) && MakeDirs(evn, true)) {
+     // XXX this can be removed once RenameVideoFile() follows symlinks (see videodir.c)
+     // remove a possible deleted recording with the same name to avoid symlink mixups:
+     char *s = strdup(evn);
+     char *e = strrchr(s, '.');
+     if (e) {
+        if (strcmp(e, ".rec") == 0) {
+           strcpy(e, ".del");
+           RemoveVideoFile(s);
            }
-        free(s);
-        // XXX
-        editedVersionName = evn;
-        Recording.WriteInfo();
-        Recordings.AddByName(editedVersionName, false);
-        cuttingThread = new cCuttingThread(FileName, editedVersionName);
-        return true;
         }
+     free(s);
+     // XXX
+     editedVersionName = evn;
+     Recording.WriteInfo();
+     Recordings.AddByName(editedVersionName, false);
+     cuttingThread = new cCuttingThread(originalVersionName, editedVersionName);
+     return true;
      }
   return false;
 }
 
-void cCutter::Stop(void)
+void cCuttingJob::Stop(void)
 {
-  cMutexLock MutexLock(&mutex);
   bool Interrupted = cuttingThread && cuttingThread->Active();
-  const char *Error = cuttingThread ? cuttingThread->Error() : NULL;
+  error = cuttingThread ? cuttingThread->Error() : NULL;
   delete cuttingThread;
   cuttingThread = NULL;
-  if ((Interrupted || Error) && *editedVersionName) {
+  if ((Interrupted || error) && *editedVersionName) {
      if (Interrupted)
         isyslog("editing process has been interrupted");
-     if (Error)
-        esyslog("ERROR: '%s' during editing process", Error);
+     if (error)
+        esyslog("ERROR: '%s' during editing process", error);
      if (cReplayControl::NowReplaying() && strcmp(cReplayControl::NowReplaying(), editedVersionName) == 0)
         cControl::Shutdown();
      RemoveVideoFile(editedVersionName);
      Recordings.DelByName(editedVersionName);
+     editedVersionName = NULL;
      }
 }
 
+bool cCuttingJob::Concerns(const char *FileName)
+{
+  return strcmp(FileName, originalVersionName) == 0 || *editedVersionName && strcmp(FileName, editedVersionName) == 0;
+}
+
+cString cCuttingJob::Status(void)
+{
+  if (cuttingThread)
+     return cString::sprintf("running %d%% %s", cuttingThread->Progress(), *originalVersionName);
+  return cString::sprintf("waiting %s", *originalVersionName);
+}
+
+// --- cCutter ---------------------------------------------------------------
+
+cMutex cCutter::mutex;
+cList<cCuttingJob> cCutter::jobs;
+bool cCutter::error = false;
+bool cCutter::ended = false;
+
+void cCutter::Manage(void)
+{
+  // Clean up finished jobs:
+  for (cCuttingJob *Job = jobs.First(); Job; ) {
+      cCuttingJob *Next = jobs.Next(Job);
+      if (Job->Finished()) {
+         Job->Stop();
+         if (Job->Error())
+            error = true;
+         else
+            cRecordingUserCommand::InvokeCommand(RUC_EDITEDRECORDING, Job->EditedVersionName());
+         ended = true;
+         jobs.Del(Job);
+         }
+      Job = Next;
+      }
+  // Start waiting jobs:
+  int Running = 0;
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job)) {
+      if (Job->Started())
+         Running++;
+      }
+  for (cCuttingJob *Job = jobs.First(); Job && Running < Setup.MaxCuttingJobs; ) {
+      cCuttingJob *Next = jobs.Next(Job);
+      if (!Job->Started()) {
+         bool Busy = false;
+         for (cCuttingJob *j = jobs.First(); j; j = jobs.Next(j)) {
+             if (j->Started() && j->Device() == Job->Device()) {
+                Busy = true;
+                break;
+                }
+             }
+         if (!Busy) {
+            if (Job->Start())
+               Running++;
+            else {
+               esyslog("ERROR: can't start editing process for %s", Job->OriginalVersionName());
+               error = true;
+               ended = true;
+               jobs.Del(Job);
+               }
+            }
+         }
+      Job = Next;
+      }
+}
+
+bool cCutter::Start(const char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job)) {
+      if (Job->Concerns(FileName))
+         return false;
+      }
+  cRecording Recording(FileName);
+  cMarks Marks;
+  if (!Marks.Load(FileName, Recording.FramesPerSecond(), Recording.IsPesRecording()) || !Marks.Count())
+     return false;
+  cCuttingJob *Job = new cCuttingJob(FileName);
+  jobs.Add(Job);
+  Manage();
+  for (cCuttingJob *j = jobs.First(); j; j = jobs.Next(j)) {
+      if (j == Job) {
+         if (!Job->Started())
+            isyslog("editing of %s has been queued", FileName);
+         return true;
+         }
+      }
+  return false; // couldn't be started
+}
+
+void cCutter::Stop(const char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cCuttingJob *Job = jobs.First(); Job; ) {
+      cCuttingJob *Next = jobs.Next(Job);
+      if (!FileName || Job->Concerns(FileName))
+         jobs.Del(Job);
+      Job = Next;
+      }
+  Manage();
+}
+
 bool cCutter::Active(const char *FileName)
 {
   cMutexLock MutexLock(&mutex);
-  if (cuttingThread) {
-     if (cuttingThread->Active())
-        return !FileName || strcmp(FileName, originalVersionName) == 0 || strcmp(FileName, editedVersionName) == 0;
-     error = cuttingThread->Error();
-     Stop();
-     if (!error)
-        cRecordingUserCommand::InvokeCommand(RUC_EDITEDRECORDING, editedVersionName);
-     originalVersionName = NULL;
-     editedVersionName = NULL;
-     ended = true;
-     }
+  Manage();
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job)) {
+      if (!FileName || Job->Concerns(FileName))
+         return true;
+      }
   return false;
 }
 
+bool cCutter::Waiting(const char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job)) {
+      if (Job->Concerns(FileName))
+         return !Job->Started();
+      }
+  return false;
+}
+
+int cCutter::Status(cStringList &Status)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job))
+      Status.Append(strdup(Job->Status()));
+  return jobs.Count();
+}
+
 bool cCutter::Error(void)
 {
   cMutexLock MutexLock(&mutex);
@@ -13,23 +13,42 @@
 #include "thread.h"
 #include "tools.h"
 
-class cCuttingThread;
+#define MAXCUTTINGJOBS 8 // max. number of editing processes running at the same time
+
+class cCuttingJob;
 
 class cCutter {
 private:
   static cMutex mutex;
-  static cString originalVersionName;
-  static cString editedVersionName;
-  static cCuttingThread *cuttingThread;
+  static cList<cCuttingJob> jobs;
   static bool error;
   static bool ended;
+  static void Manage(void);
+         ///< Cleans up finished jobs and starts waiting ones, as far as
+         ///< Setup.MaxCuttingJobs allows. Jobs that work on the same file
+         ///< system are never run at the same time.
 public:
   static bool Start(const char *FileName);
-  static void Stop(void);
+         ///< Queues the recording with the given FileName for editing and
+         ///< starts the editing process right away if possible.
+         ///< Returns false if the recording has no editing marks, is already
+         ///< queued or being edited, or if the editing process could not be
+         ///< started.
+  static void Stop(const char *FileName = NULL);
+         ///< Stops and removes the editing job that works on the given FileName
+         ///< (either as the original or the edited version), or all jobs if no
+         ///< FileName is given.
   static bool Active(const char *FileName = NULL);
          ///< Returns true if the cutter is currently active.
          ///< If a FileName is given, true is only returned if either the
-         ///< original or the edited file name is equal to FileName.
+         ///< original or the edited file name of a running or queued job
+         ///< is equal to FileName.
+  static bool Waiting(const char *FileName);
+         ///< Returns true if the job for the given FileName has been queued,
+         ///< but not yet started.
+  static int Status(cStringList &Status);
+         ///< Appends a line describing each job ("running <progress>% <file name>"
+         ///< or "waiting <file name>") to Status and returns the number of jobs.
   static bool Error(void);
   static bool Ended(void);
   };
@@ -19,17 +19,294 @@
 
 #define VALID_TIME (31536000 * 2) // two years
 
+// --- cEitEvent -------------------------------------------------------------
+
+// The information from the descriptors of an EIT event that can be decoded
+// without access to the schedules and channels. The EIT decoder threads do
+// this before they lock the schedules.
+
+class cEitEvent {
+public:
+  bool decode; // false if the event is known to be unchanged
+  bool decoded;
+  char *title;
+  char *shortText;
+  char *description;
+  uchar contents[MaxEventContents];
+  bool hasContents;
+  int parentalRating;
+  bool hasParentalRating;
+  time_t vps;
+  bool hasVps;
+  cComponents *components;
+  int referenceServiceId;
+  int referenceEventId;
+  bool hasReference;
+  bool hasLinkage;
+  cEitEvent(void);
+  ~cEitEvent();
+  void Decode(SI::EIT::Event &SiEitEvent, const struct tm &Now);
+       ///< Decodes the descriptors of the given SiEitEvent. Now is the current
+       ///< local time, which is needed for handling PDC descriptors.
+  };
+
+cEitEvent::cEitEvent(void)
+{
+  decode = true;
+  decoded = false;
+  title = NULL;
+  shortText = NULL;
+  description = NULL;
+  memset(contents, 0, sizeof(contents));
+  hasContents = false;
+  parentalRating = 0;
+  hasParentalRating = false;
+  vps = 0;
+  hasVps = false;
+  components = NULL;
+  referenceServiceId = 0;
+  referenceEventId = 0;
+  hasReference = false;
+  hasLinkage = false;
+}
+
+cEitEvent::~cEitEvent()
+{
+  free(title);
+  free(shortText);
+  free(description);
+  delete components;
+}
+
+void cEitEvent::Decode(SI::EIT::Event &SiEitEvent, const struct tm &Now)
+{
+  int LanguagePreferenceShort = -1;
+  int LanguagePreferenceExt = -1;
+  bool UseExtendedEventDescriptor = false;
+  // The descriptors are set up on the stack, without allocating anything:
+  SI::DescriptorView d;
+  SI::ExtendedEventDescriptor ExtendedEventDescriptor[16]; // indexed by the descriptor number
+  SI::ExtendedEventDescriptors ExtendedEventDescriptors(false);
+  bool HasExtendedEventDescriptors = false;
+  SI::ShortEventDescriptor ShortEventDescriptor;
+  bool HasShortEventDescriptor = false;
+  for (SI::Loop::Iterator it2; SiEitEvent.eventDescriptors.getNext(d, it2); ) {
+      switch (d.getDescriptorTag()) {
+        case SI::ExtendedEventDescriptorTag: {
+             SI::ExtendedEventDescriptor eed;
+             d.get(eed);
+             if (I18nIsPreferredLanguage(Setup.EPGLanguages, eed.languageCode, LanguagePreferenceExt) || !HasExtendedEventDescriptors) {
+                ExtendedEventDescriptors.Clear();
+                HasExtendedEventDescriptors = true;
+                UseExtendedEventDescriptor = true;
+                }
+             if (UseExtendedEventDescriptor) {
+                SI::ExtendedEventDescriptor &e = ExtendedEventDescriptor[eed.getDescriptorNumber() & 0x0F];
+                e = eed;
+                ExtendedEventDescriptors.Add(&e);
+                }
+             if (eed.getDescriptorNumber() == eed.getLastDescriptorNumber())
+                UseExtendedEventDescriptor = false;
+             }
+             break;
+        case SI::ShortEventDescriptorTag: {
+             SI::ShortEventDescriptor sed;
+             d.get(sed);
+             if (I18nIsPreferredLanguage(Setup.EPGLanguages, sed.languageCode, LanguagePreferenceShort) || !HasShortEventDescriptor) {
+                ShortEventDescriptor = sed;
+                HasShortEventDescriptor = true;
+                }
+             }
+             break;
+        case SI::ContentDescriptorTag: {
+             SI::ContentDescriptor cd;
+             d.get(cd);
+             SI::ContentDescriptor::Nibble Nibble;
+             int NumContents = 0;
+             memset(contents, 0, sizeof(contents));
+             for (SI::Loop::Iterator it3; cd.nibbleLoop.getNext(Nibble, it3); ) {
+                 if (NumContents < MaxEventContents) {
+                    contents[NumContents] = ((Nibble.getContentNibbleLevel1() & 0xF) << 4) | (Nibble.getContentNibbleLevel2() & 0xF);
+                    NumContents++;
+                    }
+                 }
+             hasContents = true;
+             }
+             break;
+        case SI::ParentalRatingDescriptorTag: {
+             int LanguagePreferenceRating = -1;
+             SI::ParentalRatingDescriptor prd;
+             d.get(prd);
+             SI::ParentalRatingDescriptor::Rating Rating;
+             for (SI::Loop::Iterator it3; prd.ratingLoop.getNext(Rating, it3); ) {
+                 if (I18nIsPreferredLanguage(Setup.EPGLanguages, Rating.languageCode, LanguagePreferenceRating)) {
+                    int ParentalRating = (Rating.getRating() & 0xFF);
+                    switch (ParentalRating) {
+                      // values defined by the DVB standard (minimum age = rating + 3 years):
+                      case 0x01 ... 0x0F: ParentalRating += 3; break;
+                      // values defined by broadcaster CSAT (now why didn't they just use 0x07, 0x09 and 0x0D?):
+                      case 0x11:          ParentalRating = 10; break;
+                      case 0x12:          ParentalRating = 12; break;
+                      case 0x13:          ParentalRating = 16; break;
+                      default:            ParentalRating = 0;
+                      }
+                    parentalRating = ParentalRating;
+                    hasParentalRating = true;
+                    }
+                 }
+             }
+             break;
+        case SI::PDCDescriptorTag: {
+             SI::PDCDescriptor pd;
+             d.get(pd);
+             struct tm t = Now;
+             t.tm_isdst = -1; // makes sure mktime() will determine the correct DST setting
+             int month = t.tm_mon;
+             t.tm_mon = pd.getMonth() - 1;
+             t.tm_mday = pd.getDay();
+             t.tm_hour = pd.getHour();
+             t.tm_min = pd.getMinute();
+             t.tm_sec = 0;
+             if (month == 11 && t.tm_mon == 0) // current month is dec, but event is in jan
+                t.tm_year++;
+             else if (month == 0 && t.tm_mon == 11) // current month is jan, but event is in dec
+                t.tm_year--;
+             vps = mktime(&t);
+             hasVps = true;
+             }
+             break;
+        case SI::TimeShiftedEventDescriptorTag: {
+             SI::TimeShiftedEventDescriptor tsed;
+             d.get(tsed);
+             referenceServiceId = tsed.getReferenceServiceId();
+             referenceEventId = tsed.getReferenceEventId();
+             hasReference = true;
+             }
+             break;
+        case SI::LinkageDescriptorTag:
+             hasLinkage = true; // these need the channels, so they are handled in cEIT
+             break;
+        case SI::ComponentDescriptorTag: {
+             SI::ComponentDescriptor cd;
+             d.get(cd);
+             uchar Stream = cd.getStreamContent();
+             uchar Type = cd.getComponentType();
+             if (1 <= Stream && Stream <= 6 && Type != 0) { // 1=MPEG2-video, 2=MPEG1-audio, 3=subtitles, 4=AC3-audio, 5=H.264-video, 6=HEAAC-audio
+                if (!components)
+                   components = new cComponents;
+                char buffer[Utf8BufSize(256)];
+                components->SetComponent(components->NumComponents(), Stream, Type, I18nNormalizeLanguageCode(cd.languageCode), cd.description.getText(buffer, sizeof(buffer)));
+                }
+             }
+             break;
+        default: ;
+        }
+      }
+  if (HasShortEventDescriptor) {
+     char buffer[Utf8BufSize(256)];
+     title = strdup(ShortEventDescriptor.name.getText(buffer, sizeof(buffer)));
+     shortText = strdup(ShortEventDescriptor.text.getText(buffer, sizeof(buffer)));
+     }
+  if (HasExtendedEventDescriptors) {
+     char buffer[Utf8BufSize(ExtendedEventDescriptors.getMaximumTextLength(": ")) + 1];
+     description = strdup(ExtendedEventDescriptors.getText(buffer, sizeof(buffer), ": "));
+     }
+  decoded = true;
+}
+
+// --- cEitEvents ------------------------------------------------------------
+
+class cEitEvents {
+private:
+  int numEvents;
+  cEitEvent *events;
+public:
+  cEitEvents(void);
+  ~cEitEvents();
+  void Decode(int Source, u_char Tid, SI::EIT &Eit);
+       ///< Decodes all events of the given (already parsed) Eit section, except
+       ///< for those that are known to be unchanged. The schedules are only
+       ///< locked for looking up the known events, not for decoding.
+  cEitEvent *Get(int Index) { return Index < numEvents ? &events[Index] : NULL; }
+  };
+
+cEitEvents::cEitEvents(void)
+{
+  numEvents = 0;
+  events = NULL;
+}
+
+cEitEvents::~cEitEvents()
+{
+  delete[] events;
+}
+
+void cEitEvents::Decode(int Source, u_char Tid, SI::EIT &Eit)
+{
+  SI::EIT::Event SiEitEvent;
+  for (SI::Loop::Iterator it; Eit.eventLoop.getNext(SiEitEvent, it); )
+      numEvents++;
+  if (!numEvents)
+     return;
+  events = new cEitEvent[numEvents];
+  // Events we already have with the same or a more "current" version are skipped
+  // by cEIT anyway (see there), so there's no need to decode them here:
+  {
+    cSchedulesLock SchedulesLock(false, 10);
+    const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
+    if (Schedules && Channels.Lock(false, 10)) {
+       cChannel *channel = Channels.GetByChannelID(tChannelID(Source, Eit.getOriginalNetworkId(), Eit.getTransportStreamId(), Eit.getServiceId()), true);
+       const cSchedule *Schedule = channel ? Schedules->GetSchedule(channel) : NULL;
+       if (Schedule) {
+          int Index = 0;
+          for (SI::Loop::Iterator it; Eit.eventLoop.getNext(SiEitEvent, it) && Index < numEvents; Index++) {
+              const cEvent *Event = Schedule->GetEvent(SiEitEvent.getEventId(), SiEitEvent.getStartTime());
+              if (Event) {
+                 uchar TableID = max(Event->TableID(), uchar(0x4E));
+                 if (Tid > TableID || Tid == TableID && Event->Version() == Eit.getVersionNumber())
+                    events[Index].decode = false;
+                 }
+              }
+          }
+       Channels.Unlock();
+       }
+  }
+  time_t Now = time(NULL);
+  struct tm tm_r;
+  struct tm t = *localtime_r(&Now, &tm_r);
+  int Index = 0;
+  for (SI::Loop::Iterator it; Eit.eventLoop.getNext(SiEitEvent, it) && Index < numEvents; Index++) {
+      if (events[Index].decode)
+         events[Index].Decode(SiEitEvent, t);
+      }
+}
+
 // --- cEIT ------------------------------------------------------------------
 
 class cEIT : public SI::EIT {
+private:
+  bool processed;
 public:
-  cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bool OnlyRunningStatus = false);
+  cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bool OnlyRunningStatus = false, bool OnlySeen = false, cEitEvents *Events = NULL);
+       ///< If OnlySeen is true, the section is known to be the same as one that
+       ///< has already been processed, so its events are only marked as 'seen'.
+       ///< Events may contain the already decoded events of this section, in
+       ///< which case its CRC is known to be correct.
+  bool Processed(void) const { return processed; }
+       ///< Returns true if all events of the section have been handled (always
+       ///< false if OnlyRunningStatus was true).
   };
 
-cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bool OnlyRunningStatus)
+cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bool OnlyRunningStatus, bool OnlySeen, cEitEvents *Events)
 :SI::EIT(Data, false)
 {
-  if (!CheckCRCAndParse())
+  processed = false;
+  if (OnlySeen || Events) {
+     CheckParse(); // the CRC has already been checked
+     if (!isValid())
+        return;
+     }
+  else if (!CheckCRCAndParse())
      return;
 
   time_t Now = time(NULL);
@@ -45,7 +322,11 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
      return;
      }
 
-  cSchedule *pSchedule = (cSchedule *)Schedules->GetSchedule(channel, true);
+  cSchedule *pSchedule = (cSchedule *)Schedules->GetSchedule(channel, !OnlySeen);
+  if (!pSchedule) {
+     Channels.Unlock();
+     return;
+     }
 
   bool Empty = true;
   bool Modified = false;
@@ -54,9 +335,10 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
   struct tm tm_r;
   struct tm t = *localtime_r(&Now, &tm_r); // this initializes the time zone in 't'
 
+  int Index = 0;
   SI::EIT::Event SiEitEvent;
-  for (SI::Loop::Iterator it; eventLoop.getNext(SiEitEvent, it); ) {
-      if (EpgHandlers.HandleEitEvent(pSchedule, &SiEitEvent, Tid, getVersionNumber()))
+  for (SI::Loop::Iterator it; eventLoop.getNext(SiEitEvent, it); Index++) {
+      if (!OnlySeen && EpgHandlers.HandleEitEvent(pSchedule, &SiEitEvent, Tid, getVersionNumber()))
          continue; // an EPG handler has done all of the processing
       time_t StartTime = SiEitEvent.getStartTime();
       int Duration = SiEitEvent.getDuration();
@@ -73,6 +355,10 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
       if (!pEvent) {
          if (OnlyRunningStatus)
             continue;
+         if (OnlySeen) {
+            Channels.Unlock(); // the event has been deleted in the meantime, so the section needs to be processed again
+            return;
+            }
          // If we don't have that event yet, we create a new one.
          // Otherwise we copy the information into the existing event anyway, because the data might have changed.
          pEvent = newEvent = new cEvent(SiEitEvent.getEventId());
@@ -96,6 +382,10 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
          // to the Sat.1/Pro7 transponder, events will keep toggling because of the bogus version numbers.
          else if (Tid == TableID && pEvent->Version() == getVersionNumber())
             continue;
+         if (OnlySeen) {
+            Channels.Unlock(); // the event has been changed from some other section in the meantime
+            return;
+            }
          EpgHandlers.SetEventID(pEvent, SiEitEvent.getEventId()); // unfortunately some stations use different event ids for the same event in different tables :-(
          EpgHandlers.SetStartTime(pEvent, StartTime);
          EpgHandlers.SetDuration(pEvent, Duration);
@@ -112,178 +402,74 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
          }
       pEvent->SetVersion(getVersionNumber());
 
-      int LanguagePreferenceShort = -1;
-      int LanguagePreferenceExt = -1;
-      bool UseExtendedEventDescriptor = false;
-      SI::Descriptor *d;
-      SI::ExtendedEventDescriptors *ExtendedEventDescriptors = NULL;
-      SI::ShortEventDescriptor *ShortEventDescriptor = NULL;
-      cLinkChannels *LinkChannels = NULL;
-      cComponents *Components = NULL;
-      for (SI::Loop::Iterator it2; (d = SiEitEvent.eventDescriptors.getNext(it2)); ) {
-          switch (d->getDescriptorTag()) {
-            case SI::ExtendedEventDescriptorTag: {
-                 SI::ExtendedEventDescriptor *eed = (SI::ExtendedEventDescriptor *)d;
-                 if (I18nIsPreferredLanguage(Setup.EPGLanguages, eed->languageCode, LanguagePreferenceExt) || !ExtendedEventDescriptors) {
-                    delete ExtendedEventDescriptors;
-                    ExtendedEventDescriptors = new SI::ExtendedEventDescriptors;
-                    UseExtendedEventDescriptor = true;
-                    }
-                 if (UseExtendedEventDescriptor) {
-                    ExtendedEventDescriptors->Add(eed);
-                    d = NULL; // so that it is not deleted
-                    }
-                 if (eed->getDescriptorNumber() == eed->getLastDescriptorNumber())
-                    UseExtendedEventDescriptor = false;
-                 }
-                 break;
-            case SI::ShortEventDescriptorTag: {
-                 SI::ShortEventDescriptor *sed = (SI::ShortEventDescriptor *)d;
-                 if (I18nIsPreferredLanguage(Setup.EPGLanguages, sed->languageCode, LanguagePreferenceShort) || !ShortEventDescriptor) {
-                    delete ShortEventDescriptor;
-                    ShortEventDescriptor = sed;
-                    d = NULL; // so that it is not deleted
-                    }
-                 }
-                 break;
-            case SI::ContentDescriptorTag: {
-                 SI::ContentDescriptor *cd = (SI::ContentDescriptor *)d;
-                 SI::ContentDescriptor::Nibble Nibble;
-                 int NumContents = 0;
-                 uchar Contents[MaxEventContents] = { 0 };
-                 for (SI::Loop::Iterator it3; cd->nibbleLoop.getNext(Nibble, it3); ) {
-                     if (NumContents < MaxEventContents) {
-                        Contents[NumContents] = ((Nibble.getContentNibbleLevel1() & 0xF) << 4) | (Nibble.getContentNibbleLevel2() & 0xF);
-                        NumContents++;
-                        }
-                     }
-                 EpgHandlers.SetContents(pEvent, Contents);
-                 }
-                 break;
-            case SI::ParentalRatingDescriptorTag: {
-                 int LanguagePreferenceRating = -1;
-                 SI::ParentalRatingDescriptor *prd = (SI::ParentalRatingDescriptor *)d;
-                 SI::ParentalRatingDescriptor::Rating Rating;
-                 for (SI::Loop::Iterator it3; prd->ratingLoop.getNext(Rating, it3); ) {
-                     if (I18nIsPreferredLanguage(Setup.EPGLanguages, Rating.languageCode, LanguagePreferenceRating)) {
-                        int ParentalRating = (Rating.getRating() & 0xFF);
-                        switch (ParentalRating) {
-                          // values defined by the DVB standard (minimum age = rating + 3 years):
-                          case 0x01 ... 0x0F: ParentalRating += 3; break;
-                          // values defined by broadcaster CSAT (now why didn't they just use 0x07, 0x09 and 0x0D?):
-                          case 0x11:          ParentalRating = 10; break;
-                          case 0x12:          ParentalRating = 12; break;
-                          case 0x13:          ParentalRating = 16; break;
-                          default:            ParentalRating = 0;
-                          }
-                        EpgHandlers.SetParentalRating(pEvent, ParentalRating);
-                        }
-                     }
-                 }
-                 break;
-            case SI::PDCDescriptorTag: {
-                 SI::PDCDescriptor *pd = (SI::PDCDescriptor *)d;
-                 t.tm_isdst = -1; // makes sure mktime() will determine the correct DST setting
-                 int month = t.tm_mon;
-                 t.tm_mon = pd->getMonth() - 1;
-                 t.tm_mday = pd->getDay();
-                 t.tm_hour = pd->getHour();
-                 t.tm_min = pd->getMinute();
-                 t.tm_sec = 0;
-                 if (month == 11 && t.tm_mon == 0) // current month is dec, but event is in jan
-                    t.tm_year++;
-                 else if (month == 0 && t.tm_mon == 11) // current month is jan, but event is in dec
-                    t.tm_year--;
-                 time_t vps = mktime(&t);
-                 EpgHandlers.SetVps(pEvent, vps);
-                 }
-                 break;
-            case SI::TimeShiftedEventDescriptorTag: {
-                 SI::TimeShiftedEventDescriptor *tsed = (SI::TimeShiftedEventDescriptor *)d;
-                 cSchedule *rSchedule = (cSchedule *)Schedules->GetSchedule(tChannelID(Source, channel->Nid(), channel->Tid(), tsed->getReferenceServiceId()));
-                 if (!rSchedule)
-                    break;
-                 rEvent = (cEvent *)rSchedule->GetEvent(tsed->getReferenceEventId());
-                 if (!rEvent)
-                    break;
-                 EpgHandlers.SetTitle(pEvent, rEvent->Title());
-                 EpgHandlers.SetShortText(pEvent, rEvent->ShortText());
-                 EpgHandlers.SetDescription(pEvent, rEvent->Description());
-                 }
-                 break;
-            case SI::LinkageDescriptorTag: {
-                 SI::LinkageDescriptor *ld = (SI::LinkageDescriptor *)d;
-                 tChannelID linkID(Source, ld->getOriginalNetworkId(), ld->getTransportStreamId(), ld->getServiceId());
-                 if (ld->getLinkageType() == 0xB0) { // Premiere World
-                    bool hit = StartTime <= Now && Now < StartTime + Duration;
-                    if (hit) {
-                       char linkName[ld->privateData.getLength() + 1];
-                       strn0cpy(linkName, (const char *)ld->privateData.getData(), sizeof(linkName));
-                       // TODO is there a standard way to determine the character set of this string?
-                       cChannel *link = Channels.GetByChannelID(linkID);
-                       if (link != channel) { // only link to other channels, not the same one
-                          //fprintf(stderr, "Linkage %s %4d %4d %5d %5d %5d %5d  %02X  '%s'\n", hit ? "*" : "", channel->Number(), link ? link->Number() : -1, SiEitEvent.getEventId(), ld->getOriginalNetworkId(), ld->getTransportStreamId(), ld->getServiceId(), ld->getLinkageType(), linkName);//XXX
-                          if (link) {
-                             if (Setup.UpdateChannels == 1 || Setup.UpdateChannels >= 3)
-                                link->SetName(linkName, "", "");
-                             }
-                          else if (Setup.UpdateChannels >= 4) {
-                             cChannel *transponder = channel;
-                             if (channel->Tid() != ld->getTransportStreamId())
-                                transponder = Channels.GetByTransponderID(linkID);
-                             link = Channels.NewChannel(transponder, linkName, "", "", ld->getOriginalNetworkId(), ld->getTransportStreamId(), ld->getServiceId());
-                             //XXX patFilter->Trigger();
-                             }
-                          if (link) {
-                             if (!LinkChannels)
-                                LinkChannels = new cLinkChannels;
-                             LinkChannels->Add(new cLinkChannel(link));
-                             }
-                          }
-                       else
-                          channel->SetPortalName(linkName);
-                       }
-                    }
-                 }
-                 break;
-            case SI::ComponentDescriptorTag: {
-                 SI::ComponentDescriptor *cd = (SI::ComponentDescriptor *)d;
-                 uchar Stream = cd->getStreamContent();
-                 uchar Type = cd->getComponentType();
-                 if (1 <= Stream && Stream <= 6 && Type != 0) { // 1=MPEG2-video, 2=MPEG1-audio, 3=subtitles, 4=AC3-audio, 5=H.264-video, 6=HEAAC-audio
-                    if (!Components)
-                       Components = new cComponents;
-                    char buffer[Utf8BufSize(256)];
-                    Components->SetComponent(Components->NumComponents(), Stream, Type, I18nNormalizeLanguageCode(cd->languageCode), cd->description.getText(buffer, sizeof(buffer)));
-                    }
-                 }
-                 break;
-            default: ;
+      cEitEvent LocalEitEvent;
+      cEitEvent *EitEvent = Events ? Events->Get(Index) : NULL;
+      if (!EitEvent)
+         EitEvent = &LocalEitEvent;
+      if (!EitEvent->decoded)
+         EitEvent->Decode(SiEitEvent, t);
+      if (EitEvent->hasContents)
+         EpgHandlers.SetContents(pEvent, EitEvent->contents);
+      if (EitEvent->hasParentalRating)
+         EpgHandlers.SetParentalRating(pEvent, EitEvent->parentalRating);
+      if (EitEvent->hasVps)
+         EpgHandlers.SetVps(pEvent, EitEvent->vps);
+      if (EitEvent->hasReference) {
+         cSchedule *rSchedule = (cSchedule *)Schedules->GetSchedule(tChannelID(Source, channel->Nid(), channel->Tid(), EitEvent->referenceServiceId));
+         if (rSchedule)
+            rEvent = (cEvent *)rSchedule->GetEvent(EitEvent->referenceEventId);
+         if (rEvent) {
+            EpgHandlers.SetTitle(pEvent, rEvent->Title());
+            EpgHandlers.SetShortText(pEvent, rEvent->ShortText());
+            EpgHandlers.SetDescription(pEvent, rEvent->Description());
             }
-          delete d;
-          }
-
+         }
+      cLinkChannels *LinkChannels = NULL;
+      if (EitEvent->hasLinkage) {
+         SI::DescriptorView d;
+         for (SI::Loop::Iterator it2; SiEitEvent.eventDescriptors.getNext(d, it2, SI::LinkageDescriptorTag); ) {
+             SI::LinkageDescriptor ld;
+             d.get(ld);
+             tChannelID linkID(Source, ld.getOriginalNetworkId(), ld.getTransportStreamId(), ld.getServiceId());
+             if (ld.getLinkageType() == 0xB0) { // Premiere World
+                bool hit = StartTime <= Now && Now < StartTime + Duration;
+                if (hit) {
+                   char linkName[ld.privateData.getLength() + 1];
+                   strn0cpy(linkName, (const char *)ld.privateData.getData(), sizeof(linkName));
+                   // TODO is there a standard way to determine the character set of this string?
+                   cChannel *link = Channels.GetByChannelID(linkID);
+                   if (link != channel) { // only link to other channels, not the same one
+                      //fprintf(stderr, "Linkage %s %4d %4d %5d %5d %5d %5d  %02X  '%s'\n", hit ? "*" : "", channel->Number(), link ? link->Number() : -1, SiEitEvent.getEventId(), ld.getOriginalNetworkId(), ld.getTransportStreamId(), ld.getServiceId(), ld.getLinkageType(), linkName);//XXX
+                      if (link) {
+                         if (Setup.UpdateChannels == 1 || Setup.UpdateChannels >= 3)
+                            link->SetName(linkName, "", "");
+                         }
+                      else if (Setup.UpdateChannels >= 4) {
+                         cChannel *transponder = channel;
+                         if (channel->Tid() != ld.getTransportStreamId())
+                            transponder = Channels.GetByTransponderID(linkID);
+                         link = Channels.NewChannel(transponder, linkName, "", "", ld.getOriginalNetworkId(), ld.getTransportStreamId(), ld.getServiceId());
+                         //XXX patFilter->Trigger();
+                         }
+                      if (link) {
+                         if (!LinkChannels)
+                            LinkChannels = new cLinkChannels;
+                         LinkChannels->Add(new cLinkChannel(link));
+                         }
+                      }
+                   else
+                      channel->SetPortalName(linkName);
+                   }
+                }
+             }
+         }
       if (!rEvent) {
-         if (ShortEventDescriptor) {
-            char buffer[Utf8BufSize(256)];
-            EpgHandlers.SetTitle(pEvent, ShortEventDescriptor->name.getText(buffer, sizeof(buffer)));
-            EpgHandlers.SetShortText(pEvent, ShortEventDescriptor->text.getText(buffer, sizeof(buffer)));
-            }
-         else {
-            EpgHandlers.SetTitle(pEvent, NULL);
-            EpgHandlers.SetShortText(pEvent, NULL);
-            }
-         if (ExtendedEventDescriptors) {
-            char buffer[Utf8BufSize(ExtendedEventDescriptors->getMaximumTextLength(": ")) + 1];
-            EpgHandlers.SetDescription(pEvent, ExtendedEventDescriptors->getText(buffer, sizeof(buffer), ": "));
-            }
-         else
-            EpgHandlers.SetDescription(pEvent, NULL);
+         EpgHandlers.SetTitle(pEvent, EitEvent->title);
+         EpgHandlers.SetShortText(pEvent, EitEvent->shortText);
+         EpgHandlers.SetDescription(pEvent, EitEvent->description);
          }
-      delete ExtendedEventDescriptors;
-      delete ShortEventDescriptor;
-
-      pEvent->SetComponents(Components);
+      pEvent->SetComponents(EitEvent->components);
+      EitEvent->components = NULL; // the event has taken ownership
 
       EpgHandlers.FixEpgBugs(pEvent);
       if (LinkChannels)
@@ -303,6 +489,7 @@ cEIT::cEIT(cSchedules *Schedules, int Source, u_char Tid, const u_char *Data, bo
      Schedules->SetModified(pSchedule);
      }
   Channels.Unlock();
+  processed = !OnlyRunningStatus;
 }
 
 // --- cTDT ------------------------------------------------------------------
@@ -340,6 +527,381 @@ cTDT::cTDT(const u_char *Data)
      }
 }
 
+// --- cEitSectionSyncer -----------------------------------------------------
+
+cEitSectionSyncer::cEitSectionSyncer(tChannelID ChannelID, uchar TableID)
+{
+  channelID = ChannelID;
+  tableID = TableID;
+  numSections = 0;
+  versions = NULL;
+  crcs = NULL;
+}
+
+cEitSectionSyncer::~cEitSectionSyncer()
+{
+  free(versions);
+  free(crcs);
+}
+
+bool cEitSectionSyncer::Unchanged(int Number, uchar Version, uint32_t Crc) const
+{
+  return Number < numSections && versions[Number] == Version && crcs[Number] == Crc;
+}
+
+void cEitSectionSyncer::Processed(int Number, int LastNumber, uchar Version, uint32_t Crc)
+{
+  int NewSize = max(Number, LastNumber) + 1;
+  if (NewSize > numSections) {
+     uchar *NewVersions = (uchar *)realloc(versions, NewSize * sizeof(uchar));
+     if (NewVersions)
+        versions = NewVersions;
+     uint32_t *NewCrcs = (uint32_t *)realloc(crcs, NewSize * sizeof(uint32_t));
+     if (NewCrcs)
+        crcs = NewCrcs;
+     if (!NewVersions || !NewCrcs) {
+        esyslog("ERROR: out of memory");
+        return;
+        }
+     memset(versions + numSections, 0xFF, NewSize - numSections);
+     numSections = NewSize;
+     }
+  versions[Number] = Version;
+  crcs[Number] = Crc;
+}
+
+// --- cEitSectionSyncers ----------------------------------------------------
+
+// Broadcasters repeat their EIT sections every few seconds, mostly without any
+// changes. The version number and CRC of every section that has been processed
+// are therefore remembered per service and table, so that a section that shows
+// up again unchanged only needs to have its events marked as 'seen', without
+// checking its CRC and decoding its events again, and without needing a write
+// lock on the schedules.
+
+cEitSectionSyncer *cEitSectionSyncers::Get(tChannelID ChannelID, uchar TableID, bool Create)
+{
+  cList<cHashObject> *List = hash.GetList(ChannelID.Sid());
+  if (List) {
+     for (cHashObject *h = List->First(); h; h = List->Next(h)) {
+         cEitSectionSyncer *Syncer = (cEitSectionSyncer *)h->Object();
+         if (Syncer->Is(ChannelID, TableID))
+            return Syncer;
+         }
+     }
+  if (Create) {
+     cEitSectionSyncer *Syncer = new cEitSectionSyncer(ChannelID, TableID);
+     syncers.Add(Syncer);
+     hash.Add(Syncer, ChannelID.Sid());
+     return Syncer;
+     }
+  return NULL;
+}
+
+bool cEitSectionSyncers::Unchanged(int Source, const u_char *Data, int Length)
+{
+  SI::EIT Eit(Data, false);
+  Eit.CheckParse();
+  if (!Eit.isValid() || Eit.getLength() > Length || Eit.getLength() < 4)
+     return false;
+  cMutexLock MutexLock(&mutex);
+  cEitSectionSyncer *Syncer = Get(tChannelID(Source, Eit.getOriginalNetworkId(), Eit.getTransportStreamId(), Eit.getServiceId()), Eit.getTableId(), false);
+  const u_char *p = Data + Eit.getLength() - 4;
+  return Syncer && Syncer->Unchanged(Eit.getSectionNumber(), Eit.getVersionNumber(), (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+void cEitSectionSyncers::Processed(int Source, const u_char *Data, int Length)
+{
+  SI::EIT Eit(Data, false);
+  Eit.CheckParse();
+  if (!Eit.isValid() || Eit.getLength() > Length || Eit.getLength() < 4)
+     return;
+  cMutexLock MutexLock(&mutex);
+  cEitSectionSyncer *Syncer = Get(tChannelID(Source, Eit.getOriginalNetworkId(), Eit.getTransportStreamId(), Eit.getServiceId()), Eit.getTableId(), true);
+  const u_char *p = Data + Eit.getLength() - 4;
+  Syncer->Processed(Eit.getSectionNumber(), Eit.getLastSectionNumber(), Eit.getVersionNumber(), (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+void cEitSectionSyncers::Clear(void)
+{
+  cMutexLock MutexLock(&mutex);
+  hash.Clear();
+  syncers.Clear();
+}
+
+// --- cEitSection -----------------------------------------------------------
+
+#define EITQUEUESIZE     256 // the maximum number of EIT sections waiting to be decoded
+#define EITDECODERS        4 // the maximum number of EIT decoder threads
+#define EITMERGETIMEOUT  100 // ms to wait for the schedules write lock when merging a section
+#define EITPUTTIMEOUT    100 // ms to wait for a free slot in the queue of EIT sections
+
+class cEitSection : public cListObject {
+public:
+  cEitSectionSyncers *sectionSyncers;
+  int source;
+  u_char tid;
+  tChannelID channelID;
+  int length;
+  u_char *data;
+  cEitSection(cEitSectionSyncers *SectionSyncers, int Source, u_char Tid, tChannelID ChannelID, const u_char *Data, int Length);
+  virtual ~cEitSection();
+  bool Is(tChannelID ChannelID, const u_char *Data, int Length) const { return channelID == ChannelID && length == Length && memcmp(data, Data, Length) == 0; }
+  void Process(void);
+  };
+
+cEitSection::cEitSection(cEitSectionSyncers *SectionSyncers, int Source, u_char Tid, tChannelID ChannelID, const u_char *Data, int Length)
+{
+  sectionSyncers = SectionSyncers;
+  source = Source;
+  tid = Tid;
+  channelID = ChannelID;
+  length = Length;
+  data = MALLOC(u_char, Length);
+  if (data)
+     memcpy(data, Data, Length);
+  else
+     length = 0;
+}
+
+cEitSection::~cEitSection()
+{
+  free(data);
+}
+
+void cEitSection::Process(void)
+{
+  if (!data)
+     return;
+  SI::EIT Eit(data, false);
+  if (!Eit.CheckCRCAndParse())
+     return;
+  cEitEvents Events;
+  Events.Decode(source, tid, Eit);
+  cSchedulesLock SchedulesLock(true, EITMERGETIMEOUT);
+  cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
+  if (Schedules) {
+     cEIT EIT(Schedules, source, tid, data, false, false, &Events);
+     if (EIT.Processed())
+        sectionSyncers->Processed(source, data, length);
+     }
+  else {
+     // If we don't get a write lock, let's at least get a read lock, so
+     // that we can set the running status and 'seen' timestamp (well, actually
+     // with a read lock we shouldn't be doing that, but it's only integers that
+     // get changed, so it should be ok)
+     cSchedulesLock SchedulesLock;
+     cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
+     if (Schedules)
+        cEIT EIT(Schedules, source, tid, data, true, false, &Events);
+     }
+}
+
+// --- cEitSectionQueue ------------------------------------------------------
+
+class cEitSectionQueue;
+
+class cEitDecoder : public cThread {
+private:
+  cEitSectionQueue *queue;
+  int index;
+protected:
+  virtual void Action(void);
+public:
+  cEitDecoder(cEitSectionQueue *Queue, int Index);
+  virtual ~cEitDecoder();
+  };
+
+class cEitSectionQueue {
+private:
+  cMutex mutex;
+  cCondVar sectionReady;
+  cCondVar sectionDone;
+  cList<cEitSection> sections;
+  cEitSection *busy[EITDECODERS]; // the sections the decoders are currently processing
+  cEitDecoder *decoders[EITDECODERS];
+  int numDecoders;
+  int numFilters;
+  bool overflow;
+  cEitSection *Next(void);
+public:
+  cEitSectionQueue(void);
+  ~cEitSectionQueue();
+  void Attach(void);
+       ///< Registers a new cEitFilter.
+  void Detach(cEitSectionSyncers *SectionSyncers);
+       ///< Drops all sections that have been put into the queue with the given
+       ///< SectionSyncers and waits until none of them is being processed any
+       ///< more. The decoder threads are stopped when the last cEitFilter has
+       ///< been detached.
+  void Put(cEitSectionSyncers *SectionSyncers, int Source, u_char Tid, const u_char *Data, int Length);
+       ///< Puts a copy of the given EIT section into the queue. If the queue is
+       ///< full, this waits up to EITPUTTIMEOUT ms for a decoder to take a section
+       ///< and then drops the given one (it will be broadcast again anyway).
+  cEitSection *Get(int Decoder, int TimeoutMs);
+       ///< Returns the next section for the given Decoder to process, or NULL if
+       ///< there is none within TimeoutMs milliseconds. The caller must call
+       ///< Done() once it has processed the section.
+  void Done(int Decoder);
+  };
+
+static cEitSectionQueue EitSectionQueue;
+
+cEitDecoder::cEitDecoder(cEitSectionQueue *Queue, int Index)
+{
+  queue = Queue;
+  index = Index;
+  SetDescription("EIT decoder %d", Index);
+}
+
+cEitDecoder::~cEitDecoder()
+{
+  Cancel(3);
+}
+
+void cEitDecoder::Action(void)
+{
+  while (Running()) {
+        cEitSection *Section = queue->Get(index, 100);
+        if (Section) {
+           Section->Process();
+           queue->Done(index);
+           }
+        }
+}
+
+cEitSectionQueue::cEitSectionQueue(void)
+{
+  for (int i = 0; i < EITDECODERS; i++) {
+      busy[i] = NULL;
+      decoders[i] = NULL;
+      }
+  numDecoders = 0;
+  numFilters = 0;
+  overflow = false;
+}
+
+cEitSectionQueue::~cEitSectionQueue()
+{
+  for (int i = 0; i < EITDECODERS; i++)
+      delete decoders[i];
+}
+
+cEitSection *cEitSectionQueue::Next(void)
+{
+  // The sections of any given service are processed in the order in which they
+  // have been received, so a section is skipped as long as an other section of
+  // the same service is being processed:
+  for (cEitSection *Section = sections.First(); Section; Section = sections.Next(Section)) {
+      bool Busy = false;
+      for (int i = 0; i < numDecoders; i++) {
+          if (busy[i] && busy[i]->channelID == Section->channelID) {
+             Busy = true;
+             break;
+             }
+          }
+      if (!Busy)
+         return Section;
+      }
+  return NULL;
+}
+
+void cEitSectionQueue::Attach(void)
+{
+  cMutexLock MutexLock(&mutex);
+  numFilters++;
+}
+
+void cEitSectionQueue::Detach(cEitSectionSyncers *SectionSyncers)
+{
+  mutex.Lock();
+  for (cEitSection *Section = sections.First(); Section; ) {
+      cEitSection *s = Section;
+      Section = sections.Next(Section);
+      if (s->sectionSyncers == SectionSyncers)
+         sections.Del(s);
+      }
+  for (int i = 0; i < numDecoders; ) {
+      if (busy[i] && busy[i]->sectionSyncers == SectionSyncers) {
+         sectionDone.Wait(mutex);
+         i = 0;
+         }
+      else
+         i++;
+      }
+  cEitDecoder *Decoders[EITDECODERS] = { NULL };
+  if (--numFilters == 0) {
+     for (int i = 0; i < numDecoders; i++) {
+         Decoders[i] = decoders[i];
+         decoders[i] = NULL;
+         }
+     numDecoders = 0;
+     }
+  mutex.Unlock();
+  // the decoders need the mutex to finish, so they are stopped without holding it:
+  for (int i = 0; i < EITDECODERS; i++)
+      delete Decoders[i];
+}
+
+void cEitSectionQueue::Put(cEitSectionSyncers *SectionSyncers, int Source, u_char Tid, const u_char *Data, int Length)
+{
+  SI::EIT Eit(Data, false);
+  Eit.CheckParse();
+  if (!Eit.isValid() || Eit.getLength() > Length)
+     return;
+  tChannelID ChannelID(Source, Eit.getOriginalNetworkId(), Eit.getTransportStreamId(), Eit.getServiceId());
+  cMutexLock MutexLock(&mutex);
+  for (cEitSection *Section = sections.First(); Section; Section = sections.Next(Section)) {
+      if (Section->Is(ChannelID, Data, Length))
+         return; // this section is already waiting to be processed
+      }
+  // If the decoders can't keep up, the section handler is slowed down a little,
+  // just as if it were decoding the section itself:
+  cTimeMs Timeout(EITPUTTIMEOUT);
+  while (sections.Count() >= EITQUEUESIZE) {
+        if (Timeout.TimedOut() || !numDecoders) {
+           if (!overflow)
+              dsyslog("EIT section queue overflow - dropping sections");
+           overflow = true;
+           return;
+           }
+        sectionDone.TimedWait(mutex, EITPUTTIMEOUT);
+        }
+  if (sections.Count() < EITQUEUESIZE / 2)
+     overflow = false;
+  if (!numDecoders) {
+     numDecoders = constrain(int(sysconf(_SC_NPROCESSORS_ONLN)), 1, EITDECODERS);
+     for (int i = 0; i < numDecoders; i++) {
+         decoders[i] = new cEitDecoder(this, i);
+         decoders[i]->Start();
+         }
+     }
+  sections.Add(new cEitSection(SectionSyncers, Source, Tid, ChannelID, Data, Length));
+  sectionReady.Broadcast();
+}
+
+cEitSection *cEitSectionQueue::Get(int Decoder, int TimeoutMs)
+{
+  cMutexLock MutexLock(&mutex);
+  cEitSection *Section = Next();
+  if (!Section && sectionReady.TimedWait(mutex, TimeoutMs))
+     Section = Next();
+  if (Section) {
+     sections.Del(Section, false);
+     busy[Decoder] = Section;
+     }
+  return Section;
+}
+
+void cEitSectionQueue::Done(int Decoder)
+{
+  cMutexLock MutexLock(&mutex);
+  delete busy[Decoder];
+  busy[Decoder] = NULL;
+  sectionDone.Broadcast();
+  sectionReady.Broadcast(); // there may be sections of this service waiting
+}
+
 // --- cEitFilter ------------------------------------------------------------
 
 time_t cEitFilter::disableUntil = 0;
@@ -349,6 +911,18 @@ cEitFilter::cEitFilter(void)
   Set(0x12, 0x40, 0xC0);  // event info now&next actual/other TS (0x4E/0x4F), future actual/other TS (0x5X/0x6X)
   if (Setup.SetSystemTime && Setup.TimeTransponder)
      Set(0x14, 0x70);     // TDT
+  EitSectionQueue.Attach();
+}
+
+cEitFilter::~cEitFilter()
+{
+  EitSectionQueue.Detach(&sectionSyncers);
+}
+
+void cEitFilter::SetStatus(bool On)
+{
+  cFilter::SetStatus(On);
+  sectionSyncers.Clear();
 }
 
 void cEitFilter::SetDisableUntil(time_t Time)
@@ -367,20 +941,16 @@ void cEitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
   switch (Pid) {
     case 0x12: {
          if (Tid >= 0x4E && Tid <= 0x6F) {
-            cSchedulesLock SchedulesLock(true, 10);
-            cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
-            if (Schedules)
-               cEIT EIT(Schedules, Source(), Tid, Data);
-            else {
-               // If we don't get a write lock, let's at least get a read lock, so
-               // that we can set the running status and 'seen' timestamp (well, actually
-               // with a read lock we shouldn't be doing that, but it's only integers that
-               // get changed, so it should be ok)
+            if (sectionSyncers.Unchanged(Source(), Data, Length)) {
                cSchedulesLock SchedulesLock;
                cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
-               if (Schedules)
-                  cEIT EIT(Schedules, Source(), Tid, Data, true);
+               if (Schedules) {
+                  cEIT EIT(Schedules, Source(), Tid, Data, false, true);
+                  if (EIT.Processed())
+                     break;
+                  }
                }
+            EitSectionQueue.Put(&sectionSyncers, Source(), Tid, Data, Length);
             }
          }
          break;
@@ -10,15 +10,56 @@
 #ifndef __EIT_H
 #define __EIT_H
 
+#include "channels.h"
 #include "filter.h"
 
+class cEitSectionSyncer : public cListObject {
+private:
+  tChannelID channelID;
+  uchar tableID;
+  int numSections;
+  uchar *versions; // 0xFF = section not processed yet
+  uint32_t *crcs;
+public:
+  cEitSectionSyncer(tChannelID ChannelID, uchar TableID);
+  virtual ~cEitSectionSyncer();
+  bool Is(tChannelID ChannelID, uchar TableID) const { return tableID == TableID && channelID == ChannelID; }
+  bool Unchanged(int Number, uchar Version, uint32_t Crc) const;
+       ///< Returns true if the section with the given Number has been processed
+       ///< with the same Version and Crc before.
+  void Processed(int Number, int LastNumber, uchar Version, uint32_t Crc);
+  };
+
+class cEitSectionSyncers {
+private:
+  cMutex mutex;
+  cList<cEitSectionSyncer> syncers;
+  cHash<cEitSectionSyncer> hash;
+  cEitSectionSyncer *Get(tChannelID ChannelID, uchar TableID, bool Create);
+public:
+  bool Unchanged(int Source, const u_char *Data, int Length);
+       ///< Returns true if the given EIT section has already been processed and
+       ///< its version and CRC haven't changed since.
+  void Processed(int Source, const u_char *Data, int Length);
+       ///< Records that the given EIT section has been processed.
+  void Clear(void);
+  };
+
+// The EIT sections are not decoded in the section handler's thread. Instead,
+// they are put into a queue, from which a small pool of decoder threads (shared
+// by all devices) takes them. These decode the sections without any lock and
+// only hold the schedules write lock while merging the results.
+
 class cEitFilter : public cFilter {
 private:
   static time_t disableUntil;
+  cEitSectionSyncers sectionSyncers;
 protected:
   virtual void Process(u_short Pid, u_char Tid, const u_char *Data, int Length);
 public:
   cEitFilter(void);
+  virtual ~cEitFilter();
+  virtual void SetStatus(bool On);
   static void SetDisableUntil(time_t Time);
   };
 
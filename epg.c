@@ -12,13 +12,1230 @@
 
 #include "epg.h"
 #include <ctype.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <wctype.h>
+#ifdef ZLIB
+#include <zlib.h>
+#endif
 #include "libsi/si.h"
 #include "timers.h"
 
 #define RUNNINGSTATUSTIMEOUT 30 // seconds before the running status is considered unknown
 
+#define EPGJOURNALEXTENSION ".journal"
+#define EPGJOURNALMAXRATIO  2 // the journal is compacted into the EPG data file once it becomes larger than 1/2 of it...
+#define EPGJOURNALMINSIZE   MEGABYTE(1) // ...but not before it has this size
+
+// --- cEpgStrings -----------------------------------------------------------
+
+// The texts of the events (title, short text and the descriptions of the
+// stream components, see cEpgDescriptions for the event descriptions
+// themselves) are stored only once and shared
+// by all events that use them, which saves a lot of memory with series,
+// repeats and the many events that only have some standard text.
+// Shared strings must never be modified in place!
+
+#define EPGSTRINGSINITIALSIZE 4096 // number of hash buckets to start with (must be a power of 2)
+
+struct tEpgString {
+  tEpgString *next; // in the same hash bucket
+  uint32_t hash;
+  int refs;
+  int length;
+  char text[1];
+  };
+
+class cEpgStrings {
+private:
+  cMutex mutex;
+  tEpgString **table;
+  int tableSize;
+  int count;
+  int refs;
+  size_t bytes;
+  size_t unsharedBytes;
+  static tEpgString *Node(const char *s) { return (tEpgString *)(s - offsetof(tEpgString, text)); }
+  void Grow(void);
+public:
+  cEpgStrings(void);
+  char *Get(const char *s);
+       ///< Returns the shared copy of s, storing it if it isn't there yet.
+       ///< Every call must be matched by a call to Release().
+  char *AddRef(char *s);
+       ///< Returns s, which must have been returned by Get().
+  void Release(char *s);
+  char *Set(char *Old, const char *New);
+       ///< Releases Old and returns the shared copy of New.
+  char *Detach(const char *s) { return s ? strdup(s) : NULL; }
+       ///< Returns a private copy of the shared string s, which may be modified
+       ///< and must be given back through Adopt().
+  char *Adopt(char *s, char *Original);
+       ///< Frees the private copy s and returns the shared copy of it. Original
+       ///< is the shared string s was detached from, which is released (unless
+       ///< s is still the same, in which case it is simply kept).
+  cString Stats(void);
+  };
+
+static cEpgStrings *EpgStrings = new cEpgStrings; // never deleted, since events may be deleted at any time during program exit
+
+cEpgStrings::cEpgStrings(void)
+{
+  tableSize = EPGSTRINGSINITIALSIZE;
+  table = MALLOC(tEpgString *, tableSize);
+  memset(table, 0, tableSize * sizeof(tEpgString *));
+  count = refs = 0;
+  bytes = unsharedBytes = 0;
+}
+
+void cEpgStrings::Grow(void)
+{
+  int NewSize = tableSize * 2;
+  tEpgString **NewTable = MALLOC(tEpgString *, NewSize);
+  if (!NewTable)
+     return; // the chains just get longer
+  memset(NewTable, 0, NewSize * sizeof(tEpgString *));
+  for (int i = 0; i < tableSize; i++) {
+      while (tEpgString *n = table[i]) {
+            table[i] = n->next;
+            n->next = NewTable[n->hash & (NewSize - 1)];
+            NewTable[n->hash & (NewSize - 1)] = n;
+            }
+      }
+  free(table);
+  table = NewTable;
+  tableSize = NewSize;
+}
+
+char *cEpgStrings::Get(const char *s)
+{
+  if (!s)
+     return NULL;
+  uint32_t h = 2166136261u; // FNV-1a
+  const char *p = s;
+  while (*p)
+        h = (h ^ uchar(*p++)) * 16777619u;
+  int Length = p - s;
+  cMutexLock MutexLock(&mutex);
+  tEpgString *n;
+  for (n = table[h & (tableSize - 1)]; n; n = n->next) {
+      if (n->hash == h && n->length == Length && memcmp(n->text, s, Length) == 0)
+         break;
+      }
+  if (!n) {
+     n = (tEpgString *)malloc(offsetof(tEpgString, text) + Length + 1);
+     if (!n) {
+        esyslog("ERROR: out of memory");
+        return NULL;
+        }
+     n->hash = h;
+     n->refs = 0;
+     n->length = Length;
+     memcpy(n->text, s, Length + 1);
+     n->next = table[h & (tableSize - 1)];
+     table[h & (tableSize - 1)] = n;
+     bytes += Length + 1;
+     if (++count > tableSize)
+        Grow();
+     }
+  n->refs++;
+  refs++;
+  unsharedBytes += Length + 1;
+  return n->text;
+}
+
+char *cEpgStrings::AddRef(char *s)
+{
+  if (s) {
+     cMutexLock MutexLock(&mutex);
+     tEpgString *n = Node(s);
+     n->refs++;
+     refs++;
+     unsharedBytes += n->length + 1;
+     }
+  return s;
+}
+
+void cEpgStrings::Release(char *s)
+{
+  if (s) {
+     cMutexLock MutexLock(&mutex);
+     tEpgString *n = Node(s);
+     refs--;
+     unsharedBytes -= n->length + 1;
+     if (--n->refs == 0) {
+        for (tEpgString **p = &table[n->hash & (tableSize - 1)]; *p; p = &(*p)->next) {
+            if (*p == n) {
+               *p = n->next;
+               break;
+               }
+            }
+        bytes -= n->length + 1;
+        count--;
+        free(n);
+        }
+     }
+}
+
+char *cEpgStrings::Set(char *Old, const char *New)
+{
+  char *s = Get(New); // New might be Old
+  Release(Old);
+  return s;
+}
+
+char *cEpgStrings::Adopt(char *s, char *Original)
+{
+  if (s && Original && strcmp(s, Original) == 0) {
+     free(s); // this is the most likely case, which doesn't even need the lock
+     return Original;
+     }
+  char *Shared = Get(s);
+  free(s);
+  Release(Original);
+  return Shared;
+}
+
+cString cEpgStrings::Stats(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return cString::sprintf("strings: %d for %d references, %zd KB (%zd KB without sharing)", count, refs, (bytes + count * offsetof(tEpgString, text)) / KILOBYTE(1), unsharedBytes / KILOBYTE(1));
+}
+
+// --- cEpgDescriptions ------------------------------------------------------
+
+// The descriptions are shared just like the other texts, but since they
+// make up the bulk of the EPG data and are only rarely looked at, they can
+// also be kept compressed in memory (see Setup.EPGCompression). They are
+// packed with zlib, using a preset dictionary that is built once from the
+// words that are most frequent in the descriptions at that time. A packed
+// description is unpacked when it is accessed through cEvent::Description(),
+// and the unpacked text is dropped again once it hasn't been accessed for
+// EPGUNPACKEDTIME seconds. This is only done while holding the schedules
+// write lock, so that the text remains valid for anybody who holds the lock,
+// and never for the events of the copies handed out by a cSchedulesView,
+// which are read without the lock. Since the text moves when it is packed,
+// events refer to the tEpgDescription rather than to the text itself.
+
+#define EPGPACKDELTA          60 // seconds between two runs of the packer
+#define EPGPACKBUCKETS        64 // number of hash buckets the packer handles while holding the lock
+#define EPGPACKMINLENGTH      64 // shorter descriptions aren't worth packing
+#define EPGPACKLOCKTIMEOUT   100 // ms to wait for the schedules lock before trying again
+#define EPGUNPACKEDTIME       3600 // seconds an unpacked text is kept after it has last been accessed
+#define EPGDICTIONARYSIZE     KILOBYTE(16)
+#define EPGDICTIONARYMINTEXTS 1000 // the dictionary isn't built before there are that many descriptions...
+#define EPGDICTIONARYSAMPLE   4000 // ...and it is built from (about) that many of them
+#define EPGDICTIONARYWORDS    65536 // size of the table for counting the words (must be a power of 2)
+
+struct tEpgDescription {
+  tEpgDescription *next; // in the same hash bucket
+  uint32_t hash;
+  int refs;
+  int length;      // of the text, without the terminating 0
+  int packed;      // size of the packed text in data, 0 = not packed (yet), -1 = not worth packing
+  int pins;        // references from copies handed out by a cSchedulesView
+  uint64_t accessed; // when (cTimeMs::Now()) the text was last accessed through Text(), 0 = never
+  char *text;      // NULL if the text is only available packed
+  uchar *data;     // the packed text
+  };
+
+class cEpgDescriptions {
+private:
+  cMutex mutex;
+  tEpgDescription **table;
+  int tableSize;
+  int count;
+  int refs;
+  int packedCount;
+  size_t bytes;
+  size_t packedBytes;
+  size_t unsharedBytes;
+#ifdef ZLIB
+  uchar *dictionary;
+  int dictionarySize;
+  z_stream deflater;
+  z_stream inflater;
+  bool BuildDictionary(void);
+  void Deflate(tEpgDescription *n);
+#endif
+  char *Inflate(const tEpgDescription *n);
+       ///< Returns a newly allocated copy of the text of n, which is unpacked
+       ///< if necessary. The caller must hold the lock.
+  bool Equal(const tEpgDescription *n, const char *s, int Length);
+  void Grow(void);
+public:
+  cEpgDescriptions(void);
+  tEpgDescription *Get(const char *s);
+       ///< Returns the shared description with the text s, storing it if it
+       ///< isn't there yet. Every call must be matched by a call to Release().
+  tEpgDescription *AddRef(tEpgDescription *d);
+  void Release(tEpgDescription *d);
+  void Pin(tEpgDescription *d, bool On);
+       ///< Keeps the unpacked text of d from being dropped as long as it is
+       ///< pinned. Every call with On == true must be matched by one with
+       ///< On == false.
+  tEpgDescription *Set(tEpgDescription *Old, const char *New);
+       ///< Releases Old and returns the shared description with the text New.
+  const char *Text(tEpgDescription *d);
+       ///< Returns the text of d, unpacking it if necessary. The text remains
+       ///< valid as long as the caller holds the schedules lock (or as long as
+       ///< d is pinned).
+  cString Copy(tEpgDescription *d);
+       ///< Returns a copy of the text of d, without keeping it unpacked. This is
+       ///< for functions that go through all events.
+  char *Detach(tEpgDescription *d);
+       ///< Returns a private copy of the text of d, which may be modified and
+       ///< must be given back through Adopt().
+  tEpgDescription *Adopt(char *s, tEpgDescription *Original);
+       ///< Frees the private copy s and returns the shared description with
+       ///< this text. Original is the description s was detached from, which
+       ///< is released (unless s is still the same, in which case it is kept).
+  bool Pack(int &Bucket);
+       ///< Packs the descriptions in the next few hash buckets, starting at
+       ///< Bucket, and drops unpacked texts that haven't been accessed for
+       ///< EPGUNPACKEDTIME seconds and aren't pinned. Bucket is advanced
+       ///< accordingly. The caller must hold the schedules write lock.
+       ///< Returns false if there are no more buckets to be handled.
+  cString Stats(void);
+  };
+
+static cEpgDescriptions *EpgDescriptions = new cEpgDescriptions; // never deleted, see EpgStrings
+
+cEpgDescriptions::cEpgDescriptions(void)
+{
+  tableSize = EPGSTRINGSINITIALSIZE;
+  table = MALLOC(tEpgDescription *, tableSize);
+  memset(table, 0, tableSize * sizeof(tEpgDescription *));
+  count = refs = packedCount = 0;
+  bytes = packedBytes = unsharedBytes = 0;
+#ifdef ZLIB
+  dictionary = NULL; // the zlib streams are initialized along with the dictionary
+  dictionarySize = 0;
+#endif
+}
+
+void cEpgDescriptions::Grow(void)
+{
+  int NewSize = tableSize * 2;
+  tEpgDescription **NewTable = MALLOC(tEpgDescription *, NewSize);
+  if (!NewTable)
+     return; // the chains just get longer
+  memset(NewTable, 0, NewSize * sizeof(tEpgDescription *));
+  for (int i = 0; i < tableSize; i++) {
+      while (tEpgDescription *n = table[i]) {
+            table[i] = n->next;
+            n->next = NewTable[n->hash & (NewSize - 1)];
+            NewTable[n->hash & (NewSize - 1)] = n;
+            }
+      }
+  free(table);
+  table = NewTable;
+  tableSize = NewSize;
+}
+
+#ifdef ZLIB
+struct tEpgDictionaryWord {
+  const char *text;
+  int length;
+  int count;
+  };
+
+static int CompareDictionaryWords(const void *a, const void *b)
+{
+  const tEpgDictionaryWord *w1 = (const tEpgDictionaryWord *)a;
+  const tEpgDictionaryWord *w2 = (const tEpgDictionaryWord *)b;
+  return (w2->count - 1) * w2->length - (w1->count - 1) * w1->length; // the most bytes saved first
+}
+
+bool cEpgDescriptions::BuildDictionary(void)
+{
+  if (count < EPGDICTIONARYMINTEXTS)
+     return false;
+  cTimeMs Timer;
+  // Count the words (including the following blank) in a sample of the descriptions:
+  tEpgDictionaryWord *Words = MALLOC(tEpgDictionaryWord, EPGDICTIONARYWORDS);
+  if (!Words) {
+     esyslog("ERROR: out of memory");
+     return false;
+     }
+  memset(Words, 0, EPGDICTIONARYWORDS * sizeof(tEpgDictionaryWord));
+  int NumWords = 0;
+  int Step = max(count / EPGDICTIONARYSAMPLE, 1);
+  int n = 0;
+  for (int i = 0; i < tableSize; i++) {
+      for (tEpgDescription *d = table[i]; d; d = d->next) {
+          if (n++ % Step || !d->text)
+             continue;
+          for (const char *p = d->text; *p; ) {
+              const char *e = p;
+              while (*e && *e != ' ')
+                    e++;
+              if (*e)
+                 e++;
+              int Length = e - p;
+              if (Length >= 4 && Length <= 64) {
+                 uint32_t h = 2166136261u; // FNV-1a
+                 for (const char *q = p; q < e; q++)
+                     h = (h ^ uchar(*q)) * 16777619u;
+                 for (int w = h & (EPGDICTIONARYWORDS - 1); ; w = (w + 1) & (EPGDICTIONARYWORDS - 1)) {
+                     if (!Words[w].text) {
+                        if (4 * NumWords < 3 * EPGDICTIONARYWORDS) { // the table must not run full
+                           Words[w].text = p;
+                           Words[w].length = Length;
+                           Words[w].count = 1;
+                           NumWords++;
+                           }
+                        break;
+                        }
+                     if (Words[w].length == Length && memcmp(Words[w].text, p, Length) == 0) {
+                        Words[w].count++;
+                        break;
+                        }
+                     }
+                 }
+              p = e;
+              }
+          }
+      }
+  // The dictionary is made of the words that save the most, with the best
+  // ones at the end, where they are closest to the text:
+  qsort(Words, EPGDICTIONARYWORDS, sizeof(tEpgDictionaryWord), CompareDictionaryWords);
+  uchar *Dictionary = MALLOC(uchar, EPGDICTIONARYSIZE);
+  int Size = 0;
+  int Last = 0;
+  while (Last < NumWords && Words[Last].count > 1 && Size + Words[Last].length <= EPGDICTIONARYSIZE)
+        Size += Words[Last++].length;
+  if (Dictionary) {
+     uchar *p = Dictionary;
+     while (Last-- > 0) {
+           memcpy(p, Words[Last].text, Words[Last].length);
+           p += Words[Last].length;
+           }
+     }
+  free(Words);
+  if (!Dictionary || !Size) {
+     free(Dictionary);
+     return false;
+     }
+  memset(&deflater, 0, sizeof(deflater));
+  memset(&inflater, 0, sizeof(inflater));
+  // Raw streams, since the packed texts don't need a header or checksum:
+  if (deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+     esyslog("ERROR: can't initialize zlib");
+     free(Dictionary);
+     return false;
+     }
+  if (inflateInit2(&inflater, -MAX_WBITS) != Z_OK) {
+     esyslog("ERROR: can't initialize zlib");
+     deflateEnd(&deflater);
+     free(Dictionary);
+     return false;
+     }
+  dictionary = Dictionary;
+  dictionarySize = Size;
+  dsyslog("built EPG description dictionary (%d bytes) from %d of %d descriptions in %lld ms", Size, n / Step, count, (long long)Timer.Elapsed());
+  return true;
+}
+
+void cEpgDescriptions::Deflate(tEpgDescription *n)
+{
+  n->packed = -1;
+  uLong Size = deflateBound(&deflater, n->length);
+  uchar *Buffer = MALLOC(uchar, Size);
+  if (!Buffer)
+     return;
+  if (deflateReset(&deflater) == Z_OK && deflateSetDictionary(&deflater, dictionary, dictionarySize) == Z_OK) {
+     deflater.next_in = (Bytef *)n->text;
+     deflater.avail_in = n->length;
+     deflater.next_out = Buffer;
+     deflater.avail_out = Size;
+     if (deflate(&deflater, Z_FINISH) == Z_STREAM_END && deflater.total_out + 16 < uLong(n->length)) { // some gain beyond the malloc overhead
+        if ((n->data = MALLOC(uchar, deflater.total_out)) != NULL) {
+           memcpy(n->data, Buffer, deflater.total_out);
+           n->packed = deflater.total_out;
+           packedCount++;
+           packedBytes += n->packed;
+           }
+        }
+     }
+  free(Buffer);
+}
+#endif
+
+char *cEpgDescriptions::Inflate(const tEpgDescription *n)
+{
+  if (n->text)
+     return strdup(n->text);
+  char *s = MALLOC(char, n->length + 1);
+  if (!s) {
+     esyslog("ERROR: out of memory");
+     return NULL;
+     }
+#ifdef ZLIB
+  if (n->data && inflateReset(&inflater) == Z_OK && inflateSetDictionary(&inflater, dictionary, dictionarySize) == Z_OK) {
+     inflater.next_in = n->data;
+     inflater.avail_in = n->packed;
+     inflater.next_out = (Bytef *)s;
+     inflater.avail_out = n->length;
+     if (inflate(&inflater, Z_FINISH) == Z_STREAM_END && inflater.total_out == uLong(n->length)) {
+        s[n->length] = 0;
+        return s;
+        }
+     }
+#endif
+  esyslog("ERROR: can't unpack EPG description");
+  free(s);
+  return NULL;
+}
+
+bool cEpgDescriptions::Equal(const tEpgDescription *n, const char *s, int Length)
+{
+  if (n->length != Length)
+     return false;
+  if (n->text)
+     return memcmp(n->text, s, Length) == 0;
+  char *Text = Inflate(n);
+  bool Result = Text && memcmp(Text, s, Length) == 0;
+  free(Text);
+  return Result;
+}
+
+tEpgDescription *cEpgDescriptions::Get(const char *s)
+{
+  if (!s)
+     return NULL;
+  uint32_t h = 2166136261u; // FNV-1a
+  const char *p = s;
+  while (*p)
+        h = (h ^ uchar(*p++)) * 16777619u;
+  int Length = p - s;
+  cMutexLock MutexLock(&mutex);
+  tEpgDescription *n;
+  for (n = table[h & (tableSize - 1)]; n; n = n->next) {
+      if (n->hash == h && Equal(n, s, Length))
+         break;
+      }
+  if (!n) {
+     n = MALLOC(tEpgDescription, 1);
+     char *Text = MALLOC(char, Length + 1);
+     if (!n || !Text) {
+        esyslog("ERROR: out of memory");
+        free(n);
+        free(Text);
+        return NULL;
+        }
+     memcpy(Text, s, Length + 1);
+     n->hash = h;
+     n->refs = 0;
+     n->length = Length;
+     n->packed = 0;
+     n->pins = 0;
+     n->accessed = 0;
+     n->text = Text;
+     n->data = NULL;
+     n->next = table[h & (tableSize - 1)];
+     table[h & (tableSize - 1)] = n;
+     bytes += Length + 1;
+     if (++count > tableSize)
+        Grow();
+     }
+  n->refs++;
+  refs++;
+  unsharedBytes += Length + 1;
+  return n;
+}
+
+tEpgDescription *cEpgDescriptions::AddRef(tEpgDescription *d)
+{
+  if (d) {
+     cMutexLock MutexLock(&mutex);
+     d->refs++;
+     refs++;
+     unsharedBytes += d->length + 1;
+     }
+  return d;
+}
+
+void cEpgDescriptions::Pin(tEpgDescription *d, bool On)
+{
+  if (d) {
+     cMutexLock MutexLock(&mutex);
+     d->pins += On ? 1 : -1;
+     }
+}
+
+void cEpgDescriptions::Release(tEpgDescription *d)
+{
+  if (d) {
+     cMutexLock MutexLock(&mutex);
+     refs--;
+     unsharedBytes -= d->length + 1;
+     if (--d->refs == 0) {
+        for (tEpgDescription **p = &table[d->hash & (tableSize - 1)]; *p; p = &(*p)->next) {
+            if (*p == d) {
+               *p = d->next;
+               break;
+               }
+            }
+        if (d->text)
+           bytes -= d->length + 1;
+        if (d->packed > 0) {
+           packedCount--;
+           packedBytes -= d->packed;
+           }
+        count--;
+        free(d->text);
+        free(d->data);
+        free(d);
+        }
+     }
+}
+
+tEpgDescription *cEpgDescriptions::Set(tEpgDescription *Old, const char *New)
+{
+  tEpgDescription *d = Get(New); // New might be the text of Old
+  Release(Old);
+  return d;
+}
+
+const char *cEpgDescriptions::Text(tEpgDescription *d)
+{
+  if (!d)
+     return NULL;
+  cMutexLock MutexLock(&mutex);
+  if (!d->text) {
+     d->text = Inflate(d);
+     if (d->text)
+        bytes += d->length + 1;
+     }
+  d->accessed = cTimeMs::Now();
+  return d->text;
+}
+
+cString cEpgDescriptions::Copy(tEpgDescription *d)
+{
+  if (!d)
+     return NULL;
+  cMutexLock MutexLock(&mutex);
+  return cString(Inflate(d), true);
+}
+
+char *cEpgDescriptions::Detach(tEpgDescription *d)
+{
+  if (!d)
+     return NULL;
+  cMutexLock MutexLock(&mutex);
+  return Inflate(d);
+}
+
+tEpgDescription *cEpgDescriptions::Adopt(char *s, tEpgDescription *Original)
+{
+  if (s && Original) {
+     cMutexLock MutexLock(&mutex);
+     if (Equal(Original, s, strlen(s))) {
+        free(s); // this is the most likely case
+        return Original;
+        }
+     }
+  tEpgDescription *Shared = Get(s);
+  free(s);
+  Release(Original);
+  return Shared;
+}
+
+bool cEpgDescriptions::Pack(int &Bucket)
+{
+  cMutexLock MutexLock(&mutex);
+#ifdef ZLIB
+  if (Bucket == 0 && !dictionary && (!Setup.EPGCompression || !BuildDictionary()))
+     return false;
+  // cTimeMs isn't affected when VDR sets the system time:
+  uint64_t Now = cTimeMs::Now();
+  for (int i = Bucket; i < tableSize && i < Bucket + EPGPACKBUCKETS; i++) {
+      for (tEpgDescription *n = table[i]; n; n = n->next) {
+          if (n->text && !n->pins && (!n->accessed || Now - n->accessed > EPGUNPACKEDTIME * 1000)) {
+             if (n->packed == 0 && n->length >= EPGPACKMINLENGTH && Setup.EPGCompression)
+                Deflate(n);
+             if (n->packed > 0) {
+                free(n->text);
+                n->text = NULL;
+                bytes -= n->length + 1;
+                }
+             }
+          }
+      }
+#endif
+  Bucket += EPGPACKBUCKETS;
+  return Bucket < tableSize;
+}
+
+cString cEpgDescriptions::Stats(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return cString::sprintf("descriptions: %d for %d references, %zd KB (%zd KB without sharing), %d packed into %zd KB", count, refs, (bytes + count * sizeof(tEpgDescription)) / KILOBYTE(1), unsharedBytes / KILOBYTE(1), packedCount, packedBytes / KILOBYTE(1));
+}
+
+// --- cEpgPacker ------------------------------------------------------------
+
+class cEpgPacker : public cThread {
+private:
+  time_t lastPack;
+protected:
+  virtual void Action(void);
+public:
+  cEpgPacker(void);
+  virtual ~cEpgPacker();
+  void Trigger(void);
+       ///< Starts packing the EPG descriptions, unless this has already been
+       ///< done within the last EPGPACKDELTA seconds.
+  };
+
+static cEpgPacker EpgPacker;
+
+cEpgPacker::cEpgPacker(void)
+:cThread("epg packer")
+{
+  lastPack = 0;
+}
+
+cEpgPacker::~cEpgPacker()
+{
+  Cancel(3);
+}
+
+void cEpgPacker::Trigger(void)
+{
+  time_t now = time(NULL);
+  if (now - lastPack > EPGPACKDELTA && !Active()) {
+     lastPack = now;
+     Start();
+     }
+}
+
+void cEpgPacker::Action(void)
+{
+  SetPriority(19);
+  int Bucket = 0;
+  while (Running()) {
+        // Readers rely on the texts they got remaining valid while they hold the lock:
+        cSchedulesLock SchedulesLock(true, EPGPACKLOCKTIMEOUT);
+        if (SchedulesLock.Locked()) {
+           if (!EpgDescriptions->Pack(Bucket))
+              break;
+           }
+        }
+}
+
+// --- cEventArena -----------------------------------------------------------
+
+// Events are allocated in chunks, which avoids the overhead and the
+// fragmentation of allocating hundreds of thousands of them individually.
+// The memory of deleted events is reused for new ones, but never given
+// back to the system.
+
+#define EVENTARENACHUNK 1024 // number of events per chunk
+
+class cEventArena {
+private:
+  cMutex mutex;
+  void *freeSlots; // the first free slot, which contains a pointer to the next one
+  int slotSize;
+  int chunks;
+  int used;
+public:
+  cEventArena(int SlotSize);
+  void *Alloc(void);
+  void Free(void *Slot);
+  cString Stats(void);
+  };
+
+static cEventArena *EventArena = new cEventArena(sizeof(cEvent)); // never deleted, see EpgStrings
+
+cEventArena::cEventArena(int SlotSize)
+{
+  freeSlots = NULL;
+  slotSize = (max(SlotSize, int(sizeof(void *))) + 7) & ~7;
+  chunks = used = 0;
+}
+
+void *cEventArena::Alloc(void)
+{
+  cMutexLock MutexLock(&mutex);
+  used++;
+  if (!freeSlots) {
+     char *Chunk = MALLOC(char, EVENTARENACHUNK * slotSize);
+     if (!Chunk)
+        return ::operator new(slotSize); // will be added to the free slots when deleted
+     for (int i = EVENTARENACHUNK; i-- > 0; ) {
+         *(void **)(Chunk + i * slotSize) = freeSlots;
+         freeSlots = Chunk + i * slotSize;
+         }
+     chunks++;
+     }
+  void *Slot = freeSlots;
+  freeSlots = *(void **)Slot;
+  return Slot;
+}
+
+void cEventArena::Free(void *Slot)
+{
+  cMutexLock MutexLock(&mutex);
+  *(void **)Slot = freeSlots;
+  freeSlots = Slot;
+  used--;
+}
+
+cString cEventArena::Stats(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return cString::sprintf("events: %d, %d KB in %d chunks", used, chunks * EVENTARENACHUNK * slotSize / KILOBYTE(1), chunks);
+}
+
+// --- cEpgIndex -------------------------------------------------------------
+
+// The search index maps every word in the title, short text and description
+// of an event to the events that contain it. It isn't built before the first
+// search, but from then on it is kept up to date while events are added,
+// changed and deleted. Every indexed event has a slot, and each word has a
+// list of postings, which are the slots of its events (together with the
+// fields the word occurs in) in ascending order. When the texts of an event
+// change, the event simply gets a new slot; the postings of its old one are
+// ignored until there are so many unused slots that the whole index is
+// compacted. New slots are only indexed at the next search, so an event that
+// gets its texts one by one (as with EIT data) is indexed only once.
+
+#define EPGINDEXINITIALSIZE  65536 // number of hash buckets to start with (must be a power of 2)
+#define EPGINDEXMINUNUSED    10000 // the index is compacted when there are at least this many unused slots...
+#define EPGINDEXMAXUNUSED    2     // ...and they make up at least 1/2 of all slots
+#define EPGINDEXSLOTSHIFT    3     // the lower bits of a posting hold the fields (see eEpgSearchField)
+
+struct tEpgIndexWord {
+  tEpgIndexWord *next; // in the same hash bucket
+  uint32_t hash;
+  int numPostings;
+  int maxPostings;
+  uint32_t *postings;
+  char word[1];
+  };
+
+class cEpgIndexText {
+private:
+  char *buffer;
+  int size;
+public:
+  cEpgIndexText(void) { buffer = NULL; size = 0; }
+  ~cEpgIndexText() { free(buffer); }
+  const char *Normalize(const char *Text);
+       ///< Returns Text with all letters and digits in lower case and everything
+       ///< else replaced by single blanks. The result begins and ends with a
+       ///< blank, so that " word " only finds complete words.
+  };
+
+const char *cEpgIndexText::Normalize(const char *Text)
+{
+  int Size = Utf8BufSize(Text ? strlen(Text) : 0) + 3; // a lower case character may take more bytes
+  if (Size > size) {
+     char *NewBuffer = (char *)realloc(buffer, Size);
+     if (!NewBuffer) {
+        esyslog("ERROR: out of memory");
+        return " ";
+        }
+     buffer = NewBuffer;
+     size = Size;
+     }
+  char *q = buffer;
+  *q++ = ' ';
+  while (Text && *Text) {
+        int l = Utf8CharLen(Text);
+        uint c = cCharSetConv::SystemCharacterTable() ? uchar(*Text) : Utf8CharGet(Text, l);
+        Text += l;
+        if (Utf8is(alnum, c))
+           q += Utf8CharSet(Utf8to(lower, c), q);
+        else if (q[-1] != ' ')
+           *q++ = ' ';
+        }
+  if (q[-1] != ' ')
+     *q++ = ' ';
+  *q = 0;
+  return buffer;
+}
+
+class cEpgIndex {
+private:
+  cMutex mutex;
+  bool active;
+  tEpgIndexWord **table;
+  int tableSize;
+  int count;
+  size_t postings;
+  cEvent **slots; // NULL = unused
+  int numSlots;
+  int maxSlots;
+  int indexedSlots; // the slots below this one have been indexed
+  int unusedSlots;
+  cEpgIndexText text;
+  static uint32_t Hash(const char *s, int Length);
+  tEpgIndexWord *GetWord(const char *s, int Length, bool Add);
+  void Grow(void);
+  void NewSlot(cEvent *Event);
+  void AddPosting(const char *Word, int Length, uint32_t Posting);
+  void IndexSlot(int Slot);
+  void Flush(void);
+       ///< Indexes all new slots and compacts the index if necessary.
+  void Compact(void);
+  bool Matches(const cEvent *Event, const char *Phrase, int Fields);
+public:
+  cEpgIndex(void);
+  bool Active(void) { return active; }
+  void Add(cEvent *Event);
+       ///< Adds Event to the index, if the index is in use.
+  void Update(cEvent *Event);
+       ///< Indexes Event again, because its texts have changed.
+  void Del(cEvent *Event);
+       ///< Removes Event from the index.
+  int Search(const cSchedules *Schedules, const char *Query, cVector<const cEvent *> &Events, tChannelID ChannelID, time_t From, time_t To, int Fields);
+       ///< Does the actual work for cSchedules::Search(), except for sorting the
+       ///< events.
+  cString Stats(void);
+  };
+
+static cEpgIndex *EpgIndex = new cEpgIndex; // never deleted, see EpgStrings
+
+cEpgIndex::cEpgIndex(void)
+{
+  active = false;
+  table = NULL;
+  tableSize = count = 0;
+  postings = 0;
+  slots = NULL;
+  numSlots = maxSlots = 0;
+  indexedSlots = unusedSlots = 0;
+}
+
+uint32_t cEpgIndex::Hash(const char *s, int Length)
+{
+  uint32_t h = 2166136261u; // FNV-1a
+  while (Length-- > 0)
+        h = (h ^ uchar(*s++)) * 16777619u;
+  return h;
+}
+
+void cEpgIndex::Grow(void)
+{
+  int NewSize = tableSize * 2;
+  tEpgIndexWord **NewTable = MALLOC(tEpgIndexWord *, NewSize);
+  if (!NewTable)
+     return; // the chains just get longer
+  memset(NewTable, 0, NewSize * sizeof(tEpgIndexWord *));
+  for (int i = 0; i < tableSize; i++) {
+      while (tEpgIndexWord *w = table[i]) {
+            table[i] = w->next;
+            w->next = NewTable[w->hash & (NewSize - 1)];
+            NewTable[w->hash & (NewSize - 1)] = w;
+            }
+      }
+  free(table);
+  table = NewTable;
+  tableSize = NewSize;
+}
+
+tEpgIndexWord *cEpgIndex::GetWord(const char *s, int Length, bool Add)
+{
+  uint32_t h = Hash(s, Length);
+  for (tEpgIndexWord *w = table[h & (tableSize - 1)]; w; w = w->next) {
+      if (w->hash == h && strncmp(w->word, s, Length) == 0 && !w->word[Length])
+         return w;
+      }
+  if (!Add)
+     return NULL;
+  tEpgIndexWord *w = (tEpgIndexWord *)malloc(offsetof(tEpgIndexWord, word) + Length + 1);
+  if (!w) {
+     esyslog("ERROR: out of memory");
+     return NULL;
+     }
+  w->hash = h;
+  w->numPostings = w->maxPostings = 0;
+  w->postings = NULL;
+  memcpy(w->word, s, Length);
+  w->word[Length] = 0;
+  w->next = table[h & (tableSize - 1)];
+  table[h & (tableSize - 1)] = w;
+  if (++count > tableSize)
+     Grow();
+  return w;
+}
+
+void cEpgIndex::NewSlot(cEvent *Event)
+{
+  if (numSlots >= maxSlots) {
+     int NewMax = max(maxSlots * 2, EVENTARENACHUNK);
+     cEvent **NewSlots = (cEvent **)realloc(slots, NewMax * sizeof(cEvent *));
+     if (!NewSlots) {
+        esyslog("ERROR: out of memory");
+        return;
+        }
+     slots = NewSlots;
+     maxSlots = NewMax;
+     }
+  Event->indexSlot = numSlots;
+  slots[numSlots++] = Event;
+}
+
+void cEpgIndex::AddPosting(const char *Word, int Length, uint32_t Posting)
+{
+  tEpgIndexWord *w = GetWord(Word, Length, true);
+  if (!w)
+     return;
+  if (w->numPostings && (w->postings[w->numPostings - 1] >> EPGINDEXSLOTSHIFT) == (Posting >> EPGINDEXSLOTSHIFT)) {
+     w->postings[w->numPostings - 1] |= Posting; // the word occurs more than once in this event
+     return;
+     }
+  if (w->numPostings >= w->maxPostings) {
+     int NewMax = max(w->maxPostings * 2, 4);
+     uint32_t *NewPostings = (uint32_t *)realloc(w->postings, NewMax * sizeof(uint32_t));
+     if (!NewPostings) {
+        esyslog("ERROR: out of memory");
+        return;
+        }
+     w->postings = NewPostings;
+     w->maxPostings = NewMax;
+     }
+  w->postings[w->numPostings++] = Posting;
+  postings++;
+}
+
+void cEpgIndex::IndexSlot(int Slot)
+{
+  cEvent *Event = slots[Slot];
+  for (int Field = esfTitle; Field <= esfDescription; Field <<= 1) {
+      cString Description;
+      const char *s;
+      switch (Field) {
+        case esfTitle:       s = Event->title; break;
+        case esfShortText:   s = Event->shortText; break;
+        default:             s = Description = EpgDescriptions->Copy(Event->description); // doesn't keep packed descriptions unpacked
+        }
+      if (isempty(s))
+         continue;
+      const char *p = text.Normalize(s) + 1;
+      while (*p) {
+            const char *e = strchr(p, ' ');
+            AddPosting(p, e - p, (uint32_t(Slot) << EPGINDEXSLOTSHIFT) | Field);
+            p = e + 1;
+            }
+      }
+}
+
+void cEpgIndex::Flush(void)
+{
+  while (indexedSlots < numSlots) {
+        if (slots[indexedSlots])
+           IndexSlot(indexedSlots);
+        indexedSlots++;
+        }
+  if (unusedSlots >= EPGINDEXMINUNUSED && unusedSlots * EPGINDEXMAXUNUSED >= numSlots)
+     Compact();
+}
+
+void cEpgIndex::Compact(void)
+{
+  cTimeMs Timer;
+  // Slot 0 is never used, so 0 can mark the slots that are dropped:
+  int *NewSlots = MALLOC(int, numSlots);
+  if (!NewSlots)
+     return;
+  int n = 1;
+  for (int i = 1; i < numSlots; i++) {
+      if (cEvent *Event = slots[i]) {
+         NewSlots[i] = n;
+         Event->indexSlot = n;
+         slots[n++] = Event;
+         }
+      else
+         NewSlots[i] = 0;
+      }
+  postings = 0;
+  for (int i = 0; i < tableSize; i++) {
+      for (tEpgIndexWord **p = &table[i]; *p; ) {
+          tEpgIndexWord *w = *p;
+          int k = 0;
+          for (int j = 0; j < w->numPostings; j++) {
+              if (int Slot = NewSlots[w->postings[j] >> EPGINDEXSLOTSHIFT])
+                 w->postings[k++] = (uint32_t(Slot) << EPGINDEXSLOTSHIFT) | (w->postings[j] & esfAll);
+              }
+          w->numPostings = k;
+          postings += k;
+          if (!k) {
+             *p = w->next;
+             free(w->postings);
+             free(w);
+             count--;
+             }
+          else
+             p = &w->next;
+          }
+      }
+  free(NewSlots);
+  dsyslog("compacted EPG search index from %d to %d slots in %lld ms", numSlots, n, (long long)Timer.Elapsed());
+  numSlots = indexedSlots = n;
+  unusedSlots = 0;
+}
+
+void cEpgIndex::Add(cEvent *Event)
+{
+  if (active) {
+     cMutexLock MutexLock(&mutex);
+     if (!Event->indexSlot)
+        NewSlot(Event);
+     }
+}
+
+void cEpgIndex::Update(cEvent *Event)
+{
+  cMutexLock MutexLock(&mutex);
+  if (Event->indexSlot && Event->indexSlot < indexedSlots) { // otherwise it hasn't been indexed yet, anyway
+     slots[Event->indexSlot] = NULL;
+     unusedSlots++;
+     NewSlot(Event);
+     }
+}
+
+void cEpgIndex::Del(cEvent *Event)
+{
+  cMutexLock MutexLock(&mutex);
+  if (Event->indexSlot) {
+     slots[Event->indexSlot] = NULL;
+     Event->indexSlot = 0;
+     unusedSlots++;
+     }
+}
+
+bool cEpgIndex::Matches(const cEvent *Event, const char *Phrase, int Fields)
+{
+  if ((Fields & esfTitle) && strstr(text.Normalize(Event->title), Phrase))
+     return true;
+  if ((Fields & esfShortText) && strstr(text.Normalize(Event->shortText), Phrase))
+     return true;
+  if ((Fields & esfDescription) && strstr(text.Normalize(EpgDescriptions->Copy(Event->description)), Phrase))
+     return true;
+  return false;
+}
+
+int cEpgIndex::Search(const cSchedules *Schedules, const char *Query, cVector<const cEvent *> &Events, tChannelID ChannelID, time_t From, time_t To, int Fields)
+{
+  // The words of the query, and the phrases among them:
+  cStringList Words;
+  cStringList Phrases;
+  cEpgIndexText QueryText;
+  bool Phrase = false;
+  for (const char *q = Query; q && *q; Phrase = !Phrase) {
+      const char *e = strchr(q, '"');
+      int l = e ? e - q : strlen(q);
+      char Part[l + 1];
+      strn0cpy(Part, q, l + 1);
+      const char *p = QueryText.Normalize(Part);
+      int n = 0;
+      for (const char *s = p + 1; *s; n++) {
+          const char *w = strchr(s, ' ');
+          Words.Append(strndup(s, w - s));
+          s = w + 1;
+          }
+      if (Phrase && n > 1) // a single word needs no phrase check
+         Phrases.Append(strdup(p));
+      q = e ? e + 1 : NULL;
+      }
+  if (!Words.Size() || !(Fields & esfAll))
+     return 0;
+  if (!active) {
+     // All schedules must be loaded before the index is locked, since loading
+     // one adds its events:
+     for (const cSchedule *Schedule = Schedules->First(); Schedule; Schedule = Schedules->Next(Schedule))
+         Schedule->Events();
+     cMutexLock MutexLock(&mutex);
+     if (!active) {
+        cTimeMs Timer;
+        tableSize = EPGINDEXINITIALSIZE;
+        table = MALLOC(tEpgIndexWord *, tableSize);
+        if (!table)
+           return 0;
+        memset(table, 0, tableSize * sizeof(tEpgIndexWord *));
+        numSlots = indexedSlots = 1; // slot 0 means "not indexed"
+        for (const cSchedule *Schedule = Schedules->First(); Schedule; Schedule = Schedules->Next(Schedule)) {
+            const cList<cEvent> *List = Schedule->Events();
+            for (cEvent *Event = List->First(); Event; Event = List->Next(Event)) {
+                if (Event->eventID || Event->startTime) // not phased out
+                   NewSlot(Event);
+                }
+            }
+        active = true;
+        Flush();
+        isyslog("built EPG search index for %d events in %lld ms", numSlots - 1, (long long)Timer.Elapsed());
+        }
+     }
+  ChannelID.ClrRid();
+  cMutexLock MutexLock(&mutex);
+  Flush();
+  // The words are looked up rarest first, which keeps the list of candidates short:
+  tEpgIndexWord *w[Words.Size()];
+  for (int i = 0; i < Words.Size(); i++) {
+      if (!(w[i] = GetWord(Words[i], strlen(Words[i]), false)))
+         return 0;
+      for (int j = i; j > 0 && w[j]->numPostings < w[j - 1]->numPostings; j--)
+          swap(w[j], w[j - 1]);
+      }
+  uint32_t *Candidates = MALLOC(uint32_t, w[0]->numPostings);
+  if (!Candidates)
+     return 0;
+  int NumCandidates = 0;
+  for (int j = 0; j < w[0]->numPostings; j++) {
+      if (w[0]->postings[j] & Fields)
+         Candidates[NumCandidates++] = w[0]->postings[j] >> EPGINDEXSLOTSHIFT;
+      }
+  for (int i = 1; i < Words.Size() && NumCandidates; i++) {
+      // Both lists are in ascending order of slots:
+      int n = 0;
+      const uint32_t *p = w[i]->postings;
+      const uint32_t *e = p + w[i]->numPostings;
+      for (int j = 0; j < NumCandidates && p < e; j++) {
+          while (p < e && (*p >> EPGINDEXSLOTSHIFT) < Candidates[j])
+                p++;
+          if (p < e && (*p >> EPGINDEXSLOTSHIFT) == Candidates[j] && (*p & Fields))
+             Candidates[n++] = Candidates[j];
+          }
+      NumCandidates = n;
+      }
+  int Found = 0;
+  for (int j = 0; j < NumCandidates; j++) {
+      const cEvent *Event = slots[Candidates[j]];
+      if (!Event)
+         continue; // the postings of unused slots are still there
+      if (ChannelID.Valid() && !(Event->schedule->ChannelID() == ChannelID))
+         continue;
+      if ((From && Event->EndTime() < From) || (To && Event->StartTime() > To))
+         continue;
+      bool Ok = true;
+      for (int i = 0; Ok && i < Phrases.Size(); i++)
+          Ok = Matches(Event, Phrases[i], Fields);
+      if (Ok) {
+         Events.Append(Event);
+         Found++;
+         }
+      }
+  free(Candidates);
+  return Found;
+}
+
+cString cEpgIndex::Stats(void)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!active)
+     return "search index: not in use";
+  return cString::sprintf("search index: %d events, %d words, %zd postings, %zd KB", numSlots - 1 - unusedSlots, count, postings, (size_t(tableSize) * sizeof(tEpgIndexWord *) + count * sizeof(tEpgIndexWord) + postings * sizeof(uint32_t) + maxSlots * sizeof(cEvent *)) / KILOBYTE(1));
+}
+
 // --- tComponent ------------------------------------------------------------
 
 cString tComponent::ToString(void)
@@ -31,11 +1248,10 @@ cString tComponent::ToString(void)
 bool tComponent::FromString(const char *s)
 {
   unsigned int Stream, Type;
-  int n = sscanf(s, "%X %02X %7s %a[^\n]", &Stream, &Type, language, &description); // 7 = MAXLANGCODE2 - 1
-  if (n != 4 || isempty(description)) {
-     free(description);
-     description = NULL;
-     }
+  char *Description = NULL;
+  int n = sscanf(s, "%X %02X %7s %a[^\n]", &Stream, &Type, language, &Description); // 7 = MAXLANGCODE2 - 1
+  description = EpgStrings->Set(description, n == 4 && !isempty(Description) ? Description : NULL);
+  free(Description);
   stream = Stream;
   type = Type;
   return n >= 3;
@@ -52,7 +1268,7 @@ cComponents::cComponents(void)
 cComponents::~cComponents(void)
 {
   for (int i = 0; i < numComponents; i++)
-      free(components[i].description);
+      EpgStrings->Release(components[i].description);
   free(components);
 }
 
@@ -91,7 +1307,7 @@ void cComponents::SetComponent(int Index, uchar Stream, uchar Type, const char *
   char *q = strchr(p->language, ',');
   if (q)
      *q = 0; // strips rest of "normalized" language codes
-  p->description = strcpyrealloc(p->description, !isempty(Description) ? Description : NULL);
+  p->description = EpgStrings->Set(p->description, !isempty(Description) ? Description : NULL);
 }
 
 tComponent *cComponents::GetComponent(int Index, uchar Stream, uchar Type)
@@ -112,6 +1328,8 @@ tComponent *cComponents::GetComponent(int Index, uchar Stream, uchar Type)
 
 cEvent::cEvent(tEventID EventID)
 {
+  changed = true;
+  indexSlot = 0;
   schedule = NULL;
   eventID = EventID;
   tableID = 0xFF; // actual table ids are 0x4E..0x60
@@ -131,12 +1349,27 @@ cEvent::cEvent(tEventID EventID)
 
 cEvent::~cEvent()
 {
-  free(title);
-  free(shortText);
-  free(description);
+  if (indexSlot)
+     EpgIndex->Del(this);
+  EpgStrings->Release(title);
+  EpgStrings->Release(shortText);
+  EpgDescriptions->Release(description);
   delete components;
 }
 
+void *cEvent::operator new(size_t Size)
+{
+  return Size == sizeof(cEvent) ? EventArena->Alloc() : ::operator new(Size);
+}
+
+void cEvent::operator delete(void *Event, size_t Size)
+{
+  if (Size == sizeof(cEvent))
+     EventArena->Free(Event);
+  else
+     ::operator delete(Event);
+}
+
 int cEvent::Compare(const cListObject &ListObject) const
 {
   cEvent *e = (cEvent *)&ListObject;
@@ -156,12 +1389,14 @@ void cEvent::SetEventID(tEventID EventID)
      eventID = EventID;
      if (schedule)
         schedule->HashEvent(this);
+     SetChanged();
      }
 }
 
 void cEvent::SetTableID(uchar TableID)
 {
   tableID = TableID;
+  SetChanged();
 }
 
 void cEvent::SetVersion(uchar Version)
@@ -173,39 +1408,61 @@ void cEvent::SetRunningStatus(int RunningStatus, cChannel *Channel)
 {
   if (Channel && runningStatus != RunningStatus && (RunningStatus > SI::RunningStatusNotRunning || runningStatus > SI::RunningStatusUndefined) && Channel->HasTimer())
      isyslog("channel %d (%s) event %s status %d", Channel->Number(), Channel->Name(), *ToDescr(), RunningStatus);
+  if (schedule && runningStatus != RunningStatus)
+     schedule->publish = true;
   runningStatus = RunningStatus;
 }
 
+const char *cEvent::Description(void) const
+{
+  return EpgDescriptions->Text(description);
+}
+
 void cEvent::SetTitle(const char *Title)
 {
-  title = strcpyrealloc(title, Title);
+  char *Old = title;
+  title = EpgStrings->Set(title, Title);
+  if (indexSlot && title != Old)
+     EpgIndex->Update(this);
+  SetChanged();
 }
 
 void cEvent::SetShortText(const char *ShortText)
 {
-  shortText = strcpyrealloc(shortText, ShortText);
+  char *Old = shortText;
+  shortText = EpgStrings->Set(shortText, ShortText);
+  if (indexSlot && shortText != Old)
+     EpgIndex->Update(this);
+  SetChanged();
 }
 
 void cEvent::SetDescription(const char *Description)
 {
-  description = strcpyrealloc(description, Description);
+  tEpgDescription *Old = description;
+  description = EpgDescriptions->Set(description, Description);
+  if (indexSlot && description != Old)
+     EpgIndex->Update(this);
+  SetChanged();
 }
 
 void cEvent::SetComponents(cComponents *Components)
 {
   delete components;
   components = Components;
+  SetChanged();
 }
 
 void cEvent::SetContents(uchar *Contents)
 {
   for (int i = 0; i < MaxEventContents; i++)
       contents[i] = Contents[i];
+  SetChanged();
 }
 
 void cEvent::SetParentalRating(int ParentalRating)
 {
   parentalRating = ParentalRating;
+  SetChanged();
 }
 
 void cEvent::SetStartTime(time_t StartTime)
@@ -216,17 +1473,31 @@ void cEvent::SetStartTime(time_t StartTime)
      startTime = StartTime;
      if (schedule)
         schedule->HashEvent(this);
+     SetChanged();
      }
 }
 
 void cEvent::SetDuration(int Duration)
 {
-  duration = Duration;
+  if (duration != Duration) {
+     duration = Duration;
+     if (schedule && duration > schedule->maxDuration)
+        schedule->maxDuration = duration;
+     SetChanged();
+     }
 }
 
 void cEvent::SetVps(time_t Vps)
 {
   vps = Vps;
+  SetChanged();
+}
+
+void cEvent::SetChanged(void)
+{
+  changed = true;
+  if (schedule)
+     schedule->changed = schedule->publish = true;
 }
 
 void cEvent::SetSeen(void)
@@ -436,10 +1707,19 @@ void cEvent::Dump(FILE *f, const char *Prefix, bool InfoOnly) const
         fprintf(f, "%sT %s\n", Prefix, title);
      if (!isempty(shortText))
         fprintf(f, "%sS %s\n", Prefix, shortText);
-     if (!isempty(description)) {
-        strreplace(description, '\n', '|');
-        fprintf(f, "%sD %s\n", Prefix, description);
-        strreplace(description, '|', '\n');
+     cString Description = EpgDescriptions->Copy(description); // doesn't keep it unpacked
+     if (!isempty(Description)) {
+        // The description may be shared with other events, so the newlines
+        // can't be replaced in place:
+        fprintf(f, "%sD ", Prefix);
+        for (const char *p = Description; *p; ) {
+            const char *e = strchrnul(p, '\n');
+            fwrite(p, 1, e - p, f);
+            if (*e)
+               fputc('|', f);
+            p = *e ? e + 1 : e;
+            }
+        fputc('\n', f);
         }
      if (contents[0]) {
         fprintf(f, "%sG", Prefix);
@@ -538,6 +1818,16 @@ bool cEvent::Read(FILE *f, cSchedule *Schedule)
                              }
                           }
                        break;
+             case 'O': if (!Event) {
+                          unsigned int EventID;
+                          time_t StartTime;
+                          if (sscanf(t, "%u %ld", &EventID, &StartTime) == 2) {
+                             cEvent *Outdated = (cEvent *)Schedule->GetEvent(EventID, StartTime);
+                             if (Outdated)
+                                Schedule->PhaseOut(Outdated);
+                             }
+                          }
+                       break;
              case 'e': if (Event && !Event->Title())
                           Event->SetTitle(tr("No title"));
                        Event = NULL;
@@ -632,6 +1922,21 @@ void ReportEpgBugFixStats(bool Reset)
 
 void cEvent::FixEpgBugs(void)
 {
+  // The fixes modify the texts in place, so they work on private copies:
+  char *Title = title;
+  char *ShortText = shortText;
+  tEpgDescription *Description = this->description;
+  title = EpgStrings->Detach(Title);
+  shortText = EpgStrings->Detach(ShortText);
+  char *description = EpgDescriptions->Detach(Description); // the fixes below work on this instead of the member
+  int NumComponents = components ? components->NumComponents() : 0;
+  char *ComponentDescriptions[max(NumComponents, 1)];
+  for (int i = 0; i < NumComponents; i++) {
+      tComponent *p = components->Component(i);
+      ComponentDescriptions[i] = p->description;
+      p->description = EpgStrings->Detach(p->description);
+      }
+
   if (isempty(title)) {
      // we don't want any "(null)" titles
      title = strcpyrealloc(title, tr("No title"));
@@ -826,28 +2131,623 @@ void cEvent::FixEpgBugs(void)
          }
      }
 
-Final:
+Final:
+
+  // VDR can't usefully handle newline characters in the title, shortText or component description of EPG
+  // data, so let's always convert them to blanks (independent of the setting of EPGBugfixLevel):
+  strreplace(title, '\n', ' ');
+  strreplace(shortText, '\n', ' ');
+  if (components) {
+     for (int i = 0; i < components->NumComponents(); i++) {
+         tComponent *p = components->Component(i);
+         if (p->description)
+            strreplace(p->description, '\n', ' ');
+         }
+     }
+  /* TODO adapt to UTF-8
+  // Same for control characters:
+  strreplace(title, '\x86', ' ');
+  strreplace(title, '\x87', ' ');
+  strreplace(shortText, '\x86', ' ');
+  strreplace(shortText, '\x87', ' ');
+  strreplace(description, '\x86', ' ');
+  strreplace(description, '\x87', ' ');
+  XXX*/
+
+  title = EpgStrings->Adopt(title, Title);
+  shortText = EpgStrings->Adopt(shortText, ShortText);
+  this->description = EpgDescriptions->Adopt(description, Description);
+  for (int i = 0; i < NumComponents; i++) {
+      tComponent *p = components->Component(i);
+      p->description = EpgStrings->Adopt(p->description, ComponentDescriptions[i]);
+      }
+  if (indexSlot && (title != Title || shortText != ShortText || this->description != Description))
+     EpgIndex->Update(this);
+}
+
+// --- cEpgSnapshot ----------------------------------------------------------
+
+// The binary EPG data file starts with a header, followed by a directory
+// of the schedules it contains. Each schedule has its own section, which
+// consists of a tEpgSnapshotSection, the events, their components and the
+// strings they refer to. Identical strings are only stored once per section.
+// All values are in the byte order of the machine that wrote the file, and
+// all parts are aligned to 8 bytes, so that the file can be used directly
+// after mapping it into memory. Since the sections are self-contained, those
+// of schedules that haven't been accessed can be copied verbatim when the
+// file is written again.
+
+#define EPGSNAPSHOTMAGIC     "VDREPGB" // including the terminating 0 this takes 8 bytes
+#define EPGSNAPSHOTVERSION   1
+#define EPGSNAPSHOTBYTEORDER 0x01020304
+
+struct tEpgSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t numSchedules;
+  uint32_t reserved;
+  int64_t created;
+  };
+
+struct tEpgSnapshotSchedule {
+  int32_t source, nid, tid, sid, rid;
+  uint32_t numEvents;
+  uint64_t offset; // of the section, from the beginning of the file
+  uint64_t size;   // of the section
+  };
+
+struct tEpgSnapshotSection {
+  uint32_t numEvents;
+  uint32_t numComponents;
+  uint32_t stringsSize;
+  uint32_t reserved;
+  };
+
+struct tEpgSnapshotEvent {
+  int64_t startTime;
+  int64_t vps;
+  uint32_t eventID;
+  int32_t duration;
+  uint32_t title, shortText, description; // offsets into the strings, 0 = none
+  uint32_t firstComponent;
+  uint16_t numComponents;
+  uchar tableID;
+  uchar version;
+  uchar parentalRating;
+  uchar reserved;
+  uchar contents[MaxEventContents];
+  };
+
+struct tEpgSnapshotComponent {
+  uint32_t description; // offset into the strings, 0 = none
+  uchar stream;
+  uchar type;
+  char language[MAXLANGCODE2];
+  };
+
+#define EPGSNAPSHOTALIGN(n) (((n) + 7) & ~7)
+
+class cEpgSnapshotBuffer {
+private:
+  uchar *data;
+  int size;
+  int allocated;
+public:
+  cEpgSnapshotBuffer(void) { data = NULL; size = allocated = 0; }
+  ~cEpgSnapshotBuffer() { free(data); }
+  uchar *Data(void) { return data; }
+  int Size(void) const { return size; }
+  void Clear(void) { size = 0; }
+  int Append(const void *Data, int Length);
+       ///< Appends Length bytes of Data (or zeros if Data is NULL) and returns
+       ///< the offset they have been stored at.
+  void Align(void) { Append(NULL, EPGSNAPSHOTALIGN(size) - size); }
+  };
+
+int cEpgSnapshotBuffer::Append(const void *Data, int Length)
+{
+  if (size + Length > allocated) {
+     int NewAllocated = max(size + Length, max(allocated * 2, KILOBYTE(64)));
+     uchar *NewData = (uchar *)realloc(data, NewAllocated);
+     if (!NewData) {
+        esyslog("ERROR: out of memory - abort!");
+        abort();
+        }
+     data = NewData;
+     allocated = NewAllocated;
+     }
+  if (Data)
+     memcpy(data + size, Data, Length);
+  else
+     memset(data + size, 0, Length);
+  int Offset = size;
+  size += Length;
+  return Offset;
+}
+
+class cEpgSnapshotStrings {
+private:
+  cEpgSnapshotBuffer strings;
+  uint32_t *table; // offsets of the strings, hashed by their contents
+  int tableSize;
+  int count;
+  static uint32_t Hash(const char *s);
+  void Grow(void);
+public:
+  cEpgSnapshotStrings(void);
+  ~cEpgSnapshotStrings() { free(table); }
+  void Clear(void);
+  uint32_t Add(const char *s);
+       ///< Returns the offset of s in the strings, storing it if it isn't
+       ///< there yet. Empty strings and NULL are stored as 0.
+  cEpgSnapshotBuffer &Strings(void) { return strings; }
+  };
+
+cEpgSnapshotStrings::cEpgSnapshotStrings(void)
+{
+  table = NULL;
+  tableSize = count = 0;
+  Clear();
+}
+
+void cEpgSnapshotStrings::Clear(void)
+{
+  strings.Clear();
+  strings.Append("", 1); // offset 0 is reserved for "no string"
+  if (table)
+     memset(table, 0, tableSize * sizeof(uint32_t));
+  count = 0;
+}
+
+uint32_t cEpgSnapshotStrings::Hash(const char *s)
+{
+  uint32_t h = 2166136261u;
+  while (*s)
+        h = (h ^ uchar(*s++)) * 16777619u;
+  return h;
+}
+
+void cEpgSnapshotStrings::Grow(void)
+{
+  int OldSize = tableSize;
+  uint32_t *OldTable = table;
+  tableSize = max(tableSize * 2, 1024);
+  table = (uint32_t *)calloc(tableSize, sizeof(uint32_t));
+  if (!table) {
+     esyslog("ERROR: out of memory - abort!");
+     abort();
+     }
+  for (int i = 0; i < OldSize; i++) {
+      if (uint32_t Offset = OldTable[i]) {
+         int j = Hash((const char *)strings.Data() + Offset) & (tableSize - 1);
+         while (table[j])
+               j = (j + 1) & (tableSize - 1);
+         table[j] = Offset;
+         }
+      }
+  free(OldTable);
+}
+
+uint32_t cEpgSnapshotStrings::Add(const char *s)
+{
+  if (isempty(s))
+     return 0;
+  if (2 * (count + 1) > tableSize)
+     Grow();
+  int i = Hash(s) & (tableSize - 1);
+  while (uint32_t Offset = table[i]) {
+        if (strcmp((const char *)strings.Data() + Offset, s) == 0)
+           return Offset;
+        i = (i + 1) & (tableSize - 1);
+        }
+  count++;
+  return table[i] = strings.Append(s, strlen(s) + 1);
+}
+
+class cEpgSnapshot {
+private:
+  uchar *data;
+  size_t size;
+  int pending; // the number of schedules that haven't been loaded yet
+  static cMutex mutex;
+  static bool Check(const uchar *Section, int Size);
+  static void SetEvent(cEvent *Event, const tEpgSnapshotEvent *e, const tEpgSnapshotComponent *c, const char *Strings);
+       ///< Sets the data of Event (except for its id, start time and duration)
+       ///< from the event record e.
+public:
+  cEpgSnapshot(uchar *Data, size_t Size) { data = Data; size = Size; pending = 0; }
+  ~cEpgSnapshot() { munmap(data, size); }
+  static bool Read(int fd, cSchedules *Schedules);
+       ///< Maps the binary EPG data file fd into memory and assigns its sections
+       ///< to the respective schedules.
+  static bool Load(cSchedule *Schedule);
+       ///< Creates the events of Schedule from its section.
+  static bool Share(const cSchedule *From, cSchedule *To);
+       ///< If From hasn't been loaded yet, To will be loaded from the same
+       ///< section. Returns false if From has already been loaded.
+  static void Release(cSchedule *Schedule);
+       ///< Detaches Schedule, which is being deleted without having been
+       ///< loaded, from its section.
+  static void Build(cSchedules *Schedules, cEpgSnapshotBuffer &Image);
+       ///< Builds the complete binary EPG data file in Image. This is much
+       ///< faster than formatting the events as text, so the caller needs
+       ///< to hold the schedules lock only briefly.
+  static bool WriteText(FILE *f, const uchar *Image);
+       ///< Writes the EPG data in the given Image (as built by Build()) to f
+       ///< in the text format.
+  };
+
+cMutex cEpgSnapshot::mutex;
+
+bool cEpgSnapshot::Check(const uchar *Section, int Size)
+{
+  if (Size < int(sizeof(tEpgSnapshotSection)))
+     return false;
+  const tEpgSnapshotSection *s = (const tEpgSnapshotSection *)Section;
+  uint64_t Events = EPGSNAPSHOTALIGN(sizeof(tEpgSnapshotSection)) + uint64_t(s->numEvents) * sizeof(tEpgSnapshotEvent);
+  uint64_t Components = Events + uint64_t(s->numComponents) * sizeof(tEpgSnapshotComponent);
+  if (Components + s->stringsSize > uint64_t(Size) || s->stringsSize == 0)
+     return false;
+  const char *Strings = (const char *)Section + Components;
+  if (Strings[s->stringsSize - 1])
+     return false; // the last string must be terminated
+  const tEpgSnapshotEvent *e = (const tEpgSnapshotEvent *)(Section + EPGSNAPSHOTALIGN(sizeof(tEpgSnapshotSection)));
+  for (uint32_t i = 0; i < s->numEvents; i++, e++) {
+      if (e->title >= s->stringsSize || e->shortText >= s->stringsSize || e->description >= s->stringsSize)
+         return false;
+      if (uint64_t(e->firstComponent) + e->numComponents > s->numComponents)
+         return false;
+      }
+  const tEpgSnapshotComponent *c = (const tEpgSnapshotComponent *)(Section + Events);
+  for (uint32_t i = 0; i < s->numComponents; i++, c++) {
+      if (c->description >= s->stringsSize || !memchr(c->language, 0, sizeof(c->language)))
+         return false;
+      }
+  return true;
+}
+
+bool cEpgSnapshot::Read(int fd, cSchedules *Schedules)
+{
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  size_t Size = st.st_size;
+  if (Size < sizeof(tEpgSnapshotHeader)) {
+     esyslog("ERROR: binary EPG data file is too short");
+     return false;
+     }
+  uchar *Data = (uchar *)mmap(NULL, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (Data == MAP_FAILED) {
+     LOG_ERROR;
+     return false;
+     }
+  const tEpgSnapshotHeader *h = (const tEpgSnapshotHeader *)Data;
+  if (memcmp(h->magic, EPGSNAPSHOTMAGIC, sizeof(h->magic)) != 0) {
+     esyslog("ERROR: not a binary EPG data file");
+     munmap(Data, Size);
+     return false;
+     }
+  if (h->version != EPGSNAPSHOTVERSION || h->byteOrder != EPGSNAPSHOTBYTEORDER) {
+     esyslog("ERROR: binary EPG data file has version %d and byte order %08X, expected %d and %08X", h->version, h->byteOrder, EPGSNAPSHOTVERSION, EPGSNAPSHOTBYTEORDER);
+     munmap(Data, Size);
+     return false;
+     }
+  if (sizeof(tEpgSnapshotHeader) + uint64_t(h->numSchedules) * sizeof(tEpgSnapshotSchedule) > Size) {
+     esyslog("ERROR: binary EPG data file is truncated");
+     munmap(Data, Size);
+     return false;
+     }
+  cEpgSnapshot *Snapshot = new cEpgSnapshot(Data, Size);
+  cMutexLock MutexLock(&mutex);
+  const tEpgSnapshotSchedule *d = (const tEpgSnapshotSchedule *)(Data + sizeof(tEpgSnapshotHeader));
+  for (uint32_t i = 0; i < h->numSchedules; i++, d++) {
+      if (d->offset + d->size > Size || (d->offset | d->size) % 8 || !Check(Data + d->offset, d->size)) {
+         esyslog("ERROR: invalid section %d in binary EPG data file", i);
+         continue;
+         }
+      tChannelID ChannelID(d->source, d->nid, d->tid, d->sid, d->rid);
+      if (!ChannelID.Valid()) {
+         esyslog("ERROR: invalid channel ID: %s", *ChannelID.ToString());
+         continue;
+         }
+      cSchedule *p = Schedules->AddSchedule(ChannelID);
+      if (p && !p->snapshot) {
+         p->snapshot = Snapshot;
+         p->snapshotSection = Data + d->offset;
+         p->snapshotSize = d->size;
+         Snapshot->pending++;
+         if (p->events.First())
+            Load(p); // EPG data has already been received for this channel
+         Schedules->SetModified(p);
+         }
+      }
+  if (!Snapshot->pending)
+     delete Snapshot;
+  return true;
+}
+
+void cEpgSnapshot::SetEvent(cEvent *Event, const tEpgSnapshotEvent *e, const tEpgSnapshotComponent *c, const char *Strings)
+{
+  Event->SetTableID(e->tableID);
+  Event->SetTitle(e->title ? Strings + e->title : tr("No title"));
+  Event->SetShortText(e->shortText ? Strings + e->shortText : NULL);
+  Event->SetDescription(e->description ? Strings + e->description : NULL);
+  memcpy(Event->contents, e->contents, sizeof(Event->contents));
+  Event->SetParentalRating(e->parentalRating);
+  Event->SetVps(e->vps);
+  if (e->numComponents) {
+     Event->components = new cComponents;
+     for (int n = 0; n < e->numComponents; n++) {
+         const tEpgSnapshotComponent *p = c + e->firstComponent + n;
+         Event->components->SetComponent(n, p->stream, p->type, p->language, p->description ? Strings + p->description : NULL);
+         }
+     }
+}
 
-  // VDR can't usefully handle newline characters in the title, shortText or component description of EPG
-  // data, so let's always convert them to blanks (independent of the setting of EPGBugfixLevel):
-  strreplace(title, '\n', ' ');
-  strreplace(shortText, '\n', ' ');
-  if (components) {
-     for (int i = 0; i < components->NumComponents(); i++) {
-         tComponent *p = components->Component(i);
-         if (p->description)
-            strreplace(p->description, '\n', ' ');
+bool cEpgSnapshot::Load(cSchedule *Schedule)
+{
+  cMutexLock MutexLock(&mutex);
+  cEpgSnapshot *Snapshot = Schedule->snapshot;
+  if (!Snapshot)
+     return false; // somebody else was faster
+  const tEpgSnapshotSection *s = (const tEpgSnapshotSection *)Schedule->snapshotSection;
+  const tEpgSnapshotEvent *e = (const tEpgSnapshotEvent *)(Schedule->snapshotSection + EPGSNAPSHOTALIGN(sizeof(tEpgSnapshotSection)));
+  const tEpgSnapshotComponent *c = (const tEpgSnapshotComponent *)(e + s->numEvents);
+  const char *Strings = (const char *)(c + s->numComponents);
+  bool Merge = Schedule->events.First() != NULL;
+  time_t Linger = time(NULL) - Setup.EPGLinger * 60;
+  for (uint32_t i = 0; i < s->numEvents; i++, e++) {
+      if (e->startTime + e->duration < Linger)
+         continue; // the text format doesn't keep these, either
+      cEvent *Event = NULL;
+      if (Merge) {
+         // Like in cEvent::Read(), this is what cSchedule::GetEvent() does:
+         Event = e->startTime > 0 ? Schedule->eventsHashStartTime.Get(e->startTime) : Schedule->eventsHashID.Get(e->eventID);
+         if (Event) {
+            DELETENULL(Event->components);
+            Event->SetStartTime(e->startTime);
+            Event->SetDuration(e->duration);
+            SetEvent(Event, e, c, Strings);
+            }
+         }
+      if (!Event) {
+         Event = new cEvent(e->eventID);
+         Event->seen = 0;
+         Event->startTime = e->startTime;
+         Event->duration = e->duration;
+         SetEvent(Event, e, c, Strings);
+         // Not using AddEvent() here, because that would want to load this schedule:
+         Schedule->events.Add(Event);
+         Event->schedule = Schedule;
+         Schedule->HashEvent(Event);
+         Schedule->maxDuration = max(Schedule->maxDuration, Event->duration);
+         Event->changed = false; // it is in the EPG data file
+         if (!Schedule->copy)
+            EpgIndex->Add(Event);
          }
+      }
+  if (Merge)
+     Schedule->events.Sort();
+  Schedule->snapshot = NULL;
+  if (--Snapshot->pending == 0)
+     delete Snapshot;
+  return true;
+}
+
+bool cEpgSnapshot::Share(const cSchedule *From, cSchedule *To)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!From->snapshot)
+     return false;
+  To->snapshot = From->snapshot;
+  To->snapshotSection = From->snapshotSection;
+  To->snapshotSize = From->snapshotSize;
+  To->snapshot->pending++;
+  return true;
+}
+
+void cEpgSnapshot::Release(cSchedule *Schedule)
+{
+  cMutexLock MutexLock(&mutex);
+  cEpgSnapshot *Snapshot = Schedule->snapshot;
+  if (Snapshot) {
+     Schedule->snapshot = NULL;
+     if (--Snapshot->pending == 0)
+        delete Snapshot;
      }
-  /* TODO adapt to UTF-8
-  // Same for control characters:
-  strreplace(title, '\x86', ' ');
-  strreplace(title, '\x87', ' ');
-  strreplace(shortText, '\x86', ' ');
-  strreplace(shortText, '\x87', ' ');
-  strreplace(description, '\x86', ' ');
-  strreplace(description, '\x87', ' ');
-  XXX*/
+}
+
+void cEpgSnapshot::Build(cSchedules *Schedules, cEpgSnapshotBuffer &Image)
+{
+  tEpgSnapshotHeader Header;
+  memset(&Header, 0, sizeof(Header));
+  strcpy(Header.magic, EPGSNAPSHOTMAGIC);
+  Header.version = EPGSNAPSHOTVERSION;
+  Header.byteOrder = EPGSNAPSHOTBYTEORDER;
+  Header.created = time(NULL);
+  Image.Clear();
+  Image.Append(NULL, sizeof(Header) + Schedules->Count() * sizeof(tEpgSnapshotSchedule)); // filled in below
+  cEpgSnapshotBuffer Components;
+  cEpgSnapshotStrings Strings;
+  time_t Linger = time(NULL) - Setup.EPGLinger * 60;
+  cMutexLock MutexLock(&mutex);
+  for (cSchedule *p = Schedules->First(); p; p = Schedules->Next(p)) {
+      tEpgSnapshotSchedule d;
+      memset(&d, 0, sizeof(d));
+      d.source = p->channelID.Source();
+      d.nid = p->channelID.Nid();
+      d.tid = p->channelID.Tid();
+      d.sid = p->channelID.Sid();
+      d.rid = p->channelID.Rid();
+      d.offset = Image.Size();
+      if (p->snapshot) {
+         // This schedule hasn't been touched since it was read, so there's no need to load it:
+         Image.Append(p->snapshotSection, p->snapshotSize);
+         d.numEvents = ((const tEpgSnapshotSection *)p->snapshotSection)->numEvents;
+         }
+      else {
+         Components.Clear();
+         Strings.Clear();
+         tEpgSnapshotSection s;
+         memset(&s, 0, sizeof(s));
+         Image.Append(NULL, EPGSNAPSHOTALIGN(sizeof(s))); // filled in below
+         for (const cEvent *Event = p->events.First(); Event; Event = p->events.Next(Event)) {
+             if (Event->EndTime() < Linger)
+                continue; // see cEvent::Dump()
+             tEpgSnapshotEvent e;
+             memset(&e, 0, sizeof(e));
+             e.startTime = Event->startTime;
+             e.vps = Event->vps;
+             e.eventID = Event->eventID;
+             e.duration = Event->duration;
+             e.title = Strings.Add(Event->title);
+             e.shortText = Strings.Add(Event->shortText);
+             e.description = Strings.Add(EpgDescriptions->Copy(Event->description));
+             e.firstComponent = s.numComponents;
+             if (Event->components) {
+                for (int i = 0; i < Event->components->NumComponents(); i++) {
+                    tComponent *Component = Event->components->Component(i);
+                    tEpgSnapshotComponent c;
+                    memset(&c, 0, sizeof(c));
+                    c.description = Strings.Add(Component->description);
+                    c.stream = Component->stream;
+                    c.type = Component->type;
+                    strn0cpy(c.language, Component->language, sizeof(c.language));
+                    Components.Append(&c, sizeof(c));
+                    s.numComponents++;
+                    e.numComponents++;
+                    }
+                }
+             e.tableID = Event->tableID;
+             e.version = Event->version;
+             e.parentalRating = Event->parentalRating;
+             memcpy(e.contents, Event->contents, sizeof(e.contents));
+             Image.Append(&e, sizeof(e));
+             s.numEvents++;
+             }
+         Image.Append(Components.Data(), Components.Size());
+         s.stringsSize = Strings.Strings().Size();
+         Image.Append(Strings.Strings().Data(), s.stringsSize);
+         Image.Align();
+         memcpy(Image.Data() + d.offset, &s, sizeof(s));
+         d.numEvents = s.numEvents;
+         }
+      d.size = Image.Size() - d.offset;
+      memcpy(Image.Data() + sizeof(Header) + Header.numSchedules * sizeof(d), &d, sizeof(d));
+      Header.numSchedules++;
+      }
+  memcpy(Image.Data(), &Header, sizeof(Header));
+}
+
+bool cEpgSnapshot::WriteText(FILE *f, const uchar *Image)
+{
+  const tEpgSnapshotHeader *h = (const tEpgSnapshotHeader *)Image;
+  const tEpgSnapshotSchedule *d = (const tEpgSnapshotSchedule *)(Image + sizeof(tEpgSnapshotHeader));
+  for (uint32_t i = 0; i < h->numSchedules; i++, d++) {
+      tChannelID ChannelID(d->source, d->nid, d->tid, d->sid, d->rid);
+      cString ChannelName;
+      if (Channels.Lock(false)) {
+         if (cChannel *Channel = Channels.GetByChannelID(ChannelID, true)) {
+            ChannelID = Channel->GetChannelID();
+            ChannelName = Channel->Name();
+            }
+         Channels.Unlock();
+         }
+      if (!*ChannelName)
+         continue; // see cSchedule::Dump()
+      fprintf(f, "C %s %s\n", *ChannelID.ToString(), *ChannelName);
+      const tEpgSnapshotSection *s = (const tEpgSnapshotSection *)(Image + d->offset);
+      const tEpgSnapshotEvent *e = (const tEpgSnapshotEvent *)(Image + d->offset + EPGSNAPSHOTALIGN(sizeof(tEpgSnapshotSection)));
+      const tEpgSnapshotComponent *c = (const tEpgSnapshotComponent *)(e + s->numEvents);
+      const char *Strings = (const char *)(c + s->numComponents);
+      for (uint32_t n = 0; n < s->numEvents; n++, e++) {
+          cEvent Event(e->eventID);
+          Event.startTime = e->startTime;
+          Event.duration = e->duration;
+          SetEvent(&Event, e, c, Strings);
+          Event.version = e->version;
+          Event.Dump(f);
+          }
+      fprintf(f, "c\n");
+      }
+  return !ferror(f);
+}
+
+// --- cEpgDataWriter --------------------------------------------------------
+
+class cEpgDataWriter : public cThread {
+private:
+  cEpgSnapshotBuffer *image;
+  cString fileName;
+  bool binary;
+  bool ok;
+protected:
+  virtual void Action(void);
+public:
+  cEpgDataWriter(void);
+  virtual ~cEpgDataWriter();
+  void Write(cEpgSnapshotBuffer *Image, const char *FileName, bool Binary);
+       ///< Writes the given Image (as built by cEpgSnapshot::Build()) to the
+       ///< file with the given name in a separate thread, so that the schedules
+       ///< don't need to be locked while formatting and writing the data.
+       ///< Takes ownership of Image.
+  bool Ok(void) { return ok; }
+       ///< Returns false if writing the last file has failed.
+  };
+
+static cEpgDataWriter EpgDataWriter;
+
+cEpgDataWriter::cEpgDataWriter(void)
+:cThread("epg data writer")
+{
+  image = NULL;
+  binary = false;
+  ok = true;
+}
+
+cEpgDataWriter::~cEpgDataWriter()
+{
+  Cancel(3);
+  delete image;
+}
+
+void cEpgDataWriter::Write(cEpgSnapshotBuffer *Image, const char *FileName, bool Binary)
+{
+  delete image;
+  image = Image;
+  fileName = FileName;
+  binary = Binary;
+  Start();
+}
+
+void cEpgDataWriter::Action(void)
+{
+  SetPriority(19);
+  SetIOPriority(7);
+  cTimeMs Timer;
+  cSafeFile f(fileName);
+  ok = f.Open();
+  if (ok) {
+     if (binary)
+        ok = image->Size() == 0 || fwrite(image->Data(), image->Size(), 1, f) == 1;
+     else
+        ok = cEpgSnapshot::WriteText(f, image->Data());
+     if (!f.Close())
+        ok = false;
+     }
+  if (ok) {
+     dsyslog("wrote EPG data to %s in %lld ms", *fileName, (long long)Timer.Elapsed());
+     // The journal is obsolete now:
+     cString JournalFileName = cString::sprintf("%s%s", *fileName, EPGJOURNALEXTENSION);
+     if (unlink(JournalFileName) < 0 && errno != ENOENT)
+        LOG_ERROR_STR(*JournalFileName);
+     }
+  else
+     LOG_ERROR_STR(*fileName);
+  DELETENULL(image);
 }
 
 // --- cSchedule -------------------------------------------------------------
@@ -855,16 +2755,49 @@ Final:
 cSchedule::cSchedule(tChannelID ChannelID)
 {
   channelID = ChannelID;
+  copy = false;
+  maxDuration = 0;
+  timelineValid = false;
+  runningEvent = NULL;
   hasRunning = false;
   modified = 0;
   presentSeen = 0;
+  changed = false;
+  publish = false;
+  snapshot = NULL;
+  snapshotSection = NULL;
+  snapshotSize = 0;
+}
+
+cSchedule::~cSchedule()
+{
+  if (snapshot)
+     cEpgSnapshot::Release(this);
+  if (copy) {
+     for (cEvent *p = events.First(); p; p = events.Next(p))
+         EpgDescriptions->Pin(p->description, false);
+     }
+}
+
+void cSchedule::LoadSnapshot(void) const
+{
+  cEpgSnapshot::Load((cSchedule *)this);
+  if (copy) {
+     // a copy is read without holding the lock:
+     for (cEvent *p = events.First(); p; p = events.Next(p))
+         EpgDescriptions->Pin(p->description, true);
+     }
 }
 
 cEvent *cSchedule::AddEvent(cEvent *Event)
 {
+  Load();
   events.Add(Event);
   Event->schedule = this;
   HashEvent(Event);
+  Event->SetChanged();
+  if (!copy)
+     EpgIndex->Add(Event);
   return Event;
 }
 
@@ -873,8 +2806,12 @@ void cSchedule::DelEvent(cEvent *Event)
   if (Event->schedule == this) {
      if (hasRunning && Event->IsRunning())
         ClrRunningStatus();
+     if (Event == runningEvent)
+        runningEvent = NULL;
      UnhashEvent(Event);
+     Outdate(Event);
      events.Del(Event);
+     publish = true;
      }
 }
 
@@ -883,6 +2820,7 @@ void cSchedule::HashEvent(cEvent *Event)
   eventsHashID.Add(Event, Event->EventID());
   if (Event->StartTime() > 0) // 'StartTime < 0' is apparently used with NVOD channels
      eventsHashStartTime.Add(Event, Event->StartTime());
+  timelineValid = false;
 }
 
 void cSchedule::UnhashEvent(cEvent *Event)
@@ -890,40 +2828,86 @@ void cSchedule::UnhashEvent(cEvent *Event)
   eventsHashID.Del(Event, Event->EventID());
   if (Event->StartTime() > 0) // 'StartTime < 0' is apparently used with NVOD channels
      eventsHashStartTime.Del(Event, Event->StartTime());
+  timelineValid = false;
+}
+
+static int CompareEventStartTimes(const void *a, const void *b)
+{
+  time_t t1 = (*(const cEvent **)a)->StartTime();
+  time_t t2 = (*(const cEvent **)b)->StartTime();
+  return t1 < t2 ? -1 : t1 > t2 ? 1 : 0;
+}
+
+static cMutex TimelineMutex; // several threads may read the same schedule at the same time
+
+void cSchedule::UpdateTimeline(void) const
+{
+  Load();
+  if (!timelineValid) {
+     cMutexLock MutexLock(&TimelineMutex);
+     if (!timelineValid) {
+        timeline.Clear();
+        maxDuration = 0;
+        bool Sorted = true;
+        for (cEvent *p = events.First(); p; p = events.Next(p)) {
+            if (p->StartTime() > 0) { // 'StartTime < 0' is apparently used with NVOD channels, and phased out events have 0
+               if (timeline.Size() && p->StartTime() < timeline[timeline.Size() - 1]->StartTime())
+                  Sorted = false;
+               timeline.Append(p);
+               maxDuration = max(maxDuration, p->Duration());
+               }
+            }
+        if (!Sorted)
+           timeline.Sort(CompareEventStartTimes);
+        timelineValid = true;
+        }
+     }
+}
+
+int cSchedule::CountStartedBy(time_t Time) const
+{
+  UpdateTimeline();
+  int Low = 0;
+  int High = timeline.Size();
+  while (Low < High) {
+        int Mid = (Low + High) / 2;
+        if (timeline[Mid]->StartTime() <= Time)
+           Low = Mid + 1;
+        else
+           High = Mid;
+        }
+  return Low;
 }
 
 const cEvent *cSchedule::GetPresentEvent(void) const
 {
-  const cEvent *pe = NULL;
   time_t now = time(NULL);
-  for (cEvent *p = events.First(); p; p = events.Next(p)) {
-      if (p->StartTime() <= now)
-         pe = p;
-      else if (p->StartTime() > now + 3600)
-         break;
-      if (p->SeenWithin(RUNNINGSTATUSTIMEOUT) && p->RunningStatus() >= SI::RunningStatusPausing)
-         return p;
-      }
-  return pe;
+  if (hasRunning && runningEvent && runningEvent->StartTime() <= now + 3600 && runningEvent->SeenWithin(RUNNINGSTATUSTIMEOUT) && runningEvent->RunningStatus() >= SI::RunningStatusPausing)
+     return runningEvent;
+  int i = CountStartedBy(now);
+  return i > 0 ? timeline[i - 1] : NULL;
 }
 
 const cEvent *cSchedule::GetFollowingEvent(void) const
 {
   const cEvent *p = GetPresentEvent();
-  if (p)
-     p = events.Next(p);
-  else {
-     time_t now = time(NULL);
-     for (p = events.First(); p; p = events.Next(p)) {
-         if (p->StartTime() >= now)
-            break;
+  if (p) {
+     if (p->StartTime() <= 0)
+        return events.Next(p);
+     // Start times are practically unique, but let's make sure we find the right one:
+     for (int i = CountStartedBy(p->StartTime()) - 1; i >= 0 && timeline[i]->StartTime() == p->StartTime(); i--) {
+         if (timeline[i] == p)
+            return i + 1 < timeline.Size() ? timeline[i + 1] : NULL;
          }
+     return events.Next(p);
      }
-  return p;
+  int i = CountStartedBy(time(NULL) - 1);
+  return i < timeline.Size() ? timeline[i] : NULL;
 }
 
 const cEvent *cSchedule::GetEvent(tEventID EventID, time_t StartTime) const
 {
+  Load();
   // Returns the event info with the given StartTime or, if no actual StartTime
   // is given, the one with the given EventID.
   if (StartTime > 0) // 'StartTime < 0' is apparently used with NVOD channels
@@ -934,32 +2918,50 @@ const cEvent *cSchedule::GetEvent(tEventID EventID, time_t StartTime) const
 
 const cEvent *cSchedule::GetEventAround(time_t Time) const
 {
-  const cEvent *pe = NULL;
-  time_t delta = INT_MAX;
-  for (cEvent *p = events.First(); p; p = events.Next(p)) {
-      time_t dt = Time - p->StartTime();
-      if (dt >= 0 && dt < delta && p->EndTime() >= Time) {
-         delta = dt;
-         pe = p;
+  // The event that started last before Time and hasn't ended yet; since no
+  // event lasts longer than maxDuration, there's no need to look further back:
+  for (int i = CountStartedBy(Time) - 1; i >= 0 && timeline[i]->StartTime() + maxDuration >= Time; i--) {
+      if (timeline[i]->EndTime() >= Time)
+         return timeline[i];
+      }
+  return NULL;
+}
+
+int cSchedule::GetEvents(time_t From, time_t To, cVector<const cEvent *> &Events) const
+{
+  int n = 0;
+  int Last = CountStartedBy(To);
+  // Events that started before From may still be running:
+  for (int i = CountStartedBy(From - maxDuration - 1); i < Last; i++) {
+      if (timeline[i]->EndTime() >= From) {
+         Events.Append(timeline[i]);
+         n++;
          }
       }
-  return pe;
+  return n;
 }
 
 void cSchedule::SetRunningStatus(cEvent *Event, int RunningStatus, cChannel *Channel)
 {
   hasRunning = false;
+  runningEvent = NULL;
   for (cEvent *p = events.First(); p; p = events.Next(p)) {
       if (p == Event) {
          if (p->RunningStatus() > SI::RunningStatusNotRunning || RunningStatus > SI::RunningStatusNotRunning) {
             p->SetRunningStatus(RunningStatus, Channel);
+            if (!hasRunning && RunningStatus >= SI::RunningStatusPausing) {
+               hasRunning = true;
+               runningEvent = p;
+               }
             break;
             }
          }
       else if (RunningStatus >= SI::RunningStatusPausing && p->StartTime() < Event->StartTime())
          p->SetRunningStatus(SI::RunningStatusNotRunning);
-      if (p->RunningStatus() >= SI::RunningStatusPausing)
+      if (!hasRunning && p->RunningStatus() >= SI::RunningStatusPausing) {
          hasRunning = true;
+         runningEvent = p;
+         }
       }
 }
 
@@ -970,6 +2972,7 @@ void cSchedule::ClrRunningStatus(cChannel *Channel)
          if (p->RunningStatus() >= SI::RunningStatusPausing) {
             p->SetRunningStatus(SI::RunningStatusNotRunning, Channel);
             hasRunning = false;
+            runningEvent = NULL;
             break;
             }
          }
@@ -978,13 +2981,16 @@ void cSchedule::ClrRunningStatus(cChannel *Channel)
 
 void cSchedule::ResetVersions(void)
 {
+  Load();
   for (cEvent *p = events.First(); p; p = events.Next(p))
       p->SetVersion(0xFF);
 }
 
 void cSchedule::Sort(void)
 {
+  Load();
   events.Sort();
+  UpdateTimeline();
   // Make sure there are no RunningStatusUndefined before the currently running event:
   if (hasRunning) {
      for (cEvent *p = events.First(); p; p = events.Next(p)) {
@@ -997,6 +3003,7 @@ void cSchedule::Sort(void)
 
 void cSchedule::DropOutdated(time_t SegmentStart, time_t SegmentEnd, uchar TableID, uchar Version)
 {
+  Load();
   if (SegmentStart > 0 && SegmentEnd > 0) {
      for (cEvent *p = events.First(); p; p = events.Next(p)) {
          if (p->EndTime() > SegmentStart) {
@@ -1005,14 +3012,7 @@ void cSchedule::DropOutdated(time_t SegmentStart, time_t SegmentEnd, uchar Table
                if (p->TableID() > TableID || p->TableID() == TableID && p->Version() != Version) {
                   // The segment overwrites all events from tables with higher ids, and
                   // within the same table id all events must have the same version.
-                  // We can't delete the event right here because a timer might have
-                  // a pointer to it, so let's set its id and start time to 0 to have it
-                  // "phased out":
-                  if (hasRunning && p->IsRunning())
-                     ClrRunningStatus();
-                  UnhashEvent(p);
-                  p->eventID = 0;
-                  p->startTime = 0;
+                  PhaseOut(p);
                   }
                }
             else
@@ -1022,6 +3022,100 @@ void cSchedule::DropOutdated(time_t SegmentStart, time_t SegmentEnd, uchar Table
      }
 }
 
+void cSchedule::PhaseOut(cEvent *Event)
+{
+  if (hasRunning && Event->IsRunning())
+     ClrRunningStatus();
+  if (Event == runningEvent)
+     runningEvent = NULL;
+  UnhashEvent(Event);
+  if (Event->indexSlot)
+     EpgIndex->Del(Event);
+  Outdate(Event);
+  Event->eventID = 0;
+  Event->startTime = 0;
+  publish = true;
+}
+
+void cSchedule::Outdate(const cEvent *Event)
+{
+  if (Setup.EPGJournal && (Event->startTime > 0 || Event->eventID)) {
+     outdated.Append(strdup(cString::sprintf("%u %ld", Event->eventID, Event->startTime)));
+     changed = true;
+     }
+}
+
+void cSchedule::WriteJournal(FILE *f)
+{
+  if (changed) {
+     cChannel *channel = Channels.GetByChannelID(channelID, true);
+     fprintf(f, "C %s %s\n", *channelID.ToString(), channel ? channel->Name() : "");
+     // Outdated events go first, because a changed event may have taken the place of one:
+     for (int i = 0; i < outdated.Size(); i++)
+         fprintf(f, "O %s\n", outdated[i]);
+     for (cEvent *p = events.First(); p; p = events.Next(p)) {
+         if (p->changed)
+            p->Dump(f);
+         }
+     fprintf(f, "c\n");
+     ClrChanged();
+     }
+}
+
+void cSchedule::ClrChanged(void)
+{
+  if (changed) {
+     for (cEvent *p = events.First(); p; p = events.Next(p))
+         p->changed = false;
+     outdated.Clear();
+     changed = false;
+     }
+}
+
+cSchedule *cSchedule::Copy(const cEvent *OnlyEvent) const
+{
+  cSchedule *Schedule = new cSchedule(channelID);
+  Schedule->copy = true;
+  Schedule->hasRunning = hasRunning;
+  Schedule->modified = modified;
+  Schedule->presentSeen = presentSeen;
+  if (!OnlyEvent && cEpgSnapshot::Share(this, Schedule))
+     return Schedule; // both will be loaded from the binary EPG data file when accessed
+  for (cEvent *p = OnlyEvent ? (cEvent *)OnlyEvent : events.First(); p; p = OnlyEvent ? NULL : events.Next(p)) {
+      if (!p->eventID && !p->startTime)
+         continue; // phased out
+      cEvent *Event = new cEvent(p->eventID);
+      Event->changed = false;
+      Event->tableID = p->tableID;
+      Event->version = p->version;
+      Event->runningStatus = p->runningStatus;
+      Event->parentalRating = p->parentalRating;
+      Event->title = EpgStrings->AddRef(p->title);
+      Event->shortText = EpgStrings->AddRef(p->shortText);
+      Event->description = EpgDescriptions->AddRef(p->description);
+      EpgDescriptions->Pin(Event->description, true); // the copy is read without holding the lock
+      if (p->components) {
+         Event->components = new cComponents;
+         for (int i = 0; i < p->components->NumComponents(); i++) {
+             tComponent *c = p->components->Component(i);
+             Event->components->SetComponent(i, c->stream, c->type, c->language, c->description);
+             }
+         }
+      memcpy(Event->contents, p->contents, sizeof(Event->contents));
+      Event->startTime = p->startTime;
+      Event->duration = p->duration;
+      Event->vps = p->vps;
+      Event->seen = p->seen;
+      Schedule->events.Add(Event);
+      Event->schedule = Schedule;
+      Schedule->HashEvent(Event);
+      if (p == runningEvent)
+         Schedule->runningEvent = Event;
+      }
+  Schedule->UpdateTimeline(); // so that readers don't have to
+  return Schedule;
+}
+
 void cSchedule::Cleanup(void)
 {
   Cleanup(time(NULL));
@@ -1029,6 +3123,7 @@ void cSchedule::Cleanup(void)
 
 void cSchedule::Cleanup(time_t Time)
 {
+  Load();
   cEvent *Event;
   while ((Event = events.First()) != NULL) {
         if (!Event->HasTimer() && Event->EndTime() + Setup.EPGLinger * 60 + 3600 < Time) // adding one hour for safety
@@ -1040,6 +3135,7 @@ void cSchedule::Cleanup(time_t Time)
 
 void cSchedule::Dump(FILE *f, const char *Prefix, eDumpMode DumpMode, time_t AtTime) const
 {
+  Load();
   cChannel *channel = Channels.GetByChannelID(channelID, true);
   if (channel) {
      fprintf(f, "%sC %s %s\n", Prefix, *channel->GetChannelID().ToString(), channel->Name());
@@ -1163,19 +3259,97 @@ void cSchedules::Cleanup(bool Force)
             p->Cleanup(now);
         }
      lastCleanup = now;
+     dsyslog("EPG memory usage: %s", *MemoryStats());
      if (ptm->tm_hour == 5)
         ReportEpgBugFixStats(true);
      }
-  if (epgDataFileName && now - lastDump > 600) {
-     cSafeFile f(epgDataFileName);
-     if (f.Open()) {
-        Dump(f);
-        f.Close();
-        }
-     else
-        LOG_ERROR;
+#ifdef ZLIB
+  if (Setup.EPGCompression && !Force)
+     EpgPacker.Trigger();
+#endif
+  if (Force) {
+     while (EpgDataWriter.Active())
+           cCondWait::SleepMs(10);
+     }
+  if (epgDataFileName && now - lastDump > 600 && !EpgDataWriter.Active()) {
+     // If writing the EPG data file has failed, the journal is missing the
+     // changes that were meant to go into the file, so let's write it again:
+     if (!Setup.EPGJournal || !EpgDataWriter.Ok() || !AppendJournal())
+        Save();
      lastDump = now;
      }
+  if (Force) {
+     // Make sure the data is written before VDR exits:
+     while (EpgDataWriter.Active())
+           cCondWait::SleepMs(10);
+     }
+}
+
+bool cSchedules::Save(void)
+{
+  cEpgSnapshotBuffer *Image = new cEpgSnapshotBuffer;
+  {
+    // When journaling, the changes must be cleared in the same lock as the
+    // image is built in, so that none of them get lost:
+    cSchedulesLock SchedulesLock(Setup.EPGJournal, 1000);
+    cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
+    if (!s) {
+       delete Image;
+       return false;
+       }
+    cTimeMs Timer;
+    cEpgSnapshot::Build(s, *Image);
+    if (Setup.EPGJournal) {
+       for (cSchedule *p = s->First(); p; p = s->Next(p))
+           p->ClrChanged();
+       }
+    dsyslog("copied EPG data in %lld ms", (long long)Timer.Elapsed());
+  }
+  // Formatting and writing the data is done without holding the lock:
+  EpgDataWriter.Write(Image, epgDataFileName, Setup.EPGBinaryData);
+  return true;
+}
+
+bool cSchedules::AppendJournal(void)
+{
+  struct stat Data, Journal;
+  cString JournalFileName = cString::sprintf("%s%s", epgDataFileName, EPGJOURNALEXTENSION);
+  if (stat(epgDataFileName, &Data) < 0)
+     return false;
+  if (stat(JournalFileName, &Journal) == 0 && Journal.st_size > max(Data.st_size / EPGJOURNALMAXRATIO, off_t(EPGJOURNALMINSIZE)))
+     return false; // time to compact the journal into the EPG data file
+  char *Buffer = NULL;
+  size_t Size = 0;
+  {
+    cSchedulesLock SchedulesLock(true, 1000);
+    cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
+    if (!s)
+       return true; // let's try again next time
+    FILE *m = open_memstream(&Buffer, &Size);
+    if (!m) {
+       LOG_ERROR;
+       return false;
+       }
+    for (cSchedule *p = s->First(); p; p = s->Next(p))
+        p->WriteJournal(m);
+    if (fclose(m) != 0) {
+       LOG_ERROR;
+       free(Buffer);
+       return false; // the changes have been cleared, so the EPG data file needs to be written
+       }
+  }
+  // Writing the journal is done without holding the lock:
+  bool Ok = true;
+  if (Size) {
+     FILE *f = fopen(JournalFileName, "a");
+     Ok = f && fwrite(Buffer, Size, 1, f) == 1 && fflush(f) == 0 && fdatasync(fileno(f)) == 0;
+     if (f && fclose(f) != 0)
+        Ok = false;
+     if (!Ok)
+        LOG_ERROR_STR(*JournalFileName);
+     }
+  free(Buffer);
+  return Ok;
 }
 
 void cSchedules::ResetVersions(void)
@@ -1202,6 +3376,11 @@ bool cSchedules::ClearAll(void)
   return false;
 }
 
+cString cSchedules::MemoryStats(void)
+{
+  return cString::sprintf("%s, %s, %s, %s", *EventArena->Stats(), *EpgStrings->Stats(), *EpgDescriptions->Stats(), *EpgIndex->Stats());
+}
+
 bool cSchedules::Dump(FILE *f, const char *Prefix, eDumpMode DumpMode, time_t AtTime)
 {
   cSchedulesLock SchedulesLock;
@@ -1231,9 +3410,29 @@ bool cSchedules::Read(FILE *f)
         else
            return false;
         }
-     bool result = cSchedule::Read(f, s);
-     if (OwnFile)
+     bool result;
+     char Magic[sizeof(EPGSNAPSHOTMAGIC)];
+     if (OwnFile && fread(Magic, sizeof(Magic), 1, f) == 1 && memcmp(Magic, EPGSNAPSHOTMAGIC, sizeof(Magic)) == 0)
+        result = cEpgSnapshot::Read(fileno(f), s);
+     else {
+        if (OwnFile)
+           rewind(f);
+        result = cSchedule::Read(f, s);
+        }
+     if (OwnFile) {
         fclose(f);
+        // Replay the changes that have been made since the file was written:
+        cString JournalFileName = cString::sprintf("%s%s", epgDataFileName, EPGJOURNALEXTENSION);
+        if (result && (f = fopen(JournalFileName, "r")) != NULL) {
+           dsyslog("reading EPG data journal from %s", *JournalFileName);
+           if (!cSchedule::Read(f, s))
+              esyslog("ERROR: EPG data journal %s is damaged, using what could be read", *JournalFileName);
+           fclose(f);
+           }
+        // Everything that has been read is now in the EPG data file or its journal:
+        for (cSchedule *p = s->First(); p; p = s->Next(p))
+            p->ClrChanged();
+        }
      if (result) {
         // Initialize the channels' schedule pointers, so that the first WhatsOn menu will come up faster:
         for (cChannel *Channel = Channels.First(); Channel; Channel = Channels.Next(Channel))
@@ -1285,6 +3484,337 @@ const cSchedule *cSchedules::GetSchedule(const cChannel *Channel, bool AddIfMiss
   return Channel->schedule != &DummySchedule? Channel->schedule : NULL;
 }
 
+int cSchedules::Search(const char *Query, cVector<const cEvent *> &Events, tChannelID ChannelID, time_t From, time_t To, int Fields) const
+{
+  cVector<const cEvent *> Found;
+  if (EpgIndex->Search(this, Query, Found, ChannelID, From, To, Fields)) {
+     Found.Sort(CompareEventStartTimes);
+     for (int i = 0; i < Found.Size(); i++)
+         Events.Append(Found[i]);
+     }
+  return Found.Size();
+}
+
+// --- cScheduleVersions -----------------------------------------------------
+
+class cScheduleVersion : public cListObject {
+public:
+  cSchedule *origin;   // the actual schedule (which is never deleted)
+  cSchedule *schedule; // the published copy, NULL if the origin shall no longer be published
+  int refs;            // the number of cScheduleVersions this version is in
+  bool replaced;       // a newer version has been published
+  time_t published;
+  time_t requested;    // when this schedule was last requested through cSchedulesView::GetSchedule(), 0 = never
+  cScheduleVersion(cSchedule *Origin);
+  ~cScheduleVersion() { delete schedule; }
+  };
+
+cScheduleVersion::cScheduleVersion(cSchedule *Origin)
+{
+  origin = Origin;
+  schedule = NULL;
+  refs = 0;
+  replaced = false;
+  published = time(NULL);
+  requested = 0;
+}
+
+class cScheduleVersions {
+private:
+  cHash<cScheduleVersion> hash;
+public:
+  int refs; // the number of views using these versions, plus one as long as they are the current ones
+  cVector<cScheduleVersion *> versions;
+  cScheduleVersions(void) { refs = 1; }
+  void Add(cScheduleVersion *Version);
+  cScheduleVersion *Get(tChannelID ChannelID) const;
+  };
+
+void cScheduleVersions::Add(cScheduleVersion *Version)
+{
+  versions.Append(Version);
+  hash.Add(Version, Version->origin->ChannelID().Sid());
+  Version->refs++;
+}
+
+cScheduleVersion *cScheduleVersions::Get(tChannelID ChannelID) const
+{
+  ChannelID.ClrRid();
+  cList<cHashObject> *List = hash.GetList(ChannelID.Sid());
+  if (List) {
+     for (cHashObject *h = List->First(); h; h = List->Next(h)) {
+         cScheduleVersion *Version = (cScheduleVersion *)h->Object();
+         if (Version->origin->ChannelID() == ChannelID)
+            return Version;
+         }
+     }
+  return NULL;
+}
+
+// --- cEpgPublisher ---------------------------------------------------------
+
+#define EPGPUBLISHINTERVAL    1000 // ms between checks for changes that need to be published
+#define EPGPUBLISHLOCKTIMEOUT  100 // ms the publisher thread waits for the schedules lock before trying again later
+#define EPGVIEWTIMEOUT         600 // seconds after which a schedule that hasn't been requested is no longer published
+
+class cEpgPublisher : public cThread {
+private:
+  cMutex mutex; // protects 'current', all reference counts, cScheduleVersion::requested and clearing cSchedule::publish
+  cScheduleVersions *current;
+  cScheduleVersion *Copy(cSchedule *Origin, int TimeoutMs);
+       ///< Copies Origin, waiting at most TimeoutMs for the schedules lock (or as
+       ///< long as it takes, if TimeoutMs is 0). Returns NULL if the lock couldn't
+       ///< be obtained.
+protected:
+  virtual void Action(void);
+public:
+  cEpgPublisher(void);
+  ~cEpgPublisher();
+  cScheduleVersions *Acquire(void);
+       ///< Returns the current versions, which must be given back by a call
+       ///< to Release().
+  void Release(cScheduleVersions *Versions);
+  cScheduleVersions *Update(cVector<cScheduleVersion *> &Changes);
+       ///< Publishes the given versions, replacing any earlier versions of the
+       ///< same schedules (or dropping them, if a version has no schedule), and
+       ///< returns the resulting current versions, as Acquire() does.
+  cScheduleVersions *Publish(const tChannelID *ChannelID);
+       ///< Publishes the schedule of the given channel (or all schedules, if
+       ///< no ChannelID is given) that haven't been published yet in one go, and
+       ///< returns the resulting current versions, as Acquire() does.
+       ///< The new versions are only kept up to date once they have actually
+       ///< been requested (see Requested()).
+  void Requested(cScheduleVersion *Version);
+       ///< Marks Version as having been requested just now.
+  };
+
+static cEpgPublisher EpgPublisher;
+
+cEpgPublisher::cEpgPublisher(void)
+:cThread("epg publisher")
+{
+  current = new cScheduleVersions;
+}
+
+cEpgPublisher::~cEpgPublisher()
+{
+  Cancel(3);
+  Release(current);
+}
+
+cScheduleVersions *cEpgPublisher::Acquire(void)
+{
+  cMutexLock MutexLock(&mutex);
+  current->refs++;
+  return current;
+}
+
+void cEpgPublisher::Release(cScheduleVersions *Versions)
+{
+  cVector<cScheduleVersion *> Unused;
+  mutex.Lock();
+  if (--Versions->refs == 0) {
+     for (int i = 0; i < Versions->versions.Size(); i++) {
+         if (--Versions->versions[i]->refs == 0)
+            Unused.Append(Versions->versions[i]);
+         }
+     }
+  else
+     Versions = NULL;
+  mutex.Unlock();
+  // Deleting the copies may take a while, so it's done outside the lock:
+  for (int i = 0; i < Unused.Size(); i++)
+      delete Unused[i];
+  delete Versions;
+}
+
+void cEpgPublisher::Requested(cScheduleVersion *Version)
+{
+  cMutexLock MutexLock(&mutex);
+  Version->requested = time(NULL);
+}
+
+cScheduleVersion *cEpgPublisher::Copy(cSchedule *Origin, int TimeoutMs)
+{
+  cSchedulesLock SchedulesLock(false, TimeoutMs);
+  if (!SchedulesLock.Locked())
+     return NULL;
+  cScheduleVersion *Version = new cScheduleVersion(Origin);
+  // Writers set 'publish' while holding the write lock, so holding the read lock
+  // keeps them out, and the mutex keeps other publishing threads out:
+  mutex.Lock();
+  Origin->publish = false;
+  mutex.Unlock();
+  Version->schedule = Origin->Copy();
+  return Version;
+}
+
+cScheduleVersions *cEpgPublisher::Update(cVector<cScheduleVersion *> &Changes)
+{
+  if (!Changes.Size())
+     return Acquire();
+  cScheduleVersions *Old;
+  cScheduleVersions *New;
+  {
+    cMutexLock MutexLock(&mutex);
+    Old = current;
+    for (int i = 0; i < Changes.Size(); i++) {
+        cScheduleVersion *Version = current->Get(Changes[i]->origin->ChannelID());
+        if (Version) {
+           Version->replaced = true;
+           Changes[i]->requested = max(Changes[i]->requested, Version->requested);
+           }
+        }
+    current = new cScheduleVersions;
+    for (int i = 0; i < Old->versions.Size(); i++) {
+        if (!Old->versions[i]->replaced)
+           current->Add(Old->versions[i]);
+        }
+    for (int i = 0; i < Changes.Size(); i++) {
+        if (Changes[i]->schedule)
+           current->Add(Changes[i]);
+        }
+    New = current;
+    New->refs++;
+    Start();
+  }
+  for (int i = 0; i < Changes.Size(); i++) {
+      if (!Changes[i]->schedule)
+         delete Changes[i];
+      }
+  Release(Old);
+  return New;
+}
+
+cScheduleVersions *cEpgPublisher::Publish(const tChannelID *ChannelID)
+{
+  cVector<cSchedule *> Origins;
+  {
+    // Somebody is waiting for these, so there's no timeout here:
+    cSchedulesLock SchedulesLock;
+    const cSchedules *s = cSchedules::Schedules(SchedulesLock);
+    if (s) {
+       if (ChannelID) {
+          const cSchedule *Schedule = s->GetSchedule(*ChannelID);
+          if (Schedule)
+             Origins.Append((cSchedule *)Schedule);
+          }
+       else {
+          for (const cSchedule *p = s->First(); p; p = s->Next(p))
+              Origins.Append((cSchedule *)p);
+          }
+       }
+  }
+  cScheduleVersions *Versions = Acquire();
+  cVector<cScheduleVersion *> Changes;
+  for (int i = 0; i < Origins.Size(); i++) {
+      cSchedule *Origin = Origins[i];
+      if (!Versions->Get(Origin->ChannelID())) {
+         // Each schedule is copied with a lock of its own, so that nobody
+         // has to wait for all of them:
+         cScheduleVersion *Version = Copy(Origin, 0);
+         if (Version)
+            Changes.Append(Version);
+         }
+      }
+  Release(Versions);
+  return Update(Changes);
+}
+
+void cEpgPublisher::Action(void)
+{
+  while (Running()) {
+        cCondWait::SleepMs(EPGPUBLISHINTERVAL);
+        cScheduleVersions *Versions = Acquire();
+        cVector<cScheduleVersion *> Changes;
+        cVector<cSchedule *> Outdated;
+        time_t Now = time(NULL);
+        {
+          // The schedules' flags are only stable while holding the lock:
+          cSchedulesLock SchedulesLock(false, EPGPUBLISHLOCKTIMEOUT);
+          if (SchedulesLock.Locked()) {
+             cMutexLock MutexLock(&mutex);
+             for (int i = 0; i < Versions->versions.Size(); i++) {
+                 cScheduleVersion *Version = Versions->versions[i];
+                 cSchedule *Origin = Version->origin;
+                 if (Now - Version->requested > EPGVIEWTIMEOUT)
+                    Changes.Append(new cScheduleVersion(Origin)); // drops this schedule
+                 // The copy of a schedule with a running event also needs to be refreshed
+                 // from time to time, so that the 'seen' timestamp doesn't become too old:
+                 else if (Origin->publish || Origin->hasRunning && Now - Version->published > RUNNINGSTATUSTIMEOUT / 2)
+                    Outdated.Append(Origin);
+                 }
+             }
+        }
+        Release(Versions);
+        for (int i = 0; i < Outdated.Size() && Running(); i++) {
+            // Update() keeps the time the replaced version was last requested:
+            cScheduleVersion *Version = Copy(Outdated[i], EPGPUBLISHLOCKTIMEOUT);
+            if (Version)
+               Changes.Append(Version);
+            }
+        Release(Update(Changes));
+        }
+}
+
+// --- cSchedulesView --------------------------------------------------------
+
+cSchedulesView::cSchedulesView(void)
+{
+  current = EpgPublisher.Acquire();
+}
+
+cSchedulesView::~cSchedulesView()
+{
+  // The schedules that have been handed out must remain valid until now,
+  // so the versions they came from are released only here:
+  EpgPublisher.Release(current);
+  for (int i = 0; i < versions.Size(); i++)
+      EpgPublisher.Release(versions[i]);
+}
+
+void cSchedulesView::SetCurrent(cScheduleVersions *Versions)
+{
+  if (Versions == current) {
+     EpgPublisher.Release(Versions);
+     return;
+     }
+  // The new versions contain everything from the old ones that hasn't been
+  // replaced in the meantime, so the old ones are only kept if any of the
+  // schedules that have been handed out from them has been replaced:
+  for (int i = 0; i < handedOut.Size(); i++) {
+      if (Versions->Get(handedOut[i]->origin->ChannelID()) != handedOut[i]) {
+         versions.Append(current);
+         current = NULL;
+         break;
+         }
+      }
+  if (current)
+     EpgPublisher.Release(current);
+  else
+     handedOut.Clear();
+  current = Versions;
+}
+
+void cSchedulesView::GetAll(void)
+{
+  SetCurrent(EpgPublisher.Publish(NULL));
+}
+
+const cSchedule *cSchedulesView::GetSchedule(tChannelID ChannelID)
+{
+  cScheduleVersion *Version = current->Get(ChannelID);
+  if (!Version) {
+     SetCurrent(EpgPublisher.Publish(&ChannelID));
+     if (!(Version = current->Get(ChannelID)))
+        return NULL;
+     }
+  if (!handedOut.Size() || handedOut[handedOut.Size() - 1] != Version)
+     handedOut.Append(Version);
+  EpgPublisher.Requested(Version);
+  return Version->schedule;
+}
+
 // --- cEpgDataReader --------------------------------------------------------
 
 cEpgDataReader::cEpgDataReader(void)
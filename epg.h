@@ -39,11 +39,18 @@ enum eEventContentGroup {
 
 enum eDumpMode { dmAll, dmPresent, dmFollowing, dmAtTime };
 
+enum eEpgSearchField {
+  esfTitle       = 0x01,
+  esfShortText   = 0x02,
+  esfDescription = 0x04,
+  esfAll         = 0x07
+  };
+
 struct tComponent {
   uchar stream;
   uchar type;
   char language[MAXLANGCODE2];
-  char *description;
+  char *description; // may be shared with other components, must not be modified
   cString ToString(void);
   bool FromString(const char *s);
   };
@@ -68,28 +75,40 @@ class cSchedule;
 
 typedef u_int32_t tEventID;
 
+class cEpgSnapshot;
+class cEpgIndex;
+struct tEpgDescription;
+
 class cEvent : public cListObject {
   friend class cSchedule;
+  friend class cEpgSnapshot;
+  friend class cEpgIndex;
 private:
   // The sequence of these parameters is optimized for minimal memory waste!
+  bool changed;            // Changed since it was last written to the EPG data file or journal
+  int indexSlot;           // The slot of this event in the search index, 0 = not indexed
   cSchedule *schedule;     // The Schedule this event belongs to
   tEventID eventID;        // Event ID of this event
   uchar tableID;           // Table ID this event came from
   uchar version;           // Version number of section this event came from
   uchar runningStatus;     // 0=undefined, 1=not running, 2=starts in a few seconds, 3=pausing, 4=running
   uchar parentalRating;    // Parental rating of this event
-  char *title;             // Title of this event
+  char *title;             // Title of this event (all texts may be shared with other events, so they must not be modified in place)
   char *shortText;         // Short description of this event (typically the episode name in case of a series)
-  char *description;       // Description of this event
+  tEpgDescription *description; // Description of this event (may be kept packed in memory, see Description())
   cComponents *components; // The stream components of this event
   uchar contents[MaxEventContents]; // Contents of this event
   time_t startTime;        // Start time of this event
   int duration;            // Duration of this event in seconds
   time_t vps;              // Video Programming Service timestamp (VPS, aka "Programme Identification Label", PIL)
   time_t seen;             // When this event was last seen in the data stream
+  void SetChanged(void);
 public:
   cEvent(tEventID EventID);
   ~cEvent();
+  void *operator new(size_t Size);
+  void operator delete(void *Event, size_t Size);
+       ///< Events are allocated in chunks, because there are so many of them.
   virtual int Compare(const cListObject &ListObject) const;
   tChannelID ChannelID(void) const;
   const cSchedule *Schedule(void) const { return schedule; }
@@ -99,7 +118,12 @@ public:
   int RunningStatus(void) const { return runningStatus; }
   const char *Title(void) const { return title; }
   const char *ShortText(void) const { return shortText; }
-  const char *Description(void) const { return description; }
+  const char *Description(void) const;
+       ///< Returns the description of this event. If descriptions are kept
+       ///< packed in memory (see Setup.EPGCompression), it is unpacked here.
+       ///< The returned text remains valid as long as the caller holds the
+       ///< schedules lock, or, for an event obtained from a cSchedulesView,
+       ///< as long as the view exists.
   const cComponents *Components(void) const { return components; }
   uchar Contents(int i = 0) const { return (0 <= i && i < MaxEventContents) ? contents[i] : uchar(0); }
   int ParentalRating(void) const { return parentalRating; }
@@ -141,16 +165,53 @@ public:
 class cSchedules;
 
 class cSchedule : public cListObject  {
+  friend class cEvent;
+  friend class cEpgSnapshot;
+  friend class cEpgPublisher;
+  friend class cSchedules;
 private:
   tChannelID channelID;
+  bool copy; // this is a read-only copy made by Copy(), its events are not in the search index
   cList<cEvent> events;
   cHash<cEvent> eventsHashID;
   cHash<cEvent> eventsHashStartTime;
+  mutable cVector<cEvent *> timeline; // the events with a start time, sorted by start time
+  mutable int maxDuration; // the longest duration of any event in the timeline
+  mutable bool timelineValid;
+  cEvent *runningEvent; // the first event that has been reported as running
   bool hasRunning;
   time_t modified;
   time_t presentSeen;
+  bool changed; // events have been changed, phased out or deleted since the last journal entry
+  bool publish; // events have been changed since this schedule was last published (see cSchedulesView)
+  cStringList outdated; // "<event id> <start time>" of the events that have been phased out or deleted since then
+  mutable cEpgSnapshot *snapshot; // the binary EPG data file this schedule's events haven't been loaded from yet
+  const uchar *snapshotSection;
+  int snapshotSize;
+  void Load(void) const { if (snapshot) LoadSnapshot(); }
+  void LoadSnapshot(void) const;
+       ///< Creates this schedule's events from its section of the binary EPG
+       ///< data file. This is done the first time the events are accessed, so
+       ///< that reading the EPG data at startup only needs to map the file.
+  void PhaseOut(cEvent *Event);
+       ///< Removes Event from the hashes and sets its id and start time to 0.
+       ///< It can't be deleted right away, because a timer might have a pointer
+       ///< to it.
+  void Outdate(const cEvent *Event);
+       ///< Remembers Event's id and start time for the journal, so that it
+       ///< is phased out when the journal is replayed.
+  void WriteJournal(FILE *f);
+       ///< Writes the events that have been changed or phased out since the
+       ///< last call to f (in the format of the EPG data file).
+  void ClrChanged(void);
+  void UpdateTimeline(void) const;
+  int CountStartedBy(time_t Time) const;
+       ///< Returns the number of events in the timeline that start at or before
+       ///< the given Time, which is also the index of the first one that starts
+       ///< after it.
 public:
   cSchedule(tChannelID ChannelID);
+  ~cSchedule();
   tChannelID ChannelID(void) const { return channelID; }
   time_t Modified(void) const { return modified; }
   time_t PresentSeen(void) const { return presentSeen; }
@@ -160,6 +221,12 @@ public:
   void SetRunningStatus(cEvent *Event, int RunningStatus, cChannel *Channel = NULL);
   void ClrRunningStatus(cChannel *Channel = NULL);
   void ResetVersions(void);
+  cSchedule *Copy(const cEvent *OnlyEvent = NULL) const;
+       ///< Returns a copy of this schedule and its events (or only of OnlyEvent,
+       ///< which must be one of this schedule's events), which is never modified afterwards and can
+       ///< therefore be read without holding the schedules lock. The caller
+       ///< must hold the schedules lock while making the copy, and delete it
+       ///< when it is no longer needed.
   void Sort(void);
   void DropOutdated(time_t SegmentStart, time_t SegmentEnd, uchar TableID, uchar Version);
   void Cleanup(time_t Time);
@@ -168,11 +235,15 @@ public:
   void DelEvent(cEvent *Event);
   void HashEvent(cEvent *Event);
   void UnhashEvent(cEvent *Event);
-  const cList<cEvent> *Events(void) const { return &events; }
+  const cList<cEvent> *Events(void) const { Load(); return &events; }
   const cEvent *GetPresentEvent(void) const;
   const cEvent *GetFollowingEvent(void) const;
   const cEvent *GetEvent(tEventID EventID, time_t StartTime = 0) const;
   const cEvent *GetEventAround(time_t Time) const;
+  int GetEvents(time_t From, time_t To, cVector<const cEvent *> &Events) const;
+       ///< Appends all events that overlap with the time window From...To
+       ///< (inclusive) to Events, in the order of their start times, and returns
+       ///< the number of events that have been appended.
   void Dump(FILE *f, const char *Prefix = "", eDumpMode DumpMode = dmAll, time_t AtTime = 0) const;
   static bool Read(FILE *f, cSchedules *Schedules);
   };
@@ -186,6 +257,44 @@ public:
   bool Locked(void) { return locked; }
   };
 
+class cScheduleVersion;
+class cScheduleVersions;
+
+class cSchedulesView {
+private:
+  cScheduleVersions *current; // the most recent versions this view has seen
+  cVector<cScheduleVersion *> handedOut; // the versions in 'current' schedules have been handed out from
+  cVector<cScheduleVersions *> versions; // older versions schedules have been handed out from
+  void SetCurrent(cScheduleVersions *Versions);
+public:
+  cSchedulesView(void);
+       ///< Provides access to the EPG data without holding the schedules lock.
+       ///< The schedules returned by a view are read-only copies of the actual
+       ///< schedules, which are published again by a background thread shortly
+       ///< after the EPG data has changed. A schedule obtained from a view, and
+       ///< its events, remain valid and unchanged until the view is destroyed.
+       ///< Since a view never blocks anybody who wants to modify the EPG data,
+       ///< it may be kept for as long as the data is displayed (for instance by
+       ///< a menu). Code that modifies the EPG data, or that keeps pointers to
+       ///< events after the view has been destroyed (like cTimer does), still
+       ///< needs to use cSchedulesLock.
+  ~cSchedulesView();
+  void GetAll(void);
+       ///< Makes sure all schedules are published. Code that is going to call
+       ///< GetSchedule() for all (or many) channels should call this first, so
+       ///< that the schedules that haven't been published yet are copied in
+       ///< one go instead of one by one. This doesn't count as requesting them,
+       ///< so only those that are then actually obtained through GetSchedule()
+       ///< are kept up to date afterwards.
+  const cSchedule *GetSchedule(tChannelID ChannelID);
+       ///< Returns the published copy of the schedule of the given channel, or
+       ///< NULL if there is no such schedule. A schedule that hasn't been
+       ///< requested through any view in a while is copied right away, which
+       ///< holds the schedules lock only as long as it takes to copy this one
+       ///< schedule (but may have to wait for the lock).
+  const cSchedule *GetSchedule(const cChannel *Channel) { return GetSchedule(Channel->GetChannelID()); }
+  };
+
 class cSchedules : public cList<cSchedule> {
   friend class cSchedule;
   friend class cSchedulesLock;
@@ -196,6 +305,15 @@ private:
   static time_t lastCleanup;
   static time_t lastDump;
   static time_t modified;
+  static bool Save(void);
+         ///< Copies the complete EPG data into a compact image while holding
+         ///< the schedules lock, and hands it to a background thread that
+         ///< writes the EPG data file. Returns false if the lock could not
+         ///< be obtained.
+  static bool AppendJournal(void);
+         ///< Appends the changes since the last call to the EPG data journal.
+         ///< Returns false if the EPG data file needs to be written, because
+         ///< it doesn't exist or the journal has become too large.
 public:
   static void SetEpgDataFileName(const char *FileName);
   static const cSchedules *Schedules(cSchedulesLock &SchedulesLock);
@@ -208,10 +326,30 @@ public:
   static void ResetVersions(void);
   static bool ClearAll(void);
   static bool Dump(FILE *f, const char *Prefix = "", eDumpMode DumpMode = dmAll, time_t AtTime = 0);
+  static cString MemoryStats(void);
+         ///< Returns a summary of the memory used by the events and their texts.
   static bool Read(FILE *f = NULL);
+         ///< Reads EPG data from f, or from the EPG data file if no f is given.
+         ///< The EPG data file may be either in text or in binary format (see
+         ///< Setup.EPGBinaryData); in the latter case the file is mapped into memory
+         ///< and the events of each schedule are only created when they are
+         ///< accessed the first time.
   cSchedule *AddSchedule(tChannelID ChannelID);
   const cSchedule *GetSchedule(tChannelID ChannelID) const;
   const cSchedule *GetSchedule(const cChannel *Channel, bool AddIfMissing = false) const;
+  int Search(const char *Query, cVector<const cEvent *> &Events, tChannelID ChannelID = tChannelID::InvalidID, time_t From = 0, time_t To = 0, int Fields = esfAll) const;
+       ///< Appends all events that contain every word of the given Query in
+       ///< their texts to Events, ordered by their start times, and returns the
+       ///< number of events that have been appended. Words are matched as a
+       ///< whole and regardless of case; words enclosed in double quotes must
+       ///< occur as a phrase. If a valid ChannelID is given, only events of that
+       ///< channel are returned, and if From or To are given, only events that
+       ///< overlap with the time window From...To (inclusive). Fields is a
+       ///< combination of eEpgSearchField and selects the texts to search in.
+       ///< The search index is built at the first call and kept up to date from
+       ///< then on, so a search doesn't have to look at every event. The
+       ///< returned events are only valid as long as the cSchedulesLock this
+       ///< cSchedules has been obtained with is held.
   };
 
 class cEpgDataReader : public cThread {
@@ -243,7 +381,9 @@ public:
           ///< Before the raw EitEvent for the given Schedule is processed, the
           ///< EPG handlers are queried to see if any of them would like to do the
           ///< complete processing by itself. TableID and Version are from the
-          ///< incoming section data.
+          ///< incoming section data. Sections that are repeated unchanged are
+          ///< not passed on again, as long as all of their events are still in
+          ///< the Schedule.
   virtual bool SetEventID(cEvent *Event, tEventID EventID) { return false; }
   virtual bool SetTitle(cEvent *Event, const char *Title) { return false; }
   virtual bool SetShortText(cEvent *Event, const char *ShortText) { return false; }
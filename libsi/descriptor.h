@@ -50,6 +50,7 @@ private:
 
 class ExtendedEventDescriptors : public DescriptorGroup {
 public:
+   ExtendedEventDescriptors(bool deleteOnDesctruction=true) : DescriptorGroup(deleteOnDesctruction) {}
    int getMaximumTextLength(const char *separation1="\t", const char *separation2="\n");
    //Returns a concatenated version of first the non-itemized and then the itemized text
    //same semantics as with SI::String
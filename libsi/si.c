@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <iconv.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <stdlib.h> // for broadcaster stupidity workaround
 #include <string.h>
 #include "descriptor.h"
@@ -116,6 +117,26 @@ Descriptor *DescriptorLoop::getNext(Iterator &it) {
    return 0;
 }
 
+bool DescriptorLoop::getNext(DescriptorView &view, Iterator &it) {
+   if (!isValid() || it.i>=getLength())
+      return false;
+   const unsigned char *p=data.getData(it.i);
+   if (!checkSize(Descriptor::getLength(p)))
+      return false;
+   view.data=data+it.i;
+   view.tag=Descriptor::getDescriptorTag(p);
+   it.i+=Descriptor::getLength(p);
+   return true;
+}
+
+bool DescriptorLoop::getNext(DescriptorView &view, Iterator &it, DescriptorTag tag) {
+   while (getNext(view, it)) {
+      if (view.tag == tag)
+         return true;
+   }
+   return false;
+}
+
 Descriptor *DescriptorLoop::getNext(Iterator &it, DescriptorTag tag, bool returnUnimplemetedDescriptor) {
    Descriptor *d=0;
    int len;
@@ -179,7 +200,8 @@ int DescriptorLoop::getNumberOfDescriptors() {
 }
 
 DescriptorGroup::DescriptorGroup(bool del) {
-   array=0;
+   for (int i=0;i<16;i++)
+      array[i]=0;
    length=0;
    deleteOnDesctruction=del;
 }
@@ -187,7 +209,6 @@ DescriptorGroup::DescriptorGroup(bool del) {
 DescriptorGroup::~DescriptorGroup() {
    if (deleteOnDesctruction)
       Delete();
-   delete[] array;
 }
 
 void DescriptorGroup::Delete() {
@@ -198,12 +219,21 @@ void DescriptorGroup::Delete() {
       }
 }
 
+void DescriptorGroup::Clear() {
+   if (deleteOnDesctruction)
+      Delete();
+   for (int i=0;i<length;i++)
+      array[i]=0;
+   length=0;
+}
+
 void DescriptorGroup::Add(GroupDescriptor *d) {
-   if (!array) {
-      length=d->getLastDescriptorNumber()+1;
-      array=new GroupDescriptor*[length]; //numbering is zero-based
-      for (int i=0;i<length;i++)
-         array[i]=0;
+   if (!length) {
+      length=d->getLastDescriptorNumber()+1; //numbering is zero-based
+      if (length > 16) {
+         length=0;
+         return;
+      }
    } else if (length != d->getLastDescriptorNumber()+1)
       return; //avoid crash in case of misuse
    if (length <= d->getDescriptorNumber())
@@ -378,13 +408,162 @@ const char *getCharacterTable(const unsigned char *&buffer, int &length, bool *i
    return cs;
 }
 
+// Opening and closing an iconv descriptor for every single string takes much
+// longer than the actual conversion, so the descriptors are kept in a cache
+// and reused (each one by only one thread at a time). Conversions from single
+// byte character tables (and from ISO6937, which additionally has two byte
+// sequences for characters with diacritical marks) don't even need iconv:
+// they look up the result in a table, which is built once by letting iconv
+// convert every possible character.
+
+#define MAXCHARACTERCONVERTERS 32 // number of different conversions that are cached
+#define MAXIDLEDESCRIPTORS     4  // number of idle iconv descriptors kept per conversion
+
+struct ConversionEntry {
+   signed char length; // -1 = can't be converted
+   char text[4];
+};
+
+struct CharacterConverter {
+   const char *fromCode;
+   const char *toCode;
+   iconv_t idle[MAXIDLEDESCRIPTORS];
+   int numIdle;
+   bool tableTried;
+   ConversionEntry *table;     // 256 entries, one for every byte
+   ConversionEntry *pairs[256]; // 256 entries for every byte that starts a two byte sequence
+};
+
+static CharacterConverter CharacterConverters[MAXCHARACTERCONVERTERS];
+static int NumCharacterConverters = 0;
+static pthread_mutex_t CharacterConvertersMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool convertEntry(iconv_t cd, const unsigned char *from, size_t fromLength, ConversionEntry &Entry, int &Error) {
+   char *fromPtr = (char *)from;
+   char *to = Entry.text;
+   size_t toLength = sizeof(Entry.text);
+   iconv(cd, NULL, NULL, NULL, NULL);
+   Error = 0;
+   if (iconv(cd, &fromPtr, &fromLength, &to, &toLength) == size_t(-1)) {
+      Error = errno;
+      if (Error == EILSEQ)
+         Entry.length = -1;
+      return Error == EILSEQ || Error == EINVAL;
+   }
+   Entry.length = to - Entry.text;
+   return fromLength == 0;
+}
+
+static bool buildConversionTable(CharacterConverter *Converter, iconv_t cd) {
+   ConversionEntry *Table = new ConversionEntry[256];
+   ConversionEntry *Pairs[256] = { NULL };
+   bool ok = true;
+   for (int i = 0; ok && i < 256; i++) {
+      unsigned char from[2] = { (unsigned char)i, 0 };
+      int Error;
+      ok = convertEntry(cd, from, 1, Table[i], Error);
+      if (ok && Error == EINVAL) { // the first byte of a two byte sequence
+         Table[i].length = -1;
+         Pairs[i] = new ConversionEntry[256];
+         for (int j = 0; ok && j < 256; j++) {
+            from[1] = j;
+            ok = convertEntry(cd, from, 2, Pairs[i][j], Error) && Error != EINVAL; // no longer sequences
+         }
+      }
+   }
+   if (ok) {
+      Converter->table = Table;
+      memcpy(Converter->pairs, Pairs, sizeof(Pairs));
+   } else {
+      delete[] Table;
+      for (int i = 0; i < 256; i++)
+         delete[] Pairs[i];
+   }
+   return ok;
+}
+
+// Returns the converter for the given character tables (with the table built if
+// Table is true and this is possible), or NULL if no iconv descriptor could be
+// opened or the cache is full. The caller must hold CharacterConvertersMutex.
+static CharacterConverter *getCharacterConverter(const char *fromCode, const char *toCode, bool Table) {
+   CharacterConverter *Converter = NULL;
+   for (int i = 0; i < NumCharacterConverters; i++) {
+      if (strcmp(CharacterConverters[i].fromCode, fromCode) == 0 && strcmp(CharacterConverters[i].toCode, toCode) == 0) {
+         Converter = &CharacterConverters[i];
+         break;
+      }
+   }
+   if (!Converter) {
+      if (NumCharacterConverters >= MAXCHARACTERCONVERTERS)
+         return NULL;
+      iconv_t cd = iconv_open(toCode, fromCode);
+      if (cd == (iconv_t)-1)
+         return NULL;
+      Converter = &CharacterConverters[NumCharacterConverters++];
+      memset(Converter, 0, sizeof(*Converter));
+      Converter->fromCode = strdup(fromCode);
+      Converter->toCode = toCode; // SystemCharacterTable is always one of the static strings
+      Converter->idle[Converter->numIdle++] = cd;
+   }
+   if (Table && !Converter->tableTried && Converter->numIdle > 0) {
+      Converter->tableTried = true;
+      buildConversionTable(Converter, Converter->idle[0]);
+   }
+   return Converter;
+}
+
+static void convertWithTable(const CharacterConverter *Converter, const unsigned char *from, size_t fromLength, char *to, size_t toLength) {
+   while (fromLength > 0 && toLength > 1) {
+      const ConversionEntry *Entry = &Converter->table[*from];
+      size_t n = 1;
+      if (const ConversionEntry *Pairs = Converter->pairs[*from]) {
+         if (fromLength < 2)
+            break; // incomplete sequence
+         Entry = &Pairs[from[1]];
+         n = 2;
+      }
+      if (Entry->length < 0) {
+         // A character can't be converted, so mark it with '?' and proceed:
+         *to++ = '?';
+         toLength--;
+         from++;
+         fromLength--;
+         continue;
+      }
+      if (size_t(Entry->length) >= toLength)
+         break; // leaves room for the terminating 0
+      memcpy(to, Entry->text, Entry->length);
+      to += Entry->length;
+      toLength -= Entry->length;
+      from += n;
+      fromLength -= n;
+   }
+   *to = 0;
+}
+
 bool convertCharacterTable(const char *from, size_t fromLength, char *to, size_t toLength, const char *fromCode)
 {
   if (SystemCharacterTable) {
-     iconv_t cd = iconv_open(SystemCharacterTable, fromCode);
+     // Single byte tables and ISO6937 can be converted through a table:
+     bool Table = strcmp(fromCode, "ISO6937") == 0 || strncmp(fromCode, "ISO-8859-", 9) == 0;
+     iconv_t cd = (iconv_t)-1;
+     pthread_mutex_lock(&CharacterConvertersMutex);
+     CharacterConverter *Converter = getCharacterConverter(fromCode, SystemCharacterTable, Table);
+     if (Converter && Converter->table) {
+        pthread_mutex_unlock(&CharacterConvertersMutex); // the table is never changed once it has been built
+        convertWithTable(Converter, (const unsigned char *)from, fromLength, to, toLength);
+        return true;
+     }
+     if (Converter && Converter->numIdle > 0)
+        cd = Converter->idle[--Converter->numIdle];
+     pthread_mutex_unlock(&CharacterConvertersMutex);
+     if (cd == (iconv_t)-1)
+        cd = iconv_open(SystemCharacterTable, fromCode); // all cached descriptors are in use
      if (cd != (iconv_t)-1) {
         char *fromPtr = (char *)from;
-        while (fromLength > 0 && toLength > 1) {
+        iconv(cd, NULL, NULL, NULL, NULL); // the descriptor may have been used before
+        toLength--; // for the terminating 0
+        while (fromLength > 0 && toLength > 0) {
            if (iconv(cd, &fromPtr, &fromLength, &to, &toLength) == size_t(-1)) {
               if (errno == EILSEQ) {
                  // A character can't be converted, so mark it with '?' and proceed:
@@ -398,7 +577,12 @@ bool convertCharacterTable(const char *from, size_t fromLength, char *to, size_t
            }
         }
         *to = 0;
-        iconv_close(cd);
+        pthread_mutex_lock(&CharacterConvertersMutex);
+        if (Converter && Converter->numIdle < MAXIDLEDESCRIPTORS)
+           Converter->idle[Converter->numIdle++] = cd;
+        else
+           iconv_close(cd);
+        pthread_mutex_unlock(&CharacterConvertersMutex);
         return true;
      }
   }
@@ -224,6 +224,7 @@ protected:
    CharArray data;
    //is protected - not used for sections
    template <class T> friend class StructureLoop;
+   friend class DescriptorView;
    void setData(CharArray &d);
    //returns whether the given offset fits within the limits of the actual data
    //The valid flag will be set accordingly
@@ -355,10 +356,48 @@ public:
    //bool hasNext(Iterator &it) { return getLength() > it.i; }
 };
 
+//A reference to one descriptor of a DescriptorLoop. Unlike the descriptors
+//returned by DescriptorLoop::getNext(Iterator &it), it is not allocated with new.
+//The descriptor's data is only parsed when get() sets up an object of the
+//actual descriptor class, which typically lives on the stack:
+//   SI::DescriptorView d;
+//   for (SI::Loop::Iterator it; loop.getNext(d, it); ) {
+//      if (d.getDescriptorTag() == SI::ShortEventDescriptorTag) {
+//         SI::ShortEventDescriptor sed;
+//         d.get(sed);
+//         ...
+class DescriptorView {
+public:
+   DescriptorView() : tag((DescriptorTag)0) {}
+   DescriptorTag getDescriptorTag() const { return tag; }
+   //Sets up and parses desc, which must be of the class that corresponds to
+   //getDescriptorTag() (in the domain of the loop), and returns it.
+   //desc shares the data with the section, just like the view itself.
+   template <class T> T &get(T &desc)
+      {
+         T ret;
+         ret.setData(data);
+         ret.CheckParse();
+         desc=ret;
+         return desc;
+      }
+private:
+   friend class DescriptorLoop;
+   CharArray data;
+   DescriptorTag tag;
+};
+
 //contains descriptors of different types
 class DescriptorLoop : public Loop {
 public:
    DescriptorLoop() { domain=SI; }
+   //Zero-allocation alternative to getNext(Iterator &it):
+   //i must be 0 to get the first descriptor (with the first call)
+   //sets view to the next descriptor and returns true,
+   //returns false if no more descriptors available
+   bool getNext(DescriptorView &view, Iterator &it);
+   //the same for the next descriptor with the given tag
+   bool getNext(DescriptorView &view, Iterator &it, DescriptorTag tag);
    //i must be 0 to get the first descriptor (with the first call)
    //All returned descriptors must be delete'd.
    //returns null if no more descriptors available
@@ -466,12 +505,15 @@ public:
    ~DescriptorGroup();
    void Add(GroupDescriptor *d);
    void Delete();
+   //removes all descriptors (and deletes them if deleteOnDesctruction is set)
+   void Clear();
    int getLength() { return length; }
    GroupDescriptor **getDescriptors() { return array; }
    bool isComplete(); //if all descriptors have been added
 protected:
    int length;
-   GroupDescriptor **array;
+   //the descriptor numbers are 4 bit fields, so a group has at most 16 descriptors
+   GroupDescriptor *array[16];
    bool deleteOnDesctruction;
 };
 
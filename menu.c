@@ -503,9 +503,9 @@ eOSState cMenuChannels::Delete(void)
         }
      if (Interface->Confirm(tr("Delete channel?"))) {
         if (CurrentChannel && channel == CurrentChannel) {
-           int n = Channels.GetNextNormal(CurrentChannel->Index());
+           int n = Channels.GetNextNormal(Channels.Index(CurrentChannel));
            if (n < 0)
-              n = Channels.GetPrevNormal(CurrentChannel->Index());
+              n = Channels.GetPrevNormal(Channels.Index(CurrentChannel));
            CurrentChannel = Channels.Get(n);
            CurrentChannelNr = 0; // triggers channel switch below
            }
@@ -1366,43 +1366,54 @@ bool cMenuScheduleItem::Update(bool Force)
 
 class cMenuWhatsOn : public cOsdMenu {
 private:
+  cList<cSchedule> schedules; // copies of the schedules, with only the events that are shown
   bool now;
   int helpKeys;
   int timerState;
   eOSState Record(void);
   eOSState Switch(void);
   static int currentChannel;
-  static const cEvent *scheduleEvent;
+  static const cChannel *scheduleChannel;
   bool Update(void);
   void SetHelpKeys(void);
 public:
-  cMenuWhatsOn(const cSchedules *Schedules, bool Now, int CurrentChannelNr);
+  cMenuWhatsOn(bool Now, int CurrentChannelNr);
   static int CurrentChannel(void) { return currentChannel; }
   static void SetCurrentChannel(int ChannelNr) { currentChannel = ChannelNr; }
-  static const cEvent *ScheduleEvent(void);
+  static const cChannel *ScheduleChannel(void);
   virtual eOSState ProcessKey(eKeys Key);
   };
 
 int cMenuWhatsOn::currentChannel = 0;
-const cEvent *cMenuWhatsOn::scheduleEvent = NULL;
+const cChannel *cMenuWhatsOn::scheduleChannel = NULL;
 
-cMenuWhatsOn::cMenuWhatsOn(const cSchedules *Schedules, bool Now, int CurrentChannelNr)
+cMenuWhatsOn::cMenuWhatsOn(bool Now, int CurrentChannelNr)
 :cOsdMenu(Now ? tr("What's on now?") : tr("What's on next?"), CHNUMWIDTH, CHNAMWIDTH, 6, 4)
 {
   now = Now;
   helpKeys = -1;
   timerState = 0;
   Timers.Modified(timerState);
-  for (cChannel *Channel = Channels.First(); Channel; Channel = Channels.Next(Channel)) {
-      if (!Channel->GroupSep()) {
-         const cSchedule *Schedule = Schedules->GetSchedule(Channel);
-         if (Schedule) {
-            const cEvent *Event = Now ? Schedule->GetPresentEvent() : Schedule->GetFollowingEvent();
-            if (Event)
-               Add(new cMenuScheduleItem(Event, Channel), Channel->Number() == CurrentChannelNr);
-            }
-         }
-      }
+  {
+    // Only the events that are shown are copied, so the lock is held only briefly:
+    cSchedulesLock SchedulesLock;
+    const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
+    if (Schedules) {
+       for (cChannel *Channel = Channels.First(); Channel; Channel = Channels.Next(Channel)) {
+           if (!Channel->GroupSep()) {
+              const cSchedule *Schedule = Schedules->GetSchedule(Channel);
+              if (Schedule) {
+                 const cEvent *Event = Now ? Schedule->GetPresentEvent() : Schedule->GetFollowingEvent();
+                 if (Event) {
+                    cSchedule *Copy = Schedule->Copy(Event);
+                    schedules.Add(Copy);
+                    Add(new cMenuScheduleItem(Copy->Events()->First(), Channel), Channel->Number() == CurrentChannelNr);
+                    }
+                 }
+              }
+           }
+       }
+  }
   currentChannel = CurrentChannelNr;
   Display();
   SetHelpKeys();
@@ -1437,11 +1448,11 @@ void cMenuWhatsOn::SetHelpKeys(void)
      }
 }
 
-const cEvent *cMenuWhatsOn::ScheduleEvent(void)
+const cChannel *cMenuWhatsOn::ScheduleChannel(void)
 {
-  const cEvent *ei = scheduleEvent;
-  scheduleEvent = NULL;
-  return ei;
+  const cChannel *ch = scheduleChannel;
+  scheduleChannel = NULL;
+  return ch;
 }
 
 eOSState cMenuWhatsOn::Switch(void)
@@ -1503,7 +1514,7 @@ eOSState cMenuWhatsOn::ProcessKey(eKeys Key)
        case kGreen:  {
                        cMenuScheduleItem *mi = (cMenuScheduleItem *)Get(Current());
                        if (mi) {
-                          scheduleEvent = mi->event;
+                          scheduleChannel = mi->channel;
                           currentChannel = mi->channel->Number();
                           }
                      }
@@ -1529,8 +1540,7 @@ eOSState cMenuWhatsOn::ProcessKey(eKeys Key)
 
 class cMenuSchedule : public cOsdMenu {
 private:
-  cSchedulesLock schedulesLock;
-  const cSchedules *schedules;
+  cSchedulesView schedules;
   bool now, next;
   int otherChannel;
   int helpKeys;
@@ -1562,7 +1572,6 @@ cMenuSchedule::cMenuSchedule(void)
   cChannel *channel = Channels.GetByNumber(cDevice::CurrentChannel());
   if (channel) {
      cMenuWhatsOn::SetCurrentChannel(channel->Number());
-     schedules = cSchedules::Schedules(schedulesLock);
      PrepareScheduleAllThis(NULL, channel);
      SetHelpKeys();
      }
@@ -1570,7 +1579,7 @@ cMenuSchedule::cMenuSchedule(void)
 
 cMenuSchedule::~cMenuSchedule()
 {
-  cMenuWhatsOn::ScheduleEvent(); // makes sure any posted data is cleared
+  cMenuWhatsOn::ScheduleChannel(); // makes sure any posted data is cleared
 }
 
 void cMenuSchedule::PrepareScheduleAllThis(const cEvent *Event, const cChannel *Channel)
@@ -1578,8 +1587,8 @@ void cMenuSchedule::PrepareScheduleAllThis(const cEvent *Event, const cChannel *
   Clear();
   SetCols(7, 6, 4);
   SetTitle(cString::sprintf(tr("Schedule - %s"), Channel->Name()));
-  if (schedules && Channel) {
-     const cSchedule *Schedule = schedules->GetSchedule(Channel);
+  if (Channel) {
+     const cSchedule *Schedule = schedules.GetSchedule(Channel);
      if (Schedule) {
         const cEvent *PresentEvent = Event ? Event : Schedule->GetPresentEvent();
         time_t now = time(NULL) - Setup.EPGLinger * 60;
@@ -1596,8 +1605,8 @@ void cMenuSchedule::PrepareScheduleThisThis(const cEvent *Event, const cChannel
   Clear();
   SetCols(7, 6, 4);
   SetTitle(cString::sprintf(tr("This event - %s"), Channel->Name()));
-  if (schedules && Channel && Event) {
-     const cSchedule *Schedule = schedules->GetSchedule(Channel);
+  if (Channel && Event) {
+     const cSchedule *Schedule = schedules.GetSchedule(Channel);
      if (Schedule) {
         time_t now = time(NULL) - Setup.EPGLinger * 60;
         for (const cEvent *ev = Schedule->Events()->First(); ev; ev = Schedule->Events()->Next(ev)) {
@@ -1613,9 +1622,10 @@ void cMenuSchedule::PrepareScheduleThisAll(const cEvent *Event, const cChannel *
   Clear();
   SetCols(CHNUMWIDTH, CHNAMWIDTH, 7, 6, 4);
   SetTitle(tr("This event - all channels"));
-  if (schedules && Event) {
+  if (Event) {
+     schedules.GetAll();
      for (cChannel *ch = Channels.First(); ch; ch = Channels.Next(ch)) {
-         const cSchedule *Schedule = schedules->GetSchedule(ch);
+         const cSchedule *Schedule = schedules.GetSchedule(ch);
          if (Schedule) {
             time_t now = time(NULL) - Setup.EPGLinger * 60;
             for (const cEvent *ev = Schedule->Events()->First(); ev; ev = Schedule->Events()->Next(ev)) {
@@ -1632,18 +1642,17 @@ void cMenuSchedule::PrepareScheduleAllAll(const cEvent *Event, const cChannel *C
   Clear();
   SetCols(CHNUMWIDTH, CHNAMWIDTH, 7, 6, 4);
   SetTitle(tr("All events - all channels"));
-  if (schedules) {
-     for (cChannel *ch = Channels.First(); ch; ch = Channels.Next(ch)) {
-         const cSchedule *Schedule = schedules->GetSchedule(ch);
-         if (Schedule) {
-            time_t now = time(NULL) - Setup.EPGLinger * 60;
-            for (const cEvent *ev = Schedule->Events()->First(); ev; ev = Schedule->Events()->Next(ev)) {
-                if (ev->EndTime() > now || ev == Event)
-                   Add(new cMenuScheduleItem(ev, ch, true), ev == Event && ch == Channel);
-                }
-            }
+  schedules.GetAll();
+  for (cChannel *ch = Channels.First(); ch; ch = Channels.Next(ch)) {
+      const cSchedule *Schedule = schedules.GetSchedule(ch);
+      if (Schedule) {
+         time_t now = time(NULL) - Setup.EPGLinger * 60;
+         for (const cEvent *ev = Schedule->Events()->First(); ev; ev = Schedule->Events()->Next(ev)) {
+             if (ev->EndTime() > now || ev == Event)
+                Add(new cMenuScheduleItem(ev, ch, true), ev == Event && ch == Channel);
+             }
          }
-     }
+      }
 }
 
 bool cMenuSchedule::Update(void)
@@ -1754,24 +1763,20 @@ eOSState cMenuSchedule::ProcessKey(eKeys Key)
        case k0:      return Number();
        case kRecord:
        case kRed:    return Record();
-       case kGreen:  if (schedules) {
-                        if (!now && !next) {
-                           int ChannelNr = 0;
-                           if (Count()) {
-                              cChannel *channel = Channels.GetByChannelID(((cMenuScheduleItem *)Get(Current()))->event->ChannelID(), true);
-                              if (channel)
-                                 ChannelNr = channel->Number();
-                              }
-                           now = true;
-                           return AddSubMenu(new cMenuWhatsOn(schedules, true, ChannelNr));
+       case kGreen:  if (!now && !next) {
+                        int ChannelNr = 0;
+                        if (Count()) {
+                           cChannel *channel = Channels.GetByChannelID(((cMenuScheduleItem *)Get(Current()))->event->ChannelID(), true);
+                           if (channel)
+                              ChannelNr = channel->Number();
                            }
-                        now = !now;
-                        next = !next;
-                        return AddSubMenu(new cMenuWhatsOn(schedules, now, cMenuWhatsOn::CurrentChannel()));
+                        now = true;
+                        return AddSubMenu(new cMenuWhatsOn(true, ChannelNr));
                         }
-       case kYellow: if (schedules)
-                        return AddSubMenu(new cMenuWhatsOn(schedules, false, cMenuWhatsOn::CurrentChannel()));
-                     break;
+                     now = !now;
+                     next = !next;
+                     return AddSubMenu(new cMenuWhatsOn(now, cMenuWhatsOn::CurrentChannel()));
+       case kYellow: return AddSubMenu(new cMenuWhatsOn(false, cMenuWhatsOn::CurrentChannel()));
        case kBlue:   if (Count() && otherChannel)
                         return Switch();
                      break;
@@ -1784,18 +1789,15 @@ eOSState cMenuSchedule::ProcessKey(eKeys Key)
      }
   else if (!HasSubMenu()) {
      now = next = false;
-     const cEvent *ei = cMenuWhatsOn::ScheduleEvent();
-     if (ei) {
-        cChannel *channel = Channels.GetByChannelID(ei->ChannelID(), true);
-        if (channel) {
-           cMenuScheduleItem::SetSortMode(cMenuScheduleItem::ssmAllThis);
-           PrepareScheduleAllThis(NULL, channel);
-           if (channel->Number() != cDevice::CurrentChannel()) {
-              otherChannel = channel->Number();
-              SetHelp(Count() ? tr("Button$Record") : NULL, tr("Button$Now"), tr("Button$Next"), tr("Button$Switch"));
-              }
-           Display();
+     const cChannel *channel = cMenuWhatsOn::ScheduleChannel();
+     if (channel) {
+        cMenuScheduleItem::SetSortMode(cMenuScheduleItem::ssmAllThis);
+        PrepareScheduleAllThis(NULL, channel);
+        if (channel->Number() != cDevice::CurrentChannel()) {
+           otherChannel = channel->Number();
+           SetHelp(Count() ? tr("Button$Record") : NULL, tr("Button$Now"), tr("Button$Next"), tr("Button$Switch"));
            }
+        Display();
         }
      else if (HadSubMenu && Update())
         Display();
@@ -2396,7 +2398,7 @@ eOSState cMenuRecordings::Delete(void)
         if (recording) {
            if (cCutter::Active(ri->FileName())) {
               if (Interface->Confirm(tr("Recording is being edited - really delete?"))) {
-                 cCutter::Stop();
+                 cCutter::Stop(ri->FileName());
                  recording = Recordings.GetByName(ri->FileName()); // cCutter::Stop() might have deleted it if it was the edited version
                  // we continue with the code below even if recording is NULL,
                  // in order to have the menu updated etc.
@@ -2696,6 +2698,11 @@ void cMenuSetupEPG::Setup(void)
   Add(new cMenuEditIntItem( tr("Setup.EPG$EPG scan timeout (h)"),      &data.EPGScanTimeout));
   Add(new cMenuEditIntItem( tr("Setup.EPG$EPG bugfix level"),          &data.EPGBugfixLevel, 0, MAXEPGBUGFIXLEVEL));
   Add(new cMenuEditIntItem( tr("Setup.EPG$EPG linger time (min)"),     &data.EPGLinger, 0));
+  Add(new cMenuEditBoolItem(tr("Setup.EPG$Binary EPG data file"),      &data.EPGBinaryData));
+  Add(new cMenuEditBoolItem(tr("Setup.EPG$Journal EPG data changes"),  &data.EPGJournal));
+#ifdef ZLIB
+  Add(new cMenuEditBoolItem(tr("Setup.EPG$Compress descriptions"),     &data.EPGCompression));
+#endif
   Add(new cMenuEditBoolItem(tr("Setup.EPG$Set system time"),           &data.SetSystemTime));
   if (data.SetSystemTime)
      Add(new cMenuEditTranItem(tr("Setup.EPG$Use time from transponder"), &data.TimeTransponder, &data.TimeSource));
@@ -3117,6 +3124,11 @@ cMenuSetupRecord::cMenuSetupRecord(void)
   Add(new cMenuEditIntItem( tr("Setup.Recording$Instant rec. time (min)"),   &data.InstantRecordTime, 1, MAXINSTANTRECTIME));
   Add(new cMenuEditIntItem( tr("Setup.Recording$Max. video file size (MB)"), &data.MaxVideoFileSize, MINVIDEOFILESIZE, MAXVIDEOFILESIZETS));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Split edited files"),        &data.SplitEditedFiles));
+  Add(new cMenuEditBoolItem(tr("Setup.Recording$Stripe video files"),        &data.StripeVideoFiles));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Max. editing jobs"),         &data.MaxCuttingJobs, 1, MAXCUTTINGJOBS));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Editing bandwidth (MB/s)"),  &data.CuttingBandwidth, 0, INT_MAX, tr("unlimited")));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Gradual removal step (MB)"), &data.RemovalStep, 0, INT_MAX, tr("off")));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Removal bandwidth (MB/s)"),  &data.RemovalBandwidth, 0, INT_MAX, tr("unlimited")));
   Add(new cMenuEditStraItem(tr("Setup.Recording$Delete timeshift recording"),&data.DelTimeshiftRec, 3, delTimeshiftRecTexts));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Dump NALU Fill data"),       &data.DumpNaluFill));
 }
@@ -3732,7 +3744,7 @@ eOSState cDisplayChannel::ProcessKey(eKeys Key)
          if (group < 0) {
             cChannel *channel = Channels.GetByNumber(cDevice::CurrentChannel());
             if (channel)
-               group = channel->Index();
+               group = Channels.Index(channel);
             }
          if (group >= 0) {
             int SaveGroup = group;
@@ -4761,11 +4773,13 @@ void cReplayControl::EditCut(void)
 {
   if (fileName) {
      Hide();
-     if (!cCutter::Active()) {
+     if (!cCutter::Active(fileName)) {
         if (!marks.Count())
            Skins.Message(mtError, tr("No editing marks defined!"));
         else if (!cCutter::Start(fileName))
            Skins.Message(mtError, tr("Can't start editing process!"));
+        else if (cCutter::Waiting(fileName))
+           Skins.Message(mtInfo, tr("Editing process queued"));
         else
            Skins.Message(mtInfo, tr("Editing process started"));
         }
@@ -0,0 +1,202 @@
+/*
+ * menubench.c: Micro benchmark for scrolling through large menus
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+// This program fills the channel list with a large number of synthetic
+// channels and measures how long the "Channels" menu takes to open, to
+// scroll and to change its sort mode. The menu is rendered into a skin that
+// doesn't draw anything, so only the cost of VDR's own menu handling is
+// measured. It doesn't need any DVB hardware, video directory or
+// configuration files. Build it with "make bench".
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "channels.h"
+#include "config.h"
+#include "menu.h"
+#include "skins.h"
+#include "tools.h"
+
+#define BENCH_MENUITEMS 15 // the number of items the menu display shows at once
+
+// --- cBenchParams ----------------------------------------------------------
+
+struct cBenchParams {
+  int channels;       // total number of channels
+  int groupSize;      // number of channels per group, 0 = no group separators
+  int keys;           // number of key presses per benchmark
+  int runs;           // number of runs per benchmark (the fastest one counts)
+  cBenchParams(void)
+  {
+    channels = 10000;
+    groupSize = 100;
+    keys = 10000;
+    runs = 3;
+  }
+  };
+
+// --- cBenchDisplayMenu -----------------------------------------------------
+
+class cBenchDisplayMenu : public cSkinDisplayMenu {
+public:
+  virtual void SetTabs(int Tab1, int Tab2 = 0, int Tab3 = 0, int Tab4 = 0, int Tab5 = 0) {}
+  virtual void Scroll(bool Up, bool Page) {}
+  virtual int MaxItems(void) { return BENCH_MENUITEMS; }
+  virtual void Clear(void) {}
+  virtual void SetTitle(const char *Title) {}
+  virtual void SetButtons(const char *Red, const char *Green = NULL, const char *Yellow = NULL, const char *Blue = NULL) {}
+  virtual void SetMessage(eMessageType Type, const char *Text) {}
+  virtual void SetItem(const char *Text, int Index, bool Current, bool Selectable) {}
+  virtual void SetScrollbar(int Total, int Offset) {}
+  virtual void SetEvent(const cEvent *Event) {}
+  virtual void SetRecording(const cRecording *Recording) {}
+  virtual void SetText(const char *Text, bool FixedFont) {}
+  virtual int GetTextAreaWidth(void) const { return 0; }
+  virtual const cFont *GetTextAreaFont(bool FixedFont) const { return NULL; }
+  };
+
+// --- cBenchSkin ------------------------------------------------------------
+
+class cBenchSkin : public cSkin {
+public:
+  cBenchSkin(void) : cSkin("bench") {}
+  virtual const char *Description(void) { return "Benchmark"; }
+  virtual cSkinDisplayChannel *DisplayChannel(bool WithInfo) { return NULL; }
+  virtual cSkinDisplayMenu *DisplayMenu(void) { return new cBenchDisplayMenu; }
+  virtual cSkinDisplayReplay *DisplayReplay(bool ModeOnly) { return NULL; }
+  virtual cSkinDisplayVolume *DisplayVolume(void) { return NULL; }
+  virtual cSkinDisplayTracks *DisplayTracks(const char *Title, int NumTracks, const char * const *Tracks) { return NULL; }
+  virtual cSkinDisplayMessage *DisplayMessage(void) { return NULL; }
+  };
+
+// --- Benchmarks ------------------------------------------------------------
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void MakeChannels(const cBenchParams &Params)
+{
+  for (int i = 0; i < Params.channels; i++) {
+      if (Params.groupSize && i % Params.groupSize == 0) {
+         cChannel *Group = new cChannel;
+         Group->Parse(cString::sprintf(":Group %d", i / Params.groupSize + 1));
+         Channels.Add(Group);
+         }
+      // The names are scrambled, so that sorting by name actually has some work to do:
+      cChannel *Channel = new cChannel;
+      Channel->Parse(cString::sprintf("Channel %05d;Provider %d:%d:HC34M2S0:S19.2E:27500:%d=2:%d=deu:%d:0:%d:1:%d:0",
+                                      (i * 7919) % Params.channels, i % 37, 10714 + i % 900,
+                                      101 + i % 8000, 102 + i % 8000, 104 + i % 8000, i + 1, 1000 + i / 100));
+      Channels.Add(Channel);
+      }
+  Channels.ReNumber();
+}
+
+enum eBench { bOpen, bDown, bUp, bPageDown, bSortMode, bCount };
+
+static const char *BenchNames[bCount] = {
+  "open menu",
+  "kDown",
+  "kUp",
+  "kRight (page down)",
+  "k0 (sort mode)",
+  };
+
+static int Bench(int b, const cBenchParams &Params, uint64_t &Ns)
+{
+  uint64_t t = NowNs();
+  cMenuMain *Menu = new cMenuMain(osChannels);
+  if (b != bOpen)
+     t = NowNs(); // only the key presses count
+  int n = 1;
+  switch (b) {
+    case bDown:      for (n = 0; n < Params.keys; n++)
+                         Menu->ProcessKey(kDown);
+                     break;
+    case bUp:        for (n = 0; n < Params.keys; n++)
+                         Menu->ProcessKey(kUp);
+                     break;
+    case bPageDown:  for (n = 0; n < Params.keys; n++)
+                         Menu->ProcessKey(kRight);
+                     break;
+    case bSortMode:  for (n = 0; n < 3; n++) // cycles through all sort modes
+                         Menu->ProcessKey(k0);
+                     break;
+    default: ;
+    }
+  if (b != bOpen)
+     Ns = NowNs() - t;
+  delete Menu;
+  if (b == bOpen)
+     Ns = NowNs() - t;
+  return n;
+}
+
+static void Usage(void)
+{
+  printf("Usage: menubench [OPTIONS]\n\n"
+         "  -c N,  --channels=N  total number of channels (default: 10000)\n"
+         "  -g N,  --group=N     number of channels per group, 0 = none (default: 100)\n"
+         "  -k N,  --keys=N      key presses per benchmark (default: 10000)\n"
+         "  -r N,  --runs=N      runs per benchmark, the fastest one counts (default: 3)\n"
+         "  -h,    --help        print this help and exit\n"
+         );
+}
+
+int main(int argc, char *argv[])
+{
+  cBenchParams Params;
+  static struct option long_options[] = {
+      { "channels", required_argument, NULL, 'c' },
+      { "group",    required_argument, NULL, 'g' },
+      { "keys",     required_argument, NULL, 'k' },
+      { "runs",     required_argument, NULL, 'r' },
+      { "help",     no_argument,       NULL, 'h' },
+      { NULL,       no_argument,       NULL,  0  }
+    };
+  int c;
+  while ((c = getopt_long(argc, argv, "c:g:k:r:h", long_options, NULL)) != -1) {
+        switch (c) {
+          case 'c': Params.channels = max(atoi(optarg), 1); break;
+          case 'g': Params.groupSize = max(atoi(optarg), 0); break;
+          case 'k': Params.keys = max(atoi(optarg), 1); break;
+          case 'r': Params.runs = max(atoi(optarg), 1); break;
+          case 'h': Usage();
+                    return 0;
+          default:  Usage();
+                    return 2;
+          }
+        }
+
+  new cBenchSkin;
+  Skins.SetCurrent("bench");
+  Setup.MenuScrollWrap = 1; // so that all items are visited, no matter how many key presses there are
+  MakeChannels(Params);
+  printf("channels: %d in %d groups, %d menu items per page, %d key presses\n\n",
+         Params.channels, Params.groupSize ? (Params.channels + Params.groupSize - 1) / Params.groupSize : 0, BENCH_MENUITEMS, Params.keys);
+
+  printf("%-20s %12s %12s\n", "benchmark", "ms", "us/op");
+  for (int b = 0; b < bCount; b++) {
+      uint64_t Best = 0;
+      int Ops = 1;
+      for (int r = 0; r < Params.runs; r++) {
+          uint64_t t = 0;
+          Ops = Bench(b, Params, t);
+          if (!Best || t < Best)
+             Best = t;
+          }
+      printf("%-20s %12.1f %12.2f\n", BenchNames[b], Best / 1e6, Best / 1e3 / Ops);
+      }
+  return 0;
+}
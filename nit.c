@@ -70,17 +70,17 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
      if (!networkId && ThisNIT < 0 && numNits < MAXNITS) {
         if (nit.getSectionNumber() == 0) {
            *nits[numNits].name = 0;
-           SI::Descriptor *d;
-           for (SI::Loop::Iterator it; (d = nit.commonDescriptors.getNext(it)); ) {
-               switch (d->getDescriptorTag()) {
+           SI::DescriptorView d;
+           for (SI::Loop::Iterator it; nit.commonDescriptors.getNext(d, it); ) {
+               switch (d.getDescriptorTag()) {
                  case SI::NetworkNameDescriptorTag: {
-                      SI::NetworkNameDescriptor *nnd = (SI::NetworkNameDescriptor *)d;
-                      nnd->name.getText(nits[numNits].name, MAXNETWORKNAME);
+                      SI::NetworkNameDescriptor nnd;
+                      d.get(nnd);
+                      nnd.name.getText(nits[numNits].name, MAXNETWORKNAME);
                       }
                       break;
                  default: ;
                  }
-               delete d;
                }
            nits[numNits].networkId = nit.getNetworkId();
            nits[numNits].hasTransponder = false;
@@ -98,18 +98,21 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
      return;
   SI::NIT::TransportStream ts;
   for (SI::Loop::Iterator it; nit.transportStreamLoop.getNext(ts, it); ) {
-      SI::Descriptor *d;
+      SI::DescriptorView d;
 
       SI::Loop::Iterator it2;
-      SI::FrequencyListDescriptor *fld = (SI::FrequencyListDescriptor *)ts.transportStreamDescriptors.getNext(it2, SI::FrequencyListDescriptorTag);
-      int NumFrequencies = fld ? fld->frequencies.getCount() + 1 : 1;
+      SI::FrequencyListDescriptor fld;
+      bool HasFrequencyList = ts.transportStreamDescriptors.getNext(d, it2, SI::FrequencyListDescriptorTag);
+      if (HasFrequencyList)
+         d.get(fld);
+      int NumFrequencies = HasFrequencyList ? fld.frequencies.getCount() + 1 : 1;
       int Frequencies[NumFrequencies];
-      if (fld) {
-         int ct = fld->getCodingType();
+      if (HasFrequencyList) {
+         int ct = fld.getCodingType();
          if (ct > 0) {
             int n = 1;
-            for (SI::Loop::Iterator it3; fld->frequencies.hasNext(it3); ) {
-                int f = fld->frequencies.getNext(it3);
+            for (SI::Loop::Iterator it3; fld.frequencies.hasNext(it3); ) {
+                int f = fld.frequencies.getNext(it3);
                 switch (ct) {
                   case 1: f = BCD2INT(f) / 100; break;
                   case 2: f = BCD2INT(f) / 10; break;
@@ -122,25 +125,25 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
          else
             NumFrequencies = 1;
          }
-      delete fld;
 
-      for (SI::Loop::Iterator it2; (d = ts.transportStreamDescriptors.getNext(it2)); ) {
-          switch (d->getDescriptorTag()) {
+      for (SI::Loop::Iterator it2; ts.transportStreamDescriptors.getNext(d, it2); ) {
+          switch (d.getDescriptorTag()) {
             case SI::SatelliteDeliverySystemDescriptorTag: {
-                 SI::SatelliteDeliverySystemDescriptor *sd = (SI::SatelliteDeliverySystemDescriptor *)d;
+                 SI::SatelliteDeliverySystemDescriptor sd;
+                 d.get(sd);
                  cDvbTransponderParameters dtp;
-                 int Source = cSource::FromData(cSource::stSat, BCD2INT(sd->getOrbitalPosition()), sd->getWestEastFlag());
-                 int Frequency = Frequencies[0] = BCD2INT(sd->getFrequency()) / 100;
+                 int Source = cSource::FromData(cSource::stSat, BCD2INT(sd.getOrbitalPosition()), sd.getWestEastFlag());
+                 int Frequency = Frequencies[0] = BCD2INT(sd.getFrequency()) / 100;
                  static char Polarizations[] = { 'H', 'V', 'L', 'R' };
-                 dtp.SetPolarization(Polarizations[sd->getPolarization()]);
+                 dtp.SetPolarization(Polarizations[sd.getPolarization()]);
                  static int CodeRates[] = { FEC_NONE, FEC_1_2, FEC_2_3, FEC_3_4, FEC_5_6, FEC_7_8, FEC_8_9, FEC_3_5, FEC_4_5, FEC_9_10, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_NONE };
-                 dtp.SetCoderateH(CodeRates[sd->getFecInner()]);
+                 dtp.SetCoderateH(CodeRates[sd.getFecInner()]);
                  static int Modulations[] = { QAM_AUTO, QPSK, PSK_8, QAM_16 };
-                 dtp.SetModulation(Modulations[sd->getModulationType()]);
-                 dtp.SetSystem(sd->getModulationSystem() ? DVB_SYSTEM_2 : DVB_SYSTEM_1);
+                 dtp.SetModulation(Modulations[sd.getModulationType()]);
+                 dtp.SetSystem(sd.getModulationSystem() ? DVB_SYSTEM_2 : DVB_SYSTEM_1);
                  static int RollOffs[] = { ROLLOFF_35, ROLLOFF_25, ROLLOFF_20, ROLLOFF_AUTO };
-                 dtp.SetRollOff(sd->getModulationSystem() ? RollOffs[sd->getRollOff()] : ROLLOFF_AUTO);
-                 int SymbolRate = BCD2INT(sd->getSymbolRate()) / 10;
+                 dtp.SetRollOff(sd.getModulationSystem() ? RollOffs[sd.getRollOff()] : ROLLOFF_AUTO);
+                 int SymbolRate = BCD2INT(sd.getSymbolRate()) / 10;
                  if (ThisNIT >= 0) {
                     for (int n = 0; n < NumFrequencies; n++) {
                         if (ISTRANSPONDER(cChannel::Transponder(Frequencies[n], dtp.Polarization()), Transponder())) {
@@ -186,16 +189,17 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  }
                  break;
             case SI::CableDeliverySystemDescriptorTag: {
-                 SI::CableDeliverySystemDescriptor *sd = (SI::CableDeliverySystemDescriptor *)d;
+                 SI::CableDeliverySystemDescriptor sd;
+                 d.get(sd);
                  cDvbTransponderParameters dtp;
                  int Source = cSource::FromData(cSource::stCable);
-                 int Frequency = Frequencies[0] = BCD2INT(sd->getFrequency()) / 10;
+                 int Frequency = Frequencies[0] = BCD2INT(sd.getFrequency()) / 10;
                  //XXX FEC_outer???
                  static int CodeRates[] = { FEC_NONE, FEC_1_2, FEC_2_3, FEC_3_4, FEC_5_6, FEC_7_8, FEC_8_9, FEC_3_5, FEC_4_5, FEC_9_10, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_AUTO, FEC_NONE };
-                 dtp.SetCoderateH(CodeRates[sd->getFecInner()]);
+                 dtp.SetCoderateH(CodeRates[sd.getFecInner()]);
                  static int Modulations[] = { QPSK, QAM_16, QAM_32, QAM_64, QAM_128, QAM_256, QAM_AUTO };
-                 dtp.SetModulation(Modulations[min(sd->getModulation(), 6)]);
-                 int SymbolRate = BCD2INT(sd->getSymbolRate()) / 10;
+                 dtp.SetModulation(Modulations[min(sd.getModulation(), 6)]);
+                 int SymbolRate = BCD2INT(sd.getSymbolRate()) / 10;
                  if (ThisNIT >= 0) {
                     for (int n = 0; n < NumFrequencies; n++) {
                         if (ISTRANSPONDER(Frequencies[n] / 1000, Transponder())) {
@@ -241,24 +245,25 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  }
                  break;
             case SI::TerrestrialDeliverySystemDescriptorTag: {
-                 SI::TerrestrialDeliverySystemDescriptor *sd = (SI::TerrestrialDeliverySystemDescriptor *)d;
+                 SI::TerrestrialDeliverySystemDescriptor sd;
+                 d.get(sd);
                  cDvbTransponderParameters dtp;
                  int Source = cSource::FromData(cSource::stTerr);
-                 int Frequency = Frequencies[0] = sd->getFrequency() * 10;
+                 int Frequency = Frequencies[0] = sd.getFrequency() * 10;
                  static int Bandwidths[] = { 8000000, 7000000, 6000000, 5000000, 0, 0, 0, 0 };
-                 dtp.SetBandwidth(Bandwidths[sd->getBandwidth()]);
+                 dtp.SetBandwidth(Bandwidths[sd.getBandwidth()]);
                  static int Constellations[] = { QPSK, QAM_16, QAM_64, QAM_AUTO };
-                 dtp.SetModulation(Constellations[sd->getConstellation()]);
+                 dtp.SetModulation(Constellations[sd.getConstellation()]);
                  dtp.SetSystem(DVB_SYSTEM_1);
                  static int Hierarchies[] = { HIERARCHY_NONE, HIERARCHY_1, HIERARCHY_2, HIERARCHY_4, HIERARCHY_AUTO, HIERARCHY_AUTO, HIERARCHY_AUTO, HIERARCHY_AUTO };
-                 dtp.SetHierarchy(Hierarchies[sd->getHierarchy()]);
+                 dtp.SetHierarchy(Hierarchies[sd.getHierarchy()]);
                  static int CodeRates[] = { FEC_1_2, FEC_2_3, FEC_3_4, FEC_5_6, FEC_7_8, FEC_AUTO, FEC_AUTO, FEC_AUTO };
-                 dtp.SetCoderateH(CodeRates[sd->getCodeRateHP()]);
-                 dtp.SetCoderateL(CodeRates[sd->getCodeRateLP()]);
+                 dtp.SetCoderateH(CodeRates[sd.getCodeRateHP()]);
+                 dtp.SetCoderateL(CodeRates[sd.getCodeRateLP()]);
                  static int GuardIntervals[] = { GUARD_INTERVAL_1_32, GUARD_INTERVAL_1_16, GUARD_INTERVAL_1_8, GUARD_INTERVAL_1_4 };
-                 dtp.SetGuard(GuardIntervals[sd->getGuardInterval()]);
+                 dtp.SetGuard(GuardIntervals[sd.getGuardInterval()]);
                  static int TransmissionModes[] = { TRANSMISSION_MODE_2K, TRANSMISSION_MODE_8K, TRANSMISSION_MODE_4K, TRANSMISSION_MODE_AUTO };
-                 dtp.SetTransmission(TransmissionModes[sd->getTransmissionMode()]);
+                 dtp.SetTransmission(TransmissionModes[sd.getTransmissionMode()]);
                  if (ThisNIT >= 0) {
                     for (int n = 0; n < NumFrequencies; n++) {
                         if (ISTRANSPONDER(Frequencies[n] / 1000000, Transponder())) {
@@ -304,27 +309,29 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  }
                  break;
             case SI::ExtensionDescriptorTag: {
-                 SI::ExtensionDescriptor *sd = (SI::ExtensionDescriptor *)d;
-                 switch (sd->getExtensionDescriptorTag()) {
+                 SI::ExtensionDescriptor sd;
+                 d.get(sd);
+                 switch (sd.getExtensionDescriptorTag()) {
                    case SI::T2DeliverySystemDescriptorTag: {
                         if (Setup.UpdateChannels >= 5) {
                            for (cChannel *Channel = Channels.First(); Channel; Channel = Channels.Next(Channel)) {
                                int Source = cSource::FromData(cSource::stTerr);
                                if (!Channel->GroupSep() && Channel->Source() == Source && Channel->Nid() == ts.getOriginalNetworkId() && Channel->Tid() == ts.getTransportStreamId()) {
-                                  SI::T2DeliverySystemDescriptor *td = (SI::T2DeliverySystemDescriptor *)d;
+                                  SI::T2DeliverySystemDescriptor td;
+                                  d.get(td);
                                   int Frequency = Channel->Frequency();
                                   int SymbolRate = Channel->Srate();
-                                  //int SystemId = td->getSystemId();
+                                  //int SystemId = td.getSystemId();
                                   cDvbTransponderParameters dtp(Channel->Parameters());
                                   dtp.SetSystem(DVB_SYSTEM_2);
-                                  dtp.SetPlpId(td->getPlpId());
-                                  if (td->getExtendedDataFlag()) {
+                                  dtp.SetPlpId(td.getPlpId());
+                                  if (td.getExtendedDataFlag()) {
                                      static int T2Bandwidths[] = { 8000000, 7000000, 6000000, 5000000, 10000000, 1712000, 0, 0 };
-                                     dtp.SetBandwidth(T2Bandwidths[td->getBandwidth()]);
+                                     dtp.SetBandwidth(T2Bandwidths[td.getBandwidth()]);
                                      static int T2GuardIntervals[] = { GUARD_INTERVAL_1_32, GUARD_INTERVAL_1_16, GUARD_INTERVAL_1_8, GUARD_INTERVAL_1_4, GUARD_INTERVAL_1_128, GUARD_INTERVAL_19_128, GUARD_INTERVAL_19_256, 0 };
-                                     dtp.SetGuard(T2GuardIntervals[td->getGuardInterval()]);
+                                     dtp.SetGuard(T2GuardIntervals[td.getGuardInterval()]);
                                      static int T2TransmissionModes[] = { TRANSMISSION_MODE_2K, TRANSMISSION_MODE_8K, TRANSMISSION_MODE_4K, TRANSMISSION_MODE_1K, TRANSMISSION_MODE_16K, TRANSMISSION_MODE_32K, TRANSMISSION_MODE_AUTO, TRANSMISSION_MODE_AUTO };
-                                     dtp.SetTransmission(T2TransmissionModes[td->getTransmissionMode()]);
+                                     dtp.SetTransmission(T2TransmissionModes[td.getTransmissionMode()]);
                                      //TODO add parsing of frequencies
                                      }
                                   Channel->SetTransponderData(Source, Frequency, SymbolRate, dtp.ToString('T'));
@@ -339,7 +346,6 @@ void cNitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  break;
             default: ;
             }
-          delete d;
           }
       }
   Channels.Unlock();
@@ -193,14 +193,14 @@ void cOsdMenu::Add(cOsdItem *Item, bool Current, cOsdItem *After)
 {
   cList<cOsdItem>::Add(Item, After);
   if (Current)
-     current = Item->Index();
+     current = Index(Item);
 }
 
 void cOsdMenu::Ins(cOsdItem *Item, bool Current, cOsdItem *Before)
 {
   cList<cOsdItem>::Ins(Item, Before);
   if (Current)
-     current = Item->Index();
+     current = Index(Item);
 }
 
 void cOsdMenu::Display(void)
@@ -222,7 +222,7 @@ void cOsdMenu::Display(void)
      for (cOsdItem *item = First(); item; item = Next(item)) {
          cStatus::MsgOsdItem(item->Text(), ni++);
          if (current < 0 && item->Selectable())
-            current = item->Index();
+            current = Index(item);
          }
      if (current < 0)
         current = 0; // just for safety - there HAS to be a current item!
@@ -253,7 +253,7 @@ void cOsdMenu::Display(void)
 
 void cOsdMenu::SetCurrent(cOsdItem *Item)
 {
-  current = Item ? Item->Index() : -1;
+  current = Item ? Index(Item) : -1;
 }
 
 void cOsdMenu::RefreshCurrent(void)
@@ -284,7 +284,7 @@ void cOsdMenu::DisplayCurrent(bool Current)
 void cOsdMenu::DisplayItem(cOsdItem *Item)
 {
   if (Item) {
-     int Index = Item->Index();
+     int Index = cList<cOsdItem>::Index(Item);
      int Offset = Index - first;
      if (Offset >= 0 && Offset < first + displayMenuItems) {
         bool Current = Index == current;
@@ -470,7 +470,7 @@ eOSState cOsdMenu::HotKey(eKeys Key)
       const char *s = item->Text();
       if (s && (s = skipspace(s)) != NULL) {
          if (*s == Key - k1 + '1') {
-            current = item->Index();
+            current = Index(item);
             RefreshCurrent();
             Display();
             cRemote::Put(kOk, true);
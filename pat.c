@@ -319,12 +319,12 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
         }
      cChannel *Channel = Channels.GetByServiceID(Source(), Transponder(), pmt.getServiceId());
      if (Channel) {
-        SI::CaDescriptor *d;
+        SI::DescriptorView d;
         cCaDescriptors *CaDescriptors = new cCaDescriptors(Channel->Source(), Channel->Transponder(), Channel->Sid());
         // Scan the common loop:
-        for (SI::Loop::Iterator it; (d = (SI::CaDescriptor*)pmt.commonDescriptors.getNext(it, SI::CaDescriptorTag)); ) {
-            CaDescriptors->AddCaDescriptor(d, 0);
-            delete d;
+        for (SI::Loop::Iterator it; pmt.commonDescriptors.getNext(d, it, SI::CaDescriptorTag); ) {
+            SI::CaDescriptor cd;
+            CaDescriptors->AddCaDescriptor(&d.get(cd), 0);
             }
         // Scan the stream-specific loop:
         SI::PMT::Stream stream;
@@ -366,16 +366,16 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                       if (NumApids < MAXAPIDS) {
                          Apids[NumApids] = esPid;
                          Atypes[NumApids] = stream.getStreamType();
-                         SI::Descriptor *d;
-                         for (SI::Loop::Iterator it; (d = stream.streamDescriptors.getNext(it)); ) {
-                             switch (d->getDescriptorTag()) {
+                         for (SI::Loop::Iterator it; stream.streamDescriptors.getNext(d, it); ) {
+                             switch (d.getDescriptorTag()) {
                                case SI::ISO639LanguageDescriptorTag: {
-                                    SI::ISO639LanguageDescriptor *ld = (SI::ISO639LanguageDescriptor *)d;
+                                    SI::ISO639LanguageDescriptor ld;
+                                    d.get(ld);
                                     SI::ISO639LanguageDescriptor::Language l;
                                     char *s = ALangs[NumApids];
                                     int n = 0;
-                                    for (SI::Loop::Iterator it; ld->languageLoop.getNext(l, it); ) {
-                                        if (*ld->languageCode != '-') { // some use "---" to indicate "none"
+                                    for (SI::Loop::Iterator it; ld.languageLoop.getNext(l, it); ) {
+                                        if (*ld.languageCode != '-') { // some use "---" to indicate "none"
                                            if (n > 0)
                                               *s++ = '+';
                                            strn0cpy(s, I18nNormalizeLanguageCode(l.languageCode), MAXLANGCODE1);
@@ -388,7 +388,6 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                                     break;
                                default: ;
                                }
-                             delete d;
                              }
                          NumApids++;
                          }
@@ -402,23 +401,23 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                       int dpid = 0;
                       int dtype = 0;
                       char lang[MAXLANGCODE1] = { 0 };
-                      SI::Descriptor *d;
-                      for (SI::Loop::Iterator it; (d = stream.streamDescriptors.getNext(it)); ) {
-                          switch (d->getDescriptorTag()) {
+                      for (SI::Loop::Iterator it; stream.streamDescriptors.getNext(d, it); ) {
+                          switch (d.getDescriptorTag()) {
                             case SI::AC3DescriptorTag:
                             case SI::EnhancedAC3DescriptorTag:
                                  dpid = esPid;
-                                 dtype = d->getDescriptorTag();
+                                 dtype = d.getDescriptorTag();
                                  ProcessCaDescriptors = true;
                                  break;
                             case SI::SubtitlingDescriptorTag:
                                  if (NumSpids < MAXSPIDS) {
                                     Spids[NumSpids] = esPid;
-                                    SI::SubtitlingDescriptor *sd = (SI::SubtitlingDescriptor *)d;
+                                    SI::SubtitlingDescriptor sd;
+                                    d.get(sd);
                                     SI::SubtitlingDescriptor::Subtitling sub;
                                     char *s = SLangs[NumSpids];
                                     int n = 0;
-                                    for (SI::Loop::Iterator it; sd->subtitlingLoop.getNext(sub, it); ) {
+                                    for (SI::Loop::Iterator it; sd.subtitlingLoop.getNext(sub, it); ) {
                                         if (sub.languageCode[0]) {
                                            SubtitlingTypes[NumSpids] = sub.getSubtitlingType();
                                            CompositionPageIds[NumSpids] = sub.getCompositionPageId();
@@ -438,13 +437,13 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                                  Tpid = esPid;
                                  break;
                             case SI::ISO639LanguageDescriptorTag: {
-                                 SI::ISO639LanguageDescriptor *ld = (SI::ISO639LanguageDescriptor *)d;
-                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld->languageCode), MAXLANGCODE1);
+                                 SI::ISO639LanguageDescriptor ld;
+                                 d.get(ld);
+                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld.languageCode), MAXLANGCODE1);
                                  }
                                  break;
                             default: ;
                             }
-                          delete d;
                           }
                       if (dpid) {
                          if (NumDpids < MAXDPIDS) {
@@ -465,17 +464,16 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
               case 0x81: // STREAMTYPE_USER_PRIVATE - ATSC A/53 AUDIO (ANSI/SCTE 57)
                       {
                       char lang[MAXLANGCODE1] = { 0 };
-                      SI::Descriptor *d;
-                      for (SI::Loop::Iterator it; (d = stream.streamDescriptors.getNext(it)); ) {
-                          switch (d->getDescriptorTag()) {
+                      for (SI::Loop::Iterator it; stream.streamDescriptors.getNext(d, it); ) {
+                          switch (d.getDescriptorTag()) {
                             case SI::ISO639LanguageDescriptorTag: {
-                                 SI::ISO639LanguageDescriptor *ld = (SI::ISO639LanguageDescriptor *)d;
-                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld->languageCode), MAXLANGCODE1);
+                                 SI::ISO639LanguageDescriptor ld;
+                                 d.get(ld);
+                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld.languageCode), MAXLANGCODE1);
                                  }
                                  break;
                             default: ;
                             }
-                         delete d;
                          }
                       if (NumDpids < MAXDPIDS) {
                          Dpids[NumDpids] = esPid;
@@ -490,30 +488,30 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                       {
                       char lang[MAXLANGCODE1] = { 0 };
                       bool IsAc3 = false;
-                      SI::Descriptor *d;
-                      for (SI::Loop::Iterator it; (d = stream.streamDescriptors.getNext(it)); ) {
-                          switch (d->getDescriptorTag()) {
+                      for (SI::Loop::Iterator it; stream.streamDescriptors.getNext(d, it); ) {
+                          switch (d.getDescriptorTag()) {
                             case SI::RegistrationDescriptorTag: {
-                                 SI::RegistrationDescriptor *rd = (SI::RegistrationDescriptor *)d;
+                                 SI::RegistrationDescriptor rd;
+                                 d.get(rd);
                                  // http://www.smpte-ra.org/mpegreg/mpegreg.html
-                                 switch (rd->getFormatIdentifier()) {
+                                 switch (rd.getFormatIdentifier()) {
                                    case 0x41432D33: // 'AC-3'
                                         IsAc3 = true;
                                         break;
                                    default:
-                                        //printf("Format identifier: 0x%08X (pid: %d)\n", rd->getFormatIdentifier(), esPid);
+                                        //printf("Format identifier: 0x%08X (pid: %d)\n", rd.getFormatIdentifier(), esPid);
                                         break;
                                    }
                                  }
                                  break;
                             case SI::ISO639LanguageDescriptorTag: {
-                                 SI::ISO639LanguageDescriptor *ld = (SI::ISO639LanguageDescriptor *)d;
-                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld->languageCode), MAXLANGCODE1);
+                                 SI::ISO639LanguageDescriptor ld;
+                                 d.get(ld);
+                                 strn0cpy(lang, I18nNormalizeLanguageCode(ld.languageCode), MAXLANGCODE1);
                                  }
                                  break;
                             default: ;
                             }
-                         delete d;
                          }
                       if (IsAc3) {
                          if (NumDpids < MAXDPIDS) {
@@ -529,9 +527,9 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
               default: ;//printf("PID: %5d %5d %2d %3d %3d\n", pmt.getServiceId(), stream.getPid(), stream.getStreamType(), pmt.getVersionNumber(), Channel->Number());
               }
             if (ProcessCaDescriptors) {
-               for (SI::Loop::Iterator it; (d = (SI::CaDescriptor*)stream.streamDescriptors.getNext(it, SI::CaDescriptorTag)); ) {
-                   CaDescriptors->AddCaDescriptor(d, esPid);
-                   delete d;
+               for (SI::Loop::Iterator it; stream.streamDescriptors.getNext(d, it, SI::CaDescriptorTag); ) {
+                   SI::CaDescriptor cd;
+                   CaDescriptors->AddCaDescriptor(&d.get(cd), esPid);
                    }
                }
             }
@@ -9,8 +9,10 @@
 
 #include "recorder.h"
 #include "shutdown.h"
+#include "videodir.h"
 
 #define RECORDERBUFSIZE  (MEGABYTE(5) / TS_SIZE * TS_SIZE) // multiple of TS_SIZE
+#define RECORDERBACKLOG  (RECORDERBUFSIZE / 4) // buffered data that indicates the disk can't keep up
 
 // The maximum time we wait before assuming that a recorded video data stream
 // is broken:
@@ -90,7 +92,7 @@ cRecorder::~cRecorder()
 bool cRecorder::RunningLowOnDiskSpace(void)
 {
   if (time(NULL) > lastDiskSpaceCheck + DISKCHECKINTERVAL) {
-     int Free = FreeDiskSpaceMB(fileName->Name());
+     int Free = VideoFileFreeMB(fileName->Name());
      lastDiskSpaceCheck = time(NULL);
      if (Free < MINFREEDISKSPACE) {
         dsyslog("low disk space (%d MB, limit is %d MB)", Free, MINFREEDISKSPACE);
@@ -137,6 +139,8 @@ void cRecorder::Action(void)
         int r;
         uchar *b = ringBuffer->Get(r);
         if (b) {
+           if (ringBuffer->Available() > RECORDERBACKLOG)
+              VideoFileWriteBacklog();
            int Count = frameDetector->Analyze(b, r);
            if (Count) {
               if (!Running() && frameDetector->IndependentFrame()) // finish the recording before the next independent frame
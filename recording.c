@@ -17,6 +17,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include "channels.h"
@@ -66,6 +67,8 @@
 
 #define MAX_LINK_LEVEL  6
 
+#define RECORDINGSCACHEFILE ".recordings" // the cache of recordings meta data in the video directory
+
 bool VfatFileSystem = false;
 int InstanceId = 0;
 
@@ -73,16 +76,71 @@ cRecordings DeletedRecordings(true);
 
 // --- cRemoveDeletedRecordingsThread ----------------------------------------
 
-class cRemoveDeletedRecordingsThread : public cThread {
+class cRemoveDeletedRecordingsThread : public cThread, public cGradualRemoval {
+private:
+  cMutex mutex;
+  cStringList urgent;
+  bool removingUrgent;
+  cRecording *Next(void);
 protected:
   virtual void Action(void);
 public:
   cRemoveDeletedRecordingsThread(void);
+  virtual ~cRemoveDeletedRecordingsThread();
+  virtual bool Urgent(void);
+  virtual bool Cancelled(void) { return !Running(); }
+  void RemoveNow(const char *FileName);
+       ///< Removes the deleted recording with the given FileName right away,
+       ///< without waiting for its DELETEDLIFETIME to expire.
   };
 
 cRemoveDeletedRecordingsThread::cRemoveDeletedRecordingsThread(void)
 :cThread("remove deleted recordings")
 {
+  removingUrgent = false;
+}
+
+cRemoveDeletedRecordingsThread::~cRemoveDeletedRecordingsThread()
+{
+  Cancel(3);
+}
+
+bool cRemoveDeletedRecordingsThread::Urgent(void)
+{
+  // Any pending request from AssertFreeDiskSpace() waits for the current removal:
+  cMutexLock MutexLock(&mutex);
+  return removingUrgent || urgent.Size() > 0;
+}
+
+void cRemoveDeletedRecordingsThread::RemoveNow(const char *FileName)
+{
+  mutex.Lock();
+  if (urgent.Find(FileName) < 0)
+     urgent.Append(strdup(FileName));
+  mutex.Unlock();
+  if (!Active())
+     Start();
+}
+
+cRecording *cRemoveDeletedRecordingsThread::Next(void)
+{
+  cThreadLock DeletedRecordingsLock(&DeletedRecordings);
+  cMutexLock MutexLock(&mutex);
+  for (cRecording *r = DeletedRecordings.First(); r; r = DeletedRecordings.Next(r)) {
+      int Index = urgent.Find(r->FileName());
+      if ((r->Deleted() && time(NULL) - r->Deleted() > DELETEDLIFETIME) || Index >= 0) {
+         if (Index >= 0) {
+            free(urgent[Index]);
+            urgent.Remove(Index);
+            }
+         removingUrgent = Index >= 0;
+         DeletedRecordings.Del(r, false);
+         return r;
+         }
+      }
+  urgent.Clear();
+  removingUrgent = false;
+  return NULL;
 }
 
 void cRemoveDeletedRecordingsThread::Action(void)
@@ -93,18 +151,16 @@ void cRemoveDeletedRecordingsThread::Action(void)
   cLockFile LockFile(VideoDirectory);
   if (LockFile.Lock()) {
      bool deleted = false;
-     cThreadLock DeletedRecordingsLock(&DeletedRecordings);
-     for (cRecording *r = DeletedRecordings.First(); r; ) {
-         if (r->Deleted() && time(NULL) - r->Deleted() > DELETEDLIFETIME) {
-            cRecording *next = DeletedRecordings.Next(r);
-            r->Remove();
-            DeletedRecordings.Del(r);
-            r = next;
-            deleted = true;
-            continue;
-            }
-         r = DeletedRecordings.Next(r);
-         }
+     // The list of deleted recordings is not locked while a recording is being
+     // removed, because with Setup.RemovalStep this may take quite a while:
+     while (Running()) {
+           cRecording *r = Next();
+           if (!r)
+              break;
+           r->Remove(this);
+           delete r;
+           deleted = true;
+           }
      if (deleted)
         RemoveEmptyVideoDirectories();
      }
@@ -142,6 +198,11 @@ void AssertFreeDiskSpace(int Priority, bool Force)
   int Factor = (Priority == -1) ? 10 : 1;
   if (Force || time(NULL) - LastFreeDiskCheck > DISKCHECKDELTA / Factor) {
      if (!VideoFileSpaceAvailable(MINDISKSPACE)) {
+        // A recording that is being removed in the background is no longer in
+        // DeletedRecordings, so we must neither pick another one nor reread
+        // the video directory (which would bring it back) until it is gone:
+        if (RemoveDeletedRecordingsThread.Urgent())
+           return;
         // Make sure only one instance of VDR does this:
         cLockFile LockFile(VideoDirectory);
         if (!LockFile.Lock())
@@ -160,6 +221,12 @@ void AssertFreeDiskSpace(int Priority, bool Force)
                  r = DeletedRecordings.Next(r);
                  }
            if (r0) {
+              if (Setup.RemovalStep > 0) {
+                 // Removing the recording gradually takes a while, so it is done in the background:
+                 RemoveDeletedRecordingsThread.RemoveNow(r0->FileName());
+                 LastFreeDiskCheck += REMOVELATENCY / Factor;
+                 return;
+                 }
               if (r0->Remove())
                  LastFreeDiskCheck += REMOVELATENCY / Factor;
               DeletedRecordings.Del(r0);
@@ -520,6 +587,290 @@ bool cRecordingInfo::Write(void) const
   return Result;
 }
 
+// --- cRecordingsCache ------------------------------------------------------
+
+// Keeps the meta data of finished recordings (the contents of their 'info'
+// files, the number of frames and the total file size) in a single file in the
+// video directory, so that scanning the video directory doesn't need to access
+// the files of recordings that haven't changed. An entry is only used if the
+// modification time of the recording's directory, as well as the modification
+// time and size of its 'info' file, are still the same as when the entry was
+// made. The 'info' file may be rewritten in place (for instance by another VDR
+// or an external tool), which doesn't change the directory's modification time.
+
+class cRecordingsCacheEntry : public cListObject {
+public:
+  char *fileName;
+  time_t mtime;
+  time_t infoMtime;
+  long infoSize; // -1 if unknown (the entry is never used then)
+  int numFrames;
+  int fileSizeMB;
+  char *info; // the contents of the recording's 'info' file
+  int scan; // the scan this entry has last been used in
+  cRecordingsCacheEntry(const char *FileName, time_t Mtime, time_t InfoMtime, long InfoSize, int NumFrames, int FileSizeMB, char *Info);
+  virtual ~cRecordingsCacheEntry();
+  };
+
+cRecordingsCacheEntry::cRecordingsCacheEntry(const char *FileName, time_t Mtime, time_t InfoMtime, long InfoSize, int NumFrames, int FileSizeMB, char *Info)
+{
+  fileName = strdup(FileName);
+  mtime = Mtime;
+  infoMtime = InfoMtime;
+  infoSize = InfoSize;
+  numFrames = NumFrames;
+  fileSizeMB = FileSizeMB;
+  info = Info;
+  scan = 0;
+}
+
+cRecordingsCacheEntry::~cRecordingsCacheEntry()
+{
+  free(fileName);
+  free(info);
+}
+
+class cRecordingsCache {
+private:
+  cMutex mutex;
+  cList<cRecordingsCacheEntry> entries;
+  cHash<cRecordingsCacheEntry> hash;
+  int scan;
+  bool loaded;
+  bool modified;
+  cRecordingsCacheEntry *Find(const char *FileName);
+  void Drop(cRecordingsCacheEntry *Entry);
+  void Load(void);
+  void Write(void);
+public:
+  cRecordingsCache(void);
+  int NewScan(void);
+       ///< Starts a new scan of the video directory and returns its number.
+  cRecording *Get(const char *FileName, time_t Mtime, const struct stat &InfoStat, int Scan);
+       ///< Returns a new cRecording for the given FileName, made from the cached
+       ///< meta data, or NULL if there is no valid entry for a recording directory
+       ///< with the given modification time and an 'info' file with the given
+       ///< InfoStat.
+  void Put(const cRecording *Recording, time_t Mtime, const struct stat &InfoStat, int Scan);
+       ///< Stores the meta data of the given Recording, if it is complete.
+  void Del(const char *FileName);
+       ///< Removes the entry for the given FileName (if any), for instance because
+       ///< its 'info' file has been modified, and writes the cache file.
+  void Save(int Scan, const char *Extension);
+       ///< Removes all entries with the given Extension that have not been used
+       ///< in the given Scan and writes the cache file if anything has changed.
+  };
+
+static cRecordingsCache RecordingsCache;
+
+static unsigned int HashFileName(const char *FileName)
+{
+  unsigned int h = 2166136261u; // FNV-1a
+  while (*FileName)
+        h = (h ^ uchar(*FileName++)) * 16777619u;
+  return h;
+}
+
+cRecordingsCache::cRecordingsCache(void)
+{
+  scan = 0;
+  loaded = false;
+  modified = false;
+}
+
+cRecordingsCacheEntry *cRecordingsCache::Find(const char *FileName)
+{
+  if (cList<cHashObject> *List = hash.GetList(HashFileName(FileName))) {
+     for (cHashObject *ho = List->First(); ho; ho = List->Next(ho)) {
+         cRecordingsCacheEntry *Entry = (cRecordingsCacheEntry *)ho->Object();
+         if (strcmp(Entry->fileName, FileName) == 0)
+            return Entry;
+         }
+     }
+  return NULL;
+}
+
+void cRecordingsCache::Drop(cRecordingsCacheEntry *Entry)
+{
+  hash.Del(Entry, HashFileName(Entry->fileName));
+  entries.Del(Entry);
+  modified = true;
+}
+
+void cRecordingsCache::Load(void)
+{
+  loaded = true;
+  cString FileName = AddDirectory(VideoDirectory, RECORDINGSCACHEFILE);
+  FILE *f = fopen(FileName, "r");
+  if (f) {
+     cReadLine ReadLine;
+     char *s;
+     cRecordingsCacheEntry *Entry = NULL;
+     char *Info = NULL;
+     size_t InfoSize = 0;
+     FILE *InfoFile = NULL;
+     int line = 0;
+     while ((s = ReadLine.Read(f)) != NULL) {
+           line++;
+           if (InfoFile) {
+              if (strcmp(s, "r") == 0) {
+                 fclose(InfoFile);
+                 InfoFile = NULL;
+                 if (!Find(Entry->fileName)) {
+                    Entry->info = Info;
+                    entries.Add(Entry);
+                    hash.Add(Entry, HashFileName(Entry->fileName));
+                    }
+                 else {
+                    free(Info);
+                    delete Entry;
+                    }
+                 Info = NULL;
+                 Entry = NULL;
+                 }
+              else
+                 fprintf(InfoFile, "%s\n", s);
+              }
+           else if (*s == 'R') {
+              long Mtime, InfoMtime, InfoFileSize;
+              int NumFrames, FileSizeMB, n = 0;
+              if (!(sscanf(s + 1, "%ld %ld %ld %d %d %n", &Mtime, &InfoMtime, &InfoFileSize, &NumFrames, &FileSizeMB, &n) == 5 && n > 0 && *(s + 1 + n) == '/')) {
+                 // an entry written by an older version of VDR, which will be renewed:
+                 InfoMtime = 0;
+                 InfoFileSize = -1;
+                 n = 0;
+                 sscanf(s + 1, "%ld %d %d %n", &Mtime, &NumFrames, &FileSizeMB, &n);
+                 }
+              if (n > 0 && *(s + 1 + n) == '/') {
+                 InfoFile = open_memstream(&Info, &InfoSize);
+                 if (!InfoFile) {
+                    LOG_ERROR;
+                    break;
+                    }
+                 Entry = new cRecordingsCacheEntry(s + 1 + n, Mtime, InfoMtime, InfoFileSize, NumFrames, FileSizeMB, NULL);
+                 }
+              else {
+                 esyslog("ERROR: error in %s, line %d", *FileName, line);
+                 break;
+                 }
+              }
+           }
+     if (InfoFile) {
+        fclose(InfoFile);
+        free(Info);
+        delete Entry;
+        }
+     fclose(f);
+     dsyslog("loaded %d entries from %s", entries.Count(), *FileName);
+     }
+  else if (errno != ENOENT)
+     LOG_ERROR_STR(*FileName);
+}
+
+int cRecordingsCache::NewScan(void)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!loaded)
+     Load();
+  return ++scan;
+}
+
+cRecording *cRecordingsCache::Get(const char *FileName, time_t Mtime, const struct stat &InfoStat, int Scan)
+{
+  cMutexLock MutexLock(&mutex);
+  cRecordingsCacheEntry *Entry = Find(FileName);
+  if (Entry) {
+     if (Entry->mtime == Mtime && Entry->infoMtime == InfoStat.st_mtime && Entry->infoSize == InfoStat.st_size) {
+        cRecordingInfo *Info = new cRecordingInfo(FileName);
+        FILE *f = fmemopen(Entry->info, strlen(Entry->info), "r");
+        if (f) {
+           bool ok = Info->Read(f);
+           fclose(f);
+           if (ok) {
+              cRecording *Recording = new cRecording(FileName, Info);
+              if (Recording->Name()) {
+                 Recording->numFrames = Entry->numFrames;
+                 Recording->fileSizeMB = Entry->fileSizeMB;
+                 Entry->scan = Scan;
+                 return Recording;
+                 }
+              delete Recording;
+              Info = NULL;
+              }
+           }
+        delete Info;
+        }
+     Drop(Entry);
+     }
+  return NULL;
+}
+
+void cRecordingsCache::Put(const cRecording *Recording, time_t Mtime, const struct stat &InfoStat, int Scan)
+{
+  if (Recording->numFrames < 0 || Recording->fileSizeMB < 0)
+     return; // the recording is still going on
+  if (!Recording->Info()->ChannelID().Valid() && Recording->Info()->ChannelName())
+     return; // the channel name would get lost
+  char *Info = NULL;
+  size_t InfoSize = 0;
+  FILE *f = open_memstream(&Info, &InfoSize);
+  if (!f) {
+     LOG_ERROR;
+     return;
+     }
+  Recording->Info()->Write(f);
+  fclose(f);
+  if (!InfoSize) {
+     free(Info);
+     return;
+     }
+  cMutexLock MutexLock(&mutex);
+  if (cRecordingsCacheEntry *Entry = Find(Recording->FileName()))
+     Drop(Entry);
+  cRecordingsCacheEntry *Entry = new cRecordingsCacheEntry(Recording->FileName(), Mtime, InfoStat.st_mtime, InfoStat.st_size, Recording->numFrames, Recording->fileSizeMB, Info);
+  Entry->scan = Scan;
+  entries.Add(Entry);
+  hash.Add(Entry, HashFileName(Entry->fileName));
+  modified = true;
+}
+
+void cRecordingsCache::Del(const char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!loaded)
+     Load();
+  if (cRecordingsCacheEntry *Entry = Find(FileName)) {
+     Drop(Entry);
+     Write();
+     }
+}
+
+void cRecordingsCache::Save(int Scan, const char *Extension)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cRecordingsCacheEntry *Entry = entries.First(); Entry; ) {
+      cRecordingsCacheEntry *Next = entries.Next(Entry);
+      if (Entry->scan != Scan && endswith(Entry->fileName, Extension))
+         Drop(Entry);
+      Entry = Next;
+      }
+  Write();
+}
+
+void cRecordingsCache::Write(void)
+{
+  if (modified) {
+     cString FileName = AddDirectory(VideoDirectory, RECORDINGSCACHEFILE);
+     cSafeFile f(FileName);
+     if (f.Open()) {
+        for (cRecordingsCacheEntry *Entry = entries.First(); Entry; Entry = entries.Next(Entry))
+            fprintf(f, "R %ld %ld %ld %d %d %s\n%sr\n", Entry->mtime, Entry->infoMtime, Entry->infoSize, Entry->numFrames, Entry->fileSizeMB, Entry->fileName, Entry->info);
+        if (f.Close())
+           modified = false;
+        }
+     }
+}
+
 // --- cRecording ------------------------------------------------------------
 
 #define RESUME_NOT_INITIALIZED (-2)
@@ -669,6 +1020,27 @@ cRecording::cRecording(cTimer *Timer, const cEvent *Event)
 }
 
 cRecording::cRecording(const char *FileName)
+{
+  if (Init(FileName)) {
+     GetResume();
+     ReadInfoFile();
+     }
+}
+
+cRecording::cRecording(const char *FileName, cRecordingInfo *Info)
+{
+  if (!Init(FileName, Info)) {
+     esyslog("ERROR: invalid recording file name '%s'", FileName);
+     return;
+     }
+  if (!isPesRecording) {
+     priority = info->priority;
+     lifetime = info->lifetime;
+     framesPerSecond = info->framesPerSecond;
+     }
+}
+
+bool cRecording::Init(const char *FileName, cRecordingInfo *Info)
 {
   resume = RESUME_NOT_INITIALIZED;
   fileSizeMB = -1; // unknown
@@ -689,7 +1061,7 @@ cRecording::cRecording(const char *FileName)
   const char *p = strrchr(FileName, '/');
 
   name = NULL;
-  info = new cRecordingInfo(fileName);
+  info = Info ? Info : new cRecordingInfo(fileName);
   if (p) {
      time_t now = time(NULL);
      struct tm tm_r;
@@ -706,86 +1078,89 @@ cRecording::cRecording(const char *FileName)
         name[p - FileName] = 0;
         name = ExchangeChars(name, false);
         isPesRecording = instanceId < 0;
+        return true;
         }
-     else
-        return;
-     GetResume();
-     // read an optional info file:
-     cString InfoFileName = cString::sprintf("%s%s", fileName, isPesRecording ? INFOFILESUFFIX ".vdr" : INFOFILESUFFIX);
-     FILE *f = fopen(InfoFileName, "r");
-     if (f) {
-        if (!info->Read(f))
-           esyslog("ERROR: EPG data problem in file %s", *InfoFileName);
-        else if (!isPesRecording) {
-           priority = info->priority;
-           lifetime = info->lifetime;
-           framesPerSecond = info->framesPerSecond;
-           }
-        fclose(f);
+     }
+  return false;
+}
+
+void cRecording::ReadInfoFile(void)
+{
+  // read an optional info file:
+  cString InfoFileName = cString::sprintf("%s%s", fileName, isPesRecording ? INFOFILESUFFIX ".vdr" : INFOFILESUFFIX);
+  FILE *f = fopen(InfoFileName, "r");
+  if (f) {
+     if (!info->Read(f))
+        esyslog("ERROR: EPG data problem in file %s", *InfoFileName);
+     else if (!isPesRecording) {
+        priority = info->priority;
+        lifetime = info->lifetime;
+        framesPerSecond = info->framesPerSecond;
         }
-     else if (errno != ENOENT)
-        LOG_ERROR_STR(*InfoFileName);
+     fclose(f);
+     }
+  else if (errno != ENOENT)
+     LOG_ERROR_STR(*InfoFileName);
 #ifdef SUMMARYFALLBACK
-     // fall back to the old 'summary.vdr' if there was no 'info.vdr':
-     if (isempty(info->Title())) {
-        cString SummaryFileName = cString::sprintf("%s%s", fileName, SUMMARYFILESUFFIX);
-        FILE *f = fopen(SummaryFileName, "r");
-        if (f) {
-           int line = 0;
-           char *data[3] = { NULL };
-           cReadLine ReadLine;
-           char *s;
-           while ((s = ReadLine.Read(f)) != NULL) {
-                 if (*s || line > 1) {
-                    if (data[line]) {
-                       int len = strlen(s);
-                       len += strlen(data[line]) + 1;
-                       if (char *NewBuffer = (char *)realloc(data[line], len + 1)) {
-                          data[line] = NewBuffer;
-                          strcat(data[line], "\n");
-                          strcat(data[line], s);
-                          }
-                       else
-                          esyslog("ERROR: out of memory");
+  // fall back to the old 'summary.vdr' if there was no 'info.vdr':
+  if (isempty(info->Title())) {
+     cString SummaryFileName = cString::sprintf("%s%s", fileName, SUMMARYFILESUFFIX);
+     FILE *f = fopen(SummaryFileName, "r");
+     if (f) {
+        int line = 0;
+        char *data[3] = { NULL };
+        cReadLine ReadLine;
+        char *s;
+        while ((s = ReadLine.Read(f)) != NULL) {
+              if (*s || line > 1) {
+                 if (data[line]) {
+                    int len = strlen(s);
+                    len += strlen(data[line]) + 1;
+                    if (char *NewBuffer = (char *)realloc(data[line], len + 1)) {
+                       data[line] = NewBuffer;
+                       strcat(data[line], "\n");
+                       strcat(data[line], s);
                        }
                     else
-                       data[line] = strdup(s);
+                       esyslog("ERROR: out of memory");
                     }
                  else
-                    line++;
+                    data[line] = strdup(s);
                  }
-           fclose(f);
-           if (!data[2]) {
-              data[2] = data[1];
-              data[1] = NULL;
+              else
+                 line++;
               }
-           else if (data[1] && data[2]) {
-              // if line 1 is too long, it can't be the short text,
-              // so assume the short text is missing and concatenate
-              // line 1 and line 2 to be the long text:
-              int len = strlen(data[1]);
-              if (len > 80) {
-                 if (char *NewBuffer = (char *)realloc(data[1], len + 1 + strlen(data[2]) + 1)) {
-                    data[1] = NewBuffer;
-                    strcat(data[1], "\n");
-                    strcat(data[1], data[2]);
-                    free(data[2]);
-                    data[2] = data[1];
-                    data[1] = NULL;
-                    }
-                 else
-                    esyslog("ERROR: out of memory");
+        fclose(f);
+        if (!data[2]) {
+           data[2] = data[1];
+           data[1] = NULL;
+           }
+        else if (data[1] && data[2]) {
+           // if line 1 is too long, it can't be the short text,
+           // so assume the short text is missing and concatenate
+           // line 1 and line 2 to be the long text:
+           int len = strlen(data[1]);
+           if (len > 80) {
+              if (char *NewBuffer = (char *)realloc(data[1], len + 1 + strlen(data[2]) + 1)) {
+                 data[1] = NewBuffer;
+                 strcat(data[1], "\n");
+                 strcat(data[1], data[2]);
+                 free(data[2]);
+                 data[2] = data[1];
+                 data[1] = NULL;
                  }
+              else
+                 esyslog("ERROR: out of memory");
               }
-           info->SetData(data[0], data[1], data[2]);
-           for (int i = 0; i < 3; i ++)
-               free(data[i]);
            }
-        else if (errno != ENOENT)
-           LOG_ERROR_STR(*SummaryFileName);
+        info->SetData(data[0], data[1], data[2]);
+        for (int i = 0; i < 3; i ++)
+            free(data[i]);
         }
-#endif
+     else if (errno != ENOENT)
+        LOG_ERROR_STR(*SummaryFileName);
      }
+#endif
 }
 
 cRecording::~cRecording()
@@ -825,6 +1200,8 @@ char *cRecording::SortName(void) const
      int l = strxfrm(NULL, s, 0) + 1;
      sortBuffer = MALLOC(char, l);
      strxfrm(sortBuffer, s, l);
+     for (char *p = sortBuffer; *p; p++)
+         *p = tolower(uchar(*p)); // allows Compare() to use a plain strcmp()
      free(s);
      }
   return sortBuffer;
@@ -842,7 +1219,7 @@ int cRecording::GetResume(void) const
 int cRecording::Compare(const cListObject &ListObject) const
 {
   cRecording *r = (cRecording *)&ListObject;
-  return strcasecmp(SortName(), r->SortName());
+  return strcmp(SortName(), r->SortName());
 }
 
 const char *cRecording::FileName(void) const
@@ -960,6 +1337,7 @@ void cRecording::ReadInfo(void)
 
 bool cRecording::WriteInfo(void)
 {
+  RecordingsCache.Del(FileName());
   cString InfoFileName = cString::sprintf("%s%s", fileName, isPesRecording ? INFOFILESUFFIX ".vdr" : INFOFILESUFFIX);
   FILE *f = fopen(InfoFileName, "w");
   if (f) {
@@ -1002,7 +1380,7 @@ bool cRecording::Delete(void)
   return result;
 }
 
-bool cRecording::Remove(void)
+bool cRecording::Remove(cGradualRemoval *Gradually)
 {
   // let's do a final safety check here:
   if (!endswith(FileName(), DELEXT)) {
@@ -1010,7 +1388,7 @@ bool cRecording::Remove(void)
      return false;
      }
   isyslog("removing recording %s", FileName());
-  return RemoveVideoFile(FileName());
+  return RemoveVideoFile(FileName(), Gradually);
 }
 
 bool cRecording::Undelete(void)
@@ -1074,6 +1452,241 @@ int cRecording::FileSizeMB(void) const
   return fileSizeMB;
 }
 
+// --- cVideoDirScanner -----------------------------------------------------
+
+#define SCANTHREADS  8 // number of threads scanning the video directory in parallel
+#define SCANWAIT   100 // ms to wait for the scanning threads
+
+// Scans the video directory with several threads, which read directories and
+// load the recordings found in them in parallel. The recordings are delivered
+// in the same order in which a plain recursive scan would have found them.
+
+class cScanItem : public cListObject {
+public:
+  cString fileName;
+  time_t mtime;
+  int linkLevel;
+  bool isDir; // a directory that needs to be scanned, rather than a recording
+  bool done; // the directory has been scanned, or the recording has been loaded
+  cRecording *recording;
+  cList<cScanItem> items; // the contents of the directory
+  cScanItem *current; // the item of this directory that has been delivered last
+  cScanItem(const char *FileName, time_t Mtime, int LinkLevel, bool IsDir);
+  virtual ~cScanItem();
+  };
+
+cScanItem::cScanItem(const char *FileName, time_t Mtime, int LinkLevel, bool IsDir)
+{
+  fileName = FileName;
+  mtime = Mtime;
+  linkLevel = LinkLevel;
+  isDir = IsDir;
+  done = false;
+  recording = NULL;
+  current = NULL;
+}
+
+cScanItem::~cScanItem()
+{
+  delete recording;
+}
+
+class cVideoDirScanner;
+
+class cScanThread : public cThread {
+private:
+  cVideoDirScanner *scanner;
+protected:
+  virtual void Action(void);
+public:
+  cScanThread(cVideoDirScanner *Scanner, int Index);
+  virtual ~cScanThread();
+  };
+
+class cVideoDirScanner {
+  friend class cScanThread;
+private:
+  cMutex mutex;
+  cCondVar itemAdded;
+  cCondVar itemDone;
+  cScanItem root;
+  cVector<cScanItem *> tasks;
+  int nextTask;
+  cVector<cScanItem *> stack;
+  const char *extension;
+  int scan;
+  bool cancelled;
+  cScanThread *threads[SCANTHREADS];
+  cScanItem *GetTask(void);
+  void ScanDir(cScanItem *Dir);
+  void LoadRecording(cScanItem *Item);
+public:
+  cVideoDirScanner(const char *DirName, const char *Extension, int Scan);
+  ~cVideoDirScanner();
+  bool Get(cVector<cRecording *> &Recordings, int TimeoutMs);
+       ///< Appends all recordings that can be delivered in the right order to
+       ///< Recordings, waiting up to TimeoutMs milliseconds if there are none.
+       ///< Returns false if the scan is complete and there are no further
+       ///< recordings.
+  };
+
+cScanThread::cScanThread(cVideoDirScanner *Scanner, int Index)
+{
+  scanner = Scanner;
+  SetDescription("video directory scanner %d", Index);
+}
+
+cScanThread::~cScanThread()
+{
+  Cancel(3);
+}
+
+void cScanThread::Action(void)
+{
+  SetPriority(19);
+  SetIOPriority(7);
+  while (cScanItem *Item = scanner->GetTask()) {
+        if (Item->isDir)
+           scanner->ScanDir(Item);
+        else
+           scanner->LoadRecording(Item);
+        }
+}
+
+cVideoDirScanner::cVideoDirScanner(const char *DirName, const char *Extension, int Scan)
+:root(DirName, 0, 0, true)
+{
+  nextTask = 0;
+  extension = Extension;
+  scan = Scan;
+  cancelled = false;
+  tasks.Append(&root);
+  stack.Append(&root);
+  for (int i = 0; i < SCANTHREADS; i++) {
+      threads[i] = new cScanThread(this, i);
+      threads[i]->Start();
+      }
+}
+
+cVideoDirScanner::~cVideoDirScanner()
+{
+  mutex.Lock();
+  cancelled = true;
+  itemAdded.Broadcast();
+  mutex.Unlock();
+  for (int i = 0; i < SCANTHREADS; i++)
+      delete threads[i];
+}
+
+cScanItem *cVideoDirScanner::GetTask(void)
+{
+  cMutexLock MutexLock(&mutex);
+  while (!cancelled) {
+        if (nextTask < tasks.Size())
+           return tasks[nextTask++];
+        if (!stack.Size())
+           break; // everything has been delivered
+        itemAdded.TimedWait(mutex, SCANWAIT);
+        }
+  return NULL;
+}
+
+void cVideoDirScanner::ScanDir(cScanItem *Dir)
+{
+  cList<cScanItem> Items;
+  cReadDir d(Dir->fileName);
+  struct dirent *e;
+  while (!cancelled && (e = d.Next()) != NULL) {
+        cString buffer = AddDirectory(Dir->fileName, e->d_name);
+        struct stat st;
+        if (lstat(buffer, &st) == 0) {
+           int Link = 0;
+           if (S_ISLNK(st.st_mode)) {
+              if (Dir->linkLevel > MAX_LINK_LEVEL) {
+                 isyslog("max link level exceeded - not scanning %s", *buffer);
+                 continue;
+                 }
+              Link = 1;
+              if (stat(buffer, &st) != 0)
+                 continue;
+              }
+           if (S_ISDIR(st.st_mode)) {
+              if (endswith(buffer, extension))
+                 Items.Add(new cScanItem(buffer, st.st_mtime, 0, false));
+              else
+                 Items.Add(new cScanItem(buffer, st.st_mtime, Dir->linkLevel + Link, true));
+              }
+           }
+        }
+  cMutexLock MutexLock(&mutex);
+  while (cScanItem *Item = Items.First()) {
+        Items.Del(Item, false);
+        Dir->items.Add(Item);
+        tasks.Append(Item);
+        }
+  Dir->done = true;
+  itemAdded.Broadcast();
+  itemDone.Broadcast();
+}
+
+void cVideoDirScanner::LoadRecording(cScanItem *Item)
+{
+  // Recordings without an 'info' file are not cached:
+  struct stat InfoStat;
+  bool HasInfo = stat(cString::sprintf("%s%s", *Item->fileName, INFOFILESUFFIX), &InfoStat) == 0 || stat(cString::sprintf("%s%s", *Item->fileName, INFOFILESUFFIX ".vdr"), &InfoStat) == 0;
+  cRecording *r = HasInfo ? RecordingsCache.Get(Item->fileName, Item->mtime, InfoStat, scan) : NULL;
+  if (!r) {
+     r = new cRecording(Item->fileName);
+     if (r->Name()) {
+        r->NumFrames(); // initializes the numFrames member
+        r->FileSizeMB(); // initializes the fileSizeMB member
+        if (HasInfo)
+           RecordingsCache.Put(r, Item->mtime, InfoStat, scan);
+        }
+     }
+  if (r->Name())
+     r->SortName(); // computes the collation key outside the lock of the recordings list
+  else {
+     delete r;
+     r = NULL;
+     }
+  cMutexLock MutexLock(&mutex);
+  Item->recording = r;
+  Item->done = true;
+  itemDone.Broadcast();
+}
+
+bool cVideoDirScanner::Get(cVector<cRecording *> &Recordings, int TimeoutMs)
+{
+  cMutexLock MutexLock(&mutex);
+  while (stack.Size()) {
+        cScanItem *Dir = stack[stack.Size() - 1];
+        if (!Dir->done)
+           break;
+        cScanItem *Item = Dir->current ? Dir->items.Next(Dir->current) : Dir->items.First();
+        if (!Item) {
+           stack.Remove(stack.Size() - 1);
+           continue;
+           }
+        if (!Item->done)
+           break;
+        Dir->current = Item;
+        if (Item->isDir)
+           stack.Append(Item);
+        else if (Item->recording) {
+           Recordings.Append(Item->recording);
+           Item->recording = NULL;
+           }
+        }
+  if (!stack.Size()) {
+     itemAdded.Broadcast(); // lets the threads know that they're done
+     return Recordings.Size() > 0;
+     }
+  if (!Recordings.Size())
+     itemDone.TimedWait(mutex, TimeoutMs);
+  return true;
+}
+
 // --- cRecordings -----------------------------------------------------------
 
 cRecordings Recordings;
@@ -1086,6 +1699,7 @@ cRecordings::cRecordings(bool Deleted)
   deleted = Deleted;
   lastUpdate = 0;
   state = 0;
+  sorted = true;
 }
 
 cRecordings::~cRecordings()
@@ -1105,53 +1719,44 @@ const char *cRecordings::UpdateFileName(void)
   return updateFileName;
 }
 
+void cRecordings::SetLastUpdate(time_t LastUpdate)
+{
+  cMutexLock MutexLock(&lastUpdateMutex);
+  lastUpdate = LastUpdate;
+}
+
 void cRecordings::Refresh(bool Foreground)
 {
-  lastUpdate = time(NULL); // doing this first to make sure we don't miss anything
+  SetLastUpdate(time(NULL)); // doing this first to make sure we don't miss anything
   Lock();
   Clear();
   ChangeState();
   Unlock();
-  ScanVideoDir(VideoDirectory, Foreground);
-}
-
-void cRecordings::ScanVideoDir(const char *DirName, bool Foreground, int LinkLevel)
-{
-  cReadDir d(DirName);
-  struct dirent *e;
-  while ((Foreground || Running()) && (e = d.Next()) != NULL) {
-        cString buffer = AddDirectory(DirName, e->d_name);
-        struct stat st;
-        if (lstat(buffer, &st) == 0) {
-           int Link = 0;
-           if (S_ISLNK(st.st_mode)) {
-              if (LinkLevel > MAX_LINK_LEVEL) {
-                 isyslog("max link level exceeded - not scanning %s", *buffer);
-                 continue;
-                 }
-              Link = 1;
-              if (stat(buffer, &st) != 0)
-                 continue;
-              }
-           if (S_ISDIR(st.st_mode)) {
-              if (endswith(buffer, deleted ? DELEXT : RECEXT)) {
-                 cRecording *r = new cRecording(buffer);
-                 if (r->Name()) {
-                    r->NumFrames(); // initializes the numFrames member
-                    r->FileSizeMB(); // initializes the fileSizeMB member
-                    if (deleted)
-                       r->deleted = time(NULL);
-                    Lock();
-                    Add(r);
-                    ChangeState();
-                    Unlock();
-                    }
-                 else
-                    delete r;
-                 }
-              else
-                 ScanVideoDir(buffer, Foreground, LinkLevel + Link);
-              }
+  int Scan = RecordingsCache.NewScan();
+  ScanVideoDir(VideoDirectory, Scan, Foreground);
+  if (Foreground || Running())
+     RecordingsCache.Save(Scan, deleted ? DELEXT : RECEXT);
+}
+
+void cRecordings::ScanVideoDir(const char *DirName, int Scan, bool Foreground)
+{
+  cVideoDirScanner Scanner(DirName, deleted ? DELEXT : RECEXT, Scan);
+  cVector<cRecording *> Batch;
+  while ((Foreground || Running()) && Scanner.Get(Batch, SCANWAIT)) {
+        if (Batch.Size()) {
+           Lock();
+           for (int i = 0; i < Batch.Size(); i++) {
+               if (GetByName(Batch[i]->FileName())) {
+                  delete Batch[i]; // has already been added by the cRecordingsWatcher
+                  continue;
+                  }
+               if (deleted)
+                  Batch[i]->deleted = time(NULL);
+               Add(Batch[i]);
+               }
+           ChangeState();
+           Unlock();
+           Batch.Clear();
            }
         }
 }
@@ -1169,7 +1774,7 @@ void cRecordings::TouchUpdate(void)
   bool needsUpdate = NeedsUpdate();
   TouchFile(UpdateFileName());
   if (!needsUpdate)
-     lastUpdate = time(NULL); // make sure we don't trigger ourselves
+     SetLastUpdate(time(NULL)); // make sure we don't trigger ourselves
 }
 
 bool cRecordings::NeedsUpdate(void)
@@ -1177,6 +1782,7 @@ bool cRecordings::NeedsUpdate(void)
   time_t lastModified = LastModifiedTime(UpdateFileName());
   if (lastModified > time(NULL))
      return false; // somebody's clock isn't running correctly
+  cMutexLock MutexLock(&lastUpdateMutex);
   return lastUpdate < lastModified;
 }
 
@@ -1191,13 +1797,44 @@ bool cRecordings::Update(bool Wait)
   return false;
 }
 
+void cRecordings::Add(cRecording *Recording, cRecording *After)
+{
+  cList<cRecording>::Add(Recording, After);
+  nameHash.Add(Recording, HashFileName(Recording->FileName()));
+  sorted = false;
+}
+
+void cRecordings::Del(cRecording *Recording, bool DeleteObject)
+{
+  nameHash.Del(Recording, HashFileName(Recording->FileName()));
+  cList<cRecording>::Del(Recording, DeleteObject);
+}
+
+void cRecordings::Clear(void)
+{
+  nameHash.Clear();
+  cList<cRecording>::Clear();
+  sorted = true;
+}
+
+void cRecordings::Sort(void)
+{
+  if (!sorted) {
+     cList<cRecording>::Sort();
+     sorted = true;
+     }
+}
+
 cRecording *cRecordings::GetByName(const char *FileName)
 {
   if (FileName) {
-     for (cRecording *recording = First(); recording; recording = Next(recording)) {
-         if (strcmp(recording->FileName(), FileName) == 0)
-            return recording;
-         }
+     if (cList<cHashObject> *List = nameHash.GetList(HashFileName(FileName))) {
+        for (cHashObject *ho = List->First(); ho; ho = List->Next(ho)) {
+            cRecording *recording = (cRecording *)ho->Object();
+            if (strcmp(recording->FileName(), FileName) == 0)
+               return recording;
+            }
+        }
      }
   return NULL;
 }
@@ -1239,6 +1876,7 @@ void cRecordings::DelByName(const char *FileName)
 
 void cRecordings::UpdateByName(const char *FileName)
 {
+  RecordingsCache.Del(FileName);
   LOCK_THREAD;
   cRecording *recording = GetByName(FileName);
   if (recording)
@@ -1287,6 +1925,314 @@ void cRecordings::ResetResume(const char *ResumeFileName)
   ChangeState();
 }
 
+// --- cRecordingsWatcher ----------------------------------------------------
+
+#define WATCHMASK  (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB)
+#define WATCHWAIT  1000 // ms to wait for events
+
+class cWatchedDir : public cListObject {
+public:
+  int wd;
+  cString dirName;
+  cWatchedDir(int Wd, const char *DirName) { wd = Wd; dirName = DirName; }
+  };
+
+class cRecordingsChange : public cListObject {
+public:
+  enum eChange { rcAdd, rcDel, rcUpdate, rcRescan };
+  eChange change;
+  cString fileName; // the recording, or the directory below which recordings have been removed
+  cRecording *recording; // the new recording (rcAdd only)
+  cRecordingsChange(eChange Change, const char *FileName = NULL, cRecording *Recording = NULL) { change = Change; fileName = FileName; recording = Recording; }
+  virtual ~cRecordingsChange() { delete recording; }
+  };
+
+class cRecordingsWatcher : public cThread {
+private:
+  int fd;
+  cList<cWatchedDir> dirs;
+  cHash<cWatchedDir> hash;
+  cMutex changesMutex;
+  cList<cRecordingsChange> changes; // found by this thread, applied by the main thread
+  void AddChange(cRecordingsChange *Change);
+  static bool IsRecordingDir(const char *DirName) { return endswith(DirName, RECEXT) || endswith(DirName, DELEXT); }
+  static bool IsBelow(const char *FileName, const char *DirName);
+  bool AddWatch(const char *DirName);
+  void RemoveWatches(const char *DirName);
+  bool WatchTree(const char *DirName, bool AddRecordings, int LinkLevel = 0);
+  void AddRecording(const char *FileName);
+  void DelRecordings(const char *DirName);
+  void Close(void);
+  void HandleEvent(struct inotify_event *Event);
+protected:
+  virtual void Action(void);
+public:
+  cRecordingsWatcher(void);
+  virtual ~cRecordingsWatcher();
+  void Watch(void);
+  void ApplyChanges(void);
+  };
+
+static cRecordingsWatcher RecordingsWatcher;
+
+cRecordingsWatcher::cRecordingsWatcher(void)
+:cThread("video directory watcher")
+{
+  fd = -1;
+}
+
+cRecordingsWatcher::~cRecordingsWatcher()
+{
+  Cancel(3);
+  Close();
+}
+
+bool cRecordingsWatcher::IsBelow(const char *FileName, const char *DirName)
+{
+  int l = strlen(DirName);
+  return strncmp(FileName, DirName, l) == 0 && (FileName[l] == '/' || FileName[l] == 0);
+}
+
+bool cRecordingsWatcher::AddWatch(const char *DirName)
+{
+  int wd = inotify_add_watch(fd, DirName, WATCHMASK | IN_ONLYDIR);
+  if (wd < 0) {
+     if (errno == ENOSPC)
+        esyslog("ERROR: too many directories to watch in %s - increase /proc/sys/fs/inotify/max_user_watches", VideoDirectory);
+     else
+        LOG_ERROR_STR(DirName);
+     return false;
+     }
+  if (cWatchedDir *Dir = hash.Get(wd))
+     Dir->dirName = DirName; // the same directory can be reached through a symbolic link
+  else {
+     Dir = new cWatchedDir(wd, DirName);
+     dirs.Add(Dir);
+     hash.Add(Dir, wd);
+     }
+  return true;
+}
+
+void cRecordingsWatcher::RemoveWatches(const char *DirName)
+{
+  for (cWatchedDir *Dir = dirs.First(); Dir; ) {
+      cWatchedDir *Next = dirs.Next(Dir);
+      if (IsBelow(Dir->dirName, DirName)) {
+         inotify_rm_watch(fd, Dir->wd); // fails if the directory is already gone
+         hash.Del(Dir, Dir->wd);
+         dirs.Del(Dir);
+         }
+      Dir = Next;
+      }
+}
+
+bool cRecordingsWatcher::WatchTree(const char *DirName, bool AddRecordings, int LinkLevel)
+{
+  if (!AddWatch(DirName))
+     return false;
+  if (IsRecordingDir(DirName)) {
+     if (AddRecordings)
+        AddRecording(DirName);
+     return true;
+     }
+  cReadDir d(DirName);
+  struct dirent *e;
+  while (Running() && (e = d.Next()) != NULL) {
+        cString buffer = AddDirectory(DirName, e->d_name);
+        struct stat st;
+        if (lstat(buffer, &st) == 0) {
+           int Link = 0;
+           if (S_ISLNK(st.st_mode)) {
+              if (LinkLevel > MAX_LINK_LEVEL)
+                 continue;
+              Link = 1;
+              if (stat(buffer, &st) != 0)
+                 continue;
+              }
+           if (S_ISDIR(st.st_mode) && !WatchTree(buffer, AddRecordings, LinkLevel + Link))
+              return false;
+           }
+        }
+  return true;
+}
+
+void cRecordingsWatcher::AddChange(cRecordingsChange *Change)
+{
+  cMutexLock MutexLock(&changesMutex);
+  changes.Add(Change);
+}
+
+void cRecordingsWatcher::AddRecording(const char *FileName)
+{
+  // The recording's files are read here, so that the main thread only needs to add it:
+  cRecording *Recording = new cRecording(FileName);
+  if (Recording->Name())
+     AddChange(new cRecordingsChange(cRecordingsChange::rcAdd, FileName, Recording));
+  else
+     delete Recording;
+}
+
+void cRecordingsWatcher::DelRecordings(const char *DirName)
+{
+  AddChange(new cRecordingsChange(cRecordingsChange::rcDel, DirName));
+}
+
+void cRecordingsWatcher::ApplyChanges(void)
+{
+  cMutexLock MutexLock(&changesMutex);
+  for (cRecordingsChange *Change = changes.First(); Change; Change = changes.Next(Change)) {
+      switch (Change->change) {
+        case cRecordingsChange::rcAdd: {
+             bool Deleted = endswith(Change->fileName, DELEXT);
+             cRecordings *r = Deleted ? &DeletedRecordings : &Recordings;
+             cThreadLock RecordingsLock(r);
+             if (!r->GetByName(Change->fileName)) {
+                if (Deleted)
+                   Change->recording->deleted = time(NULL);
+                r->Add(Change->recording);
+                Change->recording = NULL;
+                r->ChangeState();
+                }
+             }
+             break;
+        case cRecordingsChange::rcDel: {
+             cRecordings *Lists[] = { &Recordings, &DeletedRecordings };
+             for (int i = 0; i < 2; i++) {
+                 cRecordings *r = Lists[i];
+                 cThreadLock RecordingsLock(r);
+                 bool Changed = false;
+                 for (cRecording *Recording = r->First(); Recording; ) {
+                     cRecording *Next = r->Next(Recording);
+                     if (IsBelow(Recording->FileName(), Change->fileName)) {
+                        r->Del(Recording);
+                        Changed = true;
+                        }
+                     Recording = Next;
+                     }
+                 if (Changed)
+                    r->ChangeState();
+                 }
+             }
+             break;
+        case cRecordingsChange::rcUpdate:
+             Recordings.UpdateByName(Change->fileName);
+             break;
+        case cRecordingsChange::rcRescan:
+             Recordings.Update();
+             DeletedRecordings.Update();
+             break;
+        }
+      }
+  changes.Clear();
+}
+
+void cRecordingsWatcher::Close(void)
+{
+  if (fd >= 0) {
+     close(fd);
+     fd = -1;
+     }
+  hash.Clear();
+  dirs.Clear();
+}
+
+void cRecordingsWatcher::HandleEvent(struct inotify_event *Event)
+{
+  if (Event->mask & IN_Q_OVERFLOW) {
+     // we have missed events, so we need to start over:
+     isyslog("video directory watcher: event queue overflow - rescanning %s", VideoDirectory);
+     AddChange(new cRecordingsChange(cRecordingsChange::rcRescan));
+     if (!WatchTree(VideoDirectory, false))
+        Close();
+     return;
+     }
+  cWatchedDir *Dir = hash.Get(Event->wd);
+  if (!Dir)
+     return;
+  if (Event->mask & IN_IGNORED) { // the directory has been removed
+     hash.Del(Dir, Dir->wd);
+     dirs.Del(Dir);
+     return;
+     }
+  if (!Event->len)
+     return;
+  cString FileName = AddDirectory(Dir->dirName, Event->name);
+  if (IsRecordingDir(Dir->dirName)) {
+     // a file in a recording directory:
+     if ((Event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && (strcmp(Event->name, "info") == 0 || strcmp(Event->name, "info.vdr") == 0) && endswith(Dir->dirName, RECEXT))
+        AddChange(new cRecordingsChange(cRecordingsChange::rcUpdate, Dir->dirName));
+     }
+  else if (Event->mask & (IN_CREATE | IN_MOVED_TO)) {
+     struct stat st;
+     if (stat(FileName, &st) == 0 && S_ISDIR(st.st_mode)) {
+        if (!WatchTree(FileName, true))
+           Close();
+        }
+     }
+  else if (Event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+     DelRecordings(FileName);
+     RemoveWatches(FileName);
+     }
+  else if ((Event->mask & (IN_ATTRIB | IN_CLOSE_WRITE)) && strcmp(Dir->dirName, VideoDirectory) == 0 && strcmp(Event->name, ".update") == 0) {
+     // whatever caused this has already been seen by us (or will be soon):
+     time_t Now = time(NULL);
+     Recordings.SetLastUpdate(Now);
+     DeletedRecordings.SetLastUpdate(Now);
+     }
+}
+
+void cRecordingsWatcher::Watch(void)
+{
+  if (fd >= 0)
+     return;
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+     LOG_ERROR;
+     return;
+     }
+  Start();
+}
+
+void cRecordingsWatcher::Action(void)
+{
+  if (WatchTree(VideoDirectory, false))
+     dsyslog("watching %d directories in %s", dirs.Count(), VideoDirectory);
+  else
+     Close();
+  uchar Buffer[KILOBYTE(64)] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  cPoller Poller(fd);
+  while (Running() && fd >= 0) {
+        if (!Poller.Poll(WATCHWAIT))
+           continue;
+        int r = read(fd, Buffer, sizeof(Buffer));
+        if (r < 0) {
+           if (errno != EAGAIN && errno != EINTR) {
+              LOG_ERROR;
+              break;
+              }
+           continue;
+           }
+        for (uchar *p = Buffer; p < Buffer + r && fd >= 0; ) {
+            struct inotify_event *Event = (struct inotify_event *)p;
+            HandleEvent(Event);
+            p += sizeof(struct inotify_event) + Event->len;
+            }
+        }
+  if (fd < 0)
+     esyslog("ERROR: can't watch %s - changes will only be detected by rescanning it", VideoDirectory);
+  Close();
+}
+
+void WatchVideoDirectory(void)
+{
+  RecordingsWatcher.Watch();
+}
+
+void ApplyVideoDirectoryChanges(void)
+{
+  RecordingsWatcher.ApplyChanges();
+}
+
 // --- cMark -----------------------------------------------------------------
 
 double MarkFramesPerSecond = DEFAULTFRAMESPERSECOND;
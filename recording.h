@@ -33,6 +33,16 @@ void AssertFreeDiskSpace(int Priority = 0, bool Force = false);
      ///< deleted recordings faster than normal (because we're cutting).
      ///< If Force is true, the check will be done even if the timeout
      ///< hasn't expired yet.
+void WatchVideoDirectory(void);
+     ///< Starts a thread that watches the video directory (using inotify) and
+     ///< finds the individual recordings that are added, removed or updated.
+     ///< If the video directory can't be watched, changes are only detected by
+     ///< rescanning it completely (see cRecordings::NeedsUpdate()).
+void ApplyVideoDirectoryChanges(void);
+     ///< Applies the changes found by the thread started by WatchVideoDirectory()
+     ///< to the lists of recordings. Since this deletes the cRecording objects
+     ///< of recordings that have been removed, it must only be called by the
+     ///< main thread, while nothing (like a menu) holds a pointer to any of them.
 
 class cResumeFile {
 private:
@@ -48,6 +58,7 @@ public:
 
 class cRecordingInfo {
   friend class cRecording;
+  friend class cRecordingsCache;
 private:
   tChannelID channelID;
   char *channelName;
@@ -80,8 +91,13 @@ public:
   bool Write(void) const;
   };
 
+class cGradualRemoval;
+
 class cRecording : public cListObject {
   friend class cRecordings;
+  friend class cRecordingsCache;
+  friend class cRecordingsWatcher;
+  friend class cVideoDirScanner;
 private:
   mutable int resume;
   mutable char *titleBuffer;
@@ -97,6 +113,11 @@ private:
   cRecordingInfo *info;
   cRecording(const cRecording&); // can't copy cRecording
   cRecording &operator=(const cRecording &); // can't assign cRecording
+  cRecording(const char *FileName, cRecordingInfo *Info);
+       ///< Creates a recording with the given (already read) Info, without
+       ///< accessing any of the recording's files.
+  bool Init(const char *FileName, cRecordingInfo *Info = NULL);
+  void ReadInfoFile(void);
   static char *StripEpisodeName(char *s);
   char *SortName(void) const;
   int GetResume(void) const;
@@ -148,8 +169,10 @@ public:
   bool Delete(void);
        ///< Changes the file name so that it will no longer be visible in the "Recordings" menu
        ///< Returns false in case of error
-  bool Remove(void);
+  bool Remove(cGradualRemoval *Gradually = NULL);
        ///< Actually removes the file from the disk
+       ///< If Gradually is given, large files are truncated step by step first
+       ///< (see RemoveVideoFile()).
        ///< Returns false in case of error
   bool Undelete(void);
        ///< Changes the file name so that it will be visible in the "Recordings" menu again and
@@ -158,14 +181,22 @@ public:
   };
 
 class cRecordings : public cList<cRecording>, public cThread {
+  friend class cRecordingsWatcher;
 private:
   static char *updateFileName;
   bool deleted;
+  bool sorted;
+  cMutex lastUpdateMutex;
   time_t lastUpdate;
   int state;
+  cHash<cRecording> nameHash;
   const char *UpdateFileName(void);
+  void SetLastUpdate(time_t LastUpdate);
+       ///< Sets the time of the last update of this list. lastUpdate is
+       ///< accessed by the scanner, the cRecordingsWatcher and the main thread,
+       ///< so it is only set and read under lastUpdateMutex.
   void Refresh(bool Foreground = false);
-  void ScanVideoDir(const char *DirName, bool Foreground = false, int LinkLevel = 0);
+  void ScanVideoDir(const char *DirName, int Scan, bool Foreground = false);
 protected:
   void Action(void);
 public:
@@ -189,7 +220,17 @@ public:
   void ChangeState(void) { state++; }
   bool StateChanged(int &State);
   void ResetResume(const char *ResumeFileName = NULL);
+  void Add(cRecording *Recording, cRecording *After = NULL);
+  void Del(cRecording *Recording, bool DeleteObject = true);
+  virtual void Clear(void);
+       ///< Recordings must only be added to or removed from the list through
+       ///< these functions, which keep the index for GetByName() up to date.
+  void Sort(void);
+       ///< Sorts the list of recordings, unless it hasn't changed since it was
+       ///< last sorted.
   cRecording *GetByName(const char *FileName);
+       ///< Returns the recording with the given FileName, or NULL if there is
+       ///< no such recording.
   void AddByName(const char *FileName, bool TriggerUpdate = true);
   void DelByName(const char *FileName);
   void UpdateByName(const char *FileName);
@@ -0,0 +1,593 @@
+/*
+ * remuxbench.c: Micro benchmarks for the TS handling tools in remux.c
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+// This program generates a deterministic synthetic transport stream in
+// memory and feeds it through the individual components of remux.c, measuring
+// the throughput of each of them. It doesn't need any DVB hardware, video
+// directory or configuration files. Build it with "make bench".
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "channels.h"
+#include "libsi/si.h"
+#include "remux.h"
+#include "tools.h"
+
+#define BENCH_VPID  0x0100
+#define BENCH_DPID  0x0102
+#define BENCH_SPID  0x0103
+
+#define VIDEO_FPS             25
+#define VIDEO_PTS_DELTA       (90000 / VIDEO_FPS)
+#define AC3_SAMPLES_PER_FRAME 1536
+#define AC3_PTS_DELTA         (90000 * AC3_SAMPLES_PER_FRAME / 48000) // 48kHz
+#define SUBTITLE_INTERVAL     (2 * 90000) // one subtitle display set every 2 seconds
+#define PATPMT_INTERVAL       (VIDEO_FPS / 5) // PAT/PMT 5 times per second
+
+// --- cBenchParams ----------------------------------------------------------
+
+struct cBenchParams {
+  int vtype;          // 0x02 = MPEG-2, 0x1B = H.264
+  int videoBitrate;   // kbit/s
+  int ac3Bitrate;     // kbit/s, 0 = no AC-3 stream
+  bool subtitles;
+  int fillerPercent;  // H.264 only: percentage of each frame made up of filler NALUs
+  const char *gop;    // frame types in one GOP, e.g. "IBBPBBPBBPBB"
+  int seconds;        // duration of the generated stream
+  int runs;           // number of runs per component (the fastest one counts)
+  unsigned int seed;
+  cBenchParams(void)
+  {
+    vtype = 0x02;
+    videoBitrate = 6000;
+    ac3Bitrate = 448;
+    subtitles = true;
+    fillerPercent = 10;
+    gop = "IBBPBBPBBPBB";
+    seconds = 60;
+    runs = 5;
+    seed = 1;
+  }
+  };
+
+// --- cTsGenerator ----------------------------------------------------------
+
+class cTsGenerator {
+private:
+  const cBenchParams &params;
+  cChannel channel;
+  cPatPmtGenerator patPmtGenerator;
+  uchar *buffer;
+  int size;
+  int length;
+  uchar *es;
+  unsigned int random;
+  int ccVideo, ccAc3, ccSubtitle;
+  uchar Random(void);
+  void Grow(int Needed);
+  void PutPacket(const uchar *Packet);
+  void PutPes(int Pid, int &Counter, const uchar *Pes, int Length, int64_t Pcr = -1);
+       ///< Pcr is the 90kHz base of the PCR to put into the first TS packet,
+       ///< or -1 for none.
+  int PesHeader(uchar *p, uchar StreamId, int64_t Pts, int PayloadLength);
+  int Fill(uchar *p, int Length);
+  int MakeMpeg2Frame(uchar *p, char FrameType, int TemporalReference, int Length);
+  int MakeH264Frame(uchar *p, char FrameType, int Length);
+  int MakeAc3Frame(uchar *p, int Length);
+  int MakeSubtitle(uchar *p);
+  void PutPatPmt(void);
+public:
+  cTsGenerator(const cBenchParams &Params);
+  ~cTsGenerator();
+  void Generate(void);
+  const uchar *Data(void) const { return buffer; }
+  int Length(void) const { return length; }
+  };
+
+cTsGenerator::cTsGenerator(const cBenchParams &Params)
+:params(Params)
+{
+  int Apids[MAXAPIDS + 1] = { 0 };
+  int Atypes[MAXAPIDS + 1] = { 0 };
+  int Dpids[MAXDPIDS + 1] = { 0 };
+  int Dtypes[MAXDPIDS + 1] = { 0 };
+  int Spids[MAXSPIDS + 1] = { 0 };
+  char ALangs[MAXAPIDS][MAXLANGCODE2] = { "" };
+  char DLangs[MAXDPIDS][MAXLANGCODE2] = { "" };
+  char SLangs[MAXSPIDS][MAXLANGCODE2] = { "" };
+  if (params.ac3Bitrate) {
+     Dpids[0] = BENCH_DPID;
+     Dtypes[0] = SI::AC3DescriptorTag;
+     strcpy(DLangs[0], "deu");
+     }
+  if (params.subtitles) {
+     Spids[0] = BENCH_SPID;
+     strcpy(SLangs[0], "deu");
+     uchar SubtitlingTypes[MAXSPIDS] = { 0x10 };
+     uint16_t CompositionPageIds[MAXSPIDS] = { 1 };
+     uint16_t AncillaryPageIds[MAXSPIDS] = { 1 };
+     channel.SetSubtitlingDescriptors(SubtitlingTypes, CompositionPageIds, AncillaryPageIds);
+     }
+  channel.SetPids(BENCH_VPID, BENCH_VPID, params.vtype, Apids, Atypes, ALangs, Dpids, Dtypes, DLangs, Spids, SLangs, 0);
+  patPmtGenerator.SetChannel(&channel);
+  buffer = NULL;
+  size = length = 0;
+  es = NULL;
+  random = params.seed;
+  ccVideo = ccAc3 = ccSubtitle = 0;
+}
+
+cTsGenerator::~cTsGenerator()
+{
+  free(buffer);
+  free(es);
+}
+
+uchar cTsGenerator::Random(void)
+{
+  // Deterministic, and never 0x00, so the payload never contains start codes:
+  random = random * 1103515245 + 12345;
+  return ((random >> 16) % 255) + 1;
+}
+
+void cTsGenerator::Grow(int Needed)
+{
+  if (length + Needed > size) {
+     size = max(size * 2, length + Needed + int(MEGABYTE(1)));
+     buffer = (uchar *)realloc(buffer, size);
+     if (!buffer) {
+        fprintf(stderr, "remuxbench: out of memory\n");
+        exit(1);
+        }
+     }
+}
+
+void cTsGenerator::PutPacket(const uchar *Packet)
+{
+  Grow(TS_SIZE);
+  memcpy(buffer + length, Packet, TS_SIZE);
+  length += TS_SIZE;
+}
+
+void cTsGenerator::PutPes(int Pid, int &Counter, const uchar *Pes, int Length, int64_t Pcr)
+{
+  bool PayloadStart = true;
+  while (Length > 0) {
+        uchar p[TS_SIZE];
+        p[0] = TS_SYNC_BYTE;
+        p[1] = (PayloadStart ? TS_PAYLOAD_START : 0x00) | (Pid >> 8);
+        p[2] = Pid & 0xFF;
+        p[3] = TS_PAYLOAD_EXISTS | (Counter++ & TS_CONT_CNT_MASK);
+        int Header = 4;
+        int AdaptationLength = 0;
+        if (PayloadStart && Pcr >= 0)
+           AdaptationLength = 8; // length byte, flags and 6 bytes PCR
+        if (Length < TS_SIZE - Header - AdaptationLength)
+           AdaptationLength = TS_SIZE - Header - Length; // stuffing
+        if (AdaptationLength) {
+           p[3] |= TS_ADAPT_FIELD_EXISTS;
+           p[4] = AdaptationLength - 1;
+           if (AdaptationLength > 1) {
+              memset(p + 5, 0xFF, AdaptationLength - 1);
+              p[5] = 0x00;
+              if (PayloadStart && Pcr >= 0) {
+                 p[5] = TS_ADAPT_PCR;
+                 p[6] = Pcr >> 25;
+                 p[7] = Pcr >> 17;
+                 p[8] = Pcr >> 9;
+                 p[9] = Pcr >> 1;
+                 p[10] = ((Pcr & 0x01) << 7) | 0x7E;
+                 p[11] = 0x00;
+                 }
+              }
+           Header += AdaptationLength;
+           }
+        int l = TS_SIZE - Header;
+        memcpy(p + Header, Pes, l);
+        Pes += l;
+        Length -= l;
+        PutPacket(p);
+        PayloadStart = false;
+        }
+}
+
+int cTsGenerator::PesHeader(uchar *p, uchar StreamId, int64_t Pts, int PayloadLength)
+{
+  int i = 0;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x01;
+  p[i++] = StreamId;
+  int l = PayloadLength + 8;
+  if (l > 0xFFFF || (StreamId & 0xF0) == 0xE0)
+     l = 0; // video PES packets have an undefined length
+  p[i++] = l >> 8;
+  p[i++] = l & 0xFF;
+  p[i++] = 0x80; // MPEG-2 PES
+  p[i++] = 0x80; // PTS only
+  p[i++] = 0x05; // header data length
+  p[i++] = 0x21 | ((Pts >> 29) & 0x0E);
+  p[i++] = Pts >> 22;
+  p[i++] = ((Pts >> 14) & 0xFE) | 0x01;
+  p[i++] = Pts >> 7;
+  p[i++] = ((Pts << 1) & 0xFE) | 0x01;
+  return i;
+}
+
+int cTsGenerator::Fill(uchar *p, int Length)
+{
+  for (int i = 0; i < Length; i++)
+      p[i] = Random();
+  return max(Length, 0);
+}
+
+int cTsGenerator::MakeMpeg2Frame(uchar *p, char FrameType, int TemporalReference, int Length)
+{
+  int i = 0;
+  if (FrameType == 'I') {
+     static const uchar SequenceHeader[] = { 0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x33, 0x24, 0x9F, 0x23, 0x81 }; // 720x576, 4:3, 25 fps
+     static const uchar GopHeader[] = { 0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x00 };
+     memcpy(p + i, SequenceHeader, sizeof(SequenceHeader));
+     i += sizeof(SequenceHeader);
+     memcpy(p + i, GopHeader, sizeof(GopHeader));
+     i += sizeof(GopHeader);
+     }
+  int PictureCodingType = FrameType == 'I' ? 1 : FrameType == 'P' ? 2 : 3;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x01;
+  p[i++] = 0x00; // picture start code
+  p[i++] = TemporalReference >> 2;
+  p[i++] = ((TemporalReference & 0x03) << 6) | (PictureCodingType << 3) | 0x07;
+  p[i++] = 0xFF;
+  p[i++] = 0xF8;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x01;
+  p[i++] = 0x01; // first slice
+  i += Fill(p + i, Length - i);
+  return i;
+}
+
+int cTsGenerator::MakeH264Frame(uchar *p, char FrameType, int Length)
+{
+  int i = 0;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x01;
+  p[i++] = 0x09; // access unit delimiter
+  p[i++] = FrameType == 'I' ? 0x10 : FrameType == 'P' ? 0x30 : 0x50;
+  if (FrameType == 'I') {
+     static const uchar Sps[] = { 0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x28, 0xAC, 0xD9, 0x40, 0x78, 0x02, 0x27, 0xE5, 0x84 };
+     static const uchar Pps[] = { 0x00, 0x00, 0x00, 0x01, 0x68, 0xEB, 0xE3, 0xCB, 0x22, 0xC0 };
+     memcpy(p + i, Sps, sizeof(Sps));
+     i += sizeof(Sps);
+     memcpy(p + i, Pps, sizeof(Pps));
+     i += sizeof(Pps);
+     }
+  int Filler = Length * params.fillerPercent / 100;
+  p[i++] = 0x00;
+  p[i++] = 0x00;
+  p[i++] = 0x01;
+  p[i++] = FrameType == 'I' ? 0x65 : 0x41; // IDR or non-IDR slice
+  i += Fill(p + i, Length - Filler - i);
+  if (Filler > 5) {
+     p[i++] = 0x00;
+     p[i++] = 0x00;
+     p[i++] = 0x01;
+     p[i++] = 0x0C; // filler data
+     memset(p + i, 0xFF, Filler - 5);
+     i += Filler - 5;
+     p[i++] = 0x80;
+     }
+  return i;
+}
+
+int cTsGenerator::MakeAc3Frame(uchar *p, int Length)
+{
+  int i = 0;
+  p[i++] = 0x0B;
+  p[i++] = 0x77; // sync word
+  i += Fill(p + i, Length - i);
+  return i;
+}
+
+int cTsGenerator::MakeSubtitle(uchar *p)
+{
+  static const uchar DisplaySet[] = {
+    0x20, 0x00,                                     // data identifier, subtitle stream id
+    0x0F, 0x10, 0x00, 0x01, 0x00, 0x02, 0x05, 0x80, // page composition segment
+    0x0F, 0x80, 0x00, 0x01, 0x00, 0x00,             // end of display set segment
+    0xFF                                            // end of PES data field marker
+    };
+  memcpy(p, DisplaySet, sizeof(DisplaySet));
+  return sizeof(DisplaySet);
+}
+
+void cTsGenerator::PutPatPmt(void)
+{
+  PutPacket(patPmtGenerator.GetPat());
+  int Index = 0;
+  while (uchar *pmt = patPmtGenerator.GetPmt(Index))
+        PutPacket(pmt);
+}
+
+void cTsGenerator::Generate(void)
+{
+  int GopLength = strlen(params.gop);
+  // Distribute the video bitrate over the frames of a GOP, weighing I-frames
+  // with 5, P-frames with 2 and B-frames with 1:
+  int Weights = 0;
+  for (const char *f = params.gop; *f; f++)
+      Weights += *f == 'I' ? 5 : *f == 'P' ? 2 : 1;
+  int GopBytes = params.videoBitrate * 1000 / 8 * GopLength / VIDEO_FPS;
+  es = MALLOC(uchar, GopBytes + KILOBYTE(64)); // enough for the largest frame plus headers
+  int Ac3FrameSize = params.ac3Bitrate * 1000 / 8 * AC3_SAMPLES_PER_FRAME / 48000;
+  int64_t Pts = 90000;
+  int64_t Ac3Pts = Pts;
+  int64_t SubtitlePts = Pts;
+  int Frames = params.seconds * VIDEO_FPS;
+  for (int Frame = 0; Frame < Frames; Frame++) {
+      int GopIndex = Frame % GopLength;
+      char FrameType = params.gop[GopIndex];
+      if (Frame % PATPMT_INTERVAL == 0 || FrameType == 'I')
+         PutPatPmt();
+      int FrameSize = GopBytes / Weights * (FrameType == 'I' ? 5 : FrameType == 'P' ? 2 : 1);
+      int h = PesHeader(es, 0xE0, Pts, FrameSize);
+      if (params.vtype == 0x1B)
+         h += MakeH264Frame(es + h, FrameType, FrameSize);
+      else
+         h += MakeMpeg2Frame(es + h, FrameType, GopIndex, FrameSize);
+      PutPes(BENCH_VPID, ccVideo, es, h, Pts - VIDEO_PTS_DELTA);
+      while (Ac3FrameSize && Ac3Pts <= Pts) {
+            int h = PesHeader(es, 0xBD, Ac3Pts, Ac3FrameSize);
+            h += MakeAc3Frame(es + h, Ac3FrameSize);
+            PutPes(BENCH_DPID, ccAc3, es, h);
+            Ac3Pts += AC3_PTS_DELTA;
+            }
+      if (params.subtitles && SubtitlePts <= Pts) {
+         uchar s[TS_SIZE];
+         int l = MakeSubtitle(s + 14);
+         int h = PesHeader(s, 0xBD, SubtitlePts, l);
+         PutPes(BENCH_SPID, ccSubtitle, s, h + l);
+         SubtitlePts += SUBTITLE_INTERVAL;
+         }
+      Pts += VIDEO_PTS_DELTA;
+      }
+}
+
+// --- Benchmarks ------------------------------------------------------------
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Each benchmark returns a count of what it found, which is reported for
+// plausibility checking (and keeps the compiler from optimizing away the
+// benchmarked code).
+
+static int BenchTsGetPts(const uchar *Data, int Length)
+{
+  int Found = 0;
+  for (const uchar *p = Data, *e = Data + Length; p < e; p += TS_SIZE) {
+      if (TsGetPts(p, TS_SIZE) >= 0)
+         Found++;
+      }
+  return Found;
+}
+
+static int BenchPatPmtParser(const uchar *Data, int Length)
+{
+  cPatPmtParser PatPmtParser;
+  int Parsed = 0;
+  for (const uchar *p = Data, *e = Data + Length; p < e; p += TS_SIZE) {
+      int Pid = TsPid(p);
+      if (Pid == PATPID) {
+         PatPmtParser.ParsePat(p, TS_SIZE);
+         Parsed++;
+         }
+      else if (Pid == PatPmtParser.PmtPid()) {
+         PatPmtParser.ParsePmt(p, TS_SIZE);
+         Parsed++;
+         }
+      }
+  return PatPmtParser.Vpid() == BENCH_VPID ? Parsed : -1;
+}
+
+static int BenchTsToPes(const uchar *Data, int Length)
+{
+  cTsToPes TsToPes[3];
+  int Pids[3] = { BENCH_VPID, BENCH_DPID, BENCH_SPID };
+  int Packets = 0;
+  for (const uchar *p = Data, *e = Data + Length; p < e; p += TS_SIZE) {
+      int Pid = TsPid(p);
+      for (int i = 0; i < 3; i++) {
+          if (Pid == Pids[i]) {
+             if (TsPayloadStart(p)) {
+                int l;
+                while (TsToPes[i].GetPes(l))
+                      Packets++;
+                TsToPes[i].Reset();
+                }
+             TsToPes[i].PutTs(p, TS_SIZE);
+             break;
+             }
+          }
+      }
+  return Packets;
+}
+
+static int BenchFrameDetector(const uchar *Data, int Length, int Pid, int Type)
+{
+  cFrameDetector FrameDetector(Pid, Type);
+  int Frames = 0;
+  while (Length >= MIN_TS_PACKETS_FOR_FRAME_DETECTOR * TS_SIZE) {
+        int Count = FrameDetector.Analyze(Data, Length);
+        if (!Count)
+           break;
+        if (FrameDetector.NewFrame())
+           Frames++;
+        Data += Count;
+        Length -= Count;
+        }
+  return Frames;
+}
+
+static int BenchNaluStreamProcessor(uchar *Data, int Length)
+{
+  cNaluStreamProcessor NaluStreamProcessor;
+  NaluStreamProcessor.SetPid(BENCH_VPID);
+  NaluStreamProcessor.PutBuffer(Data, Length);
+  int OutLength;
+  while (NaluStreamProcessor.GetBuffer(OutLength))
+        ;
+  return NaluStreamProcessor.GetDroppedPackets();
+}
+
+enum eBench { bTsGetPts, bPatPmtParser, bTsToPes, bFrameDetectorVideo, bFrameDetectorAudio, bNaluStreamProcessor, bCount };
+
+static const char *BenchNames[bCount][2] = {
+  { "TsGetPts",               "PTS found" },
+  { "cPatPmtParser",          "PAT/PMT packets" },
+  { "cTsToPes",               "PES packets" },
+  { "cFrameDetector (video)", "frames" },
+  { "cFrameDetector (AC-3)",  "frames" },
+  { "cNaluStreamProcessor",   "packets dropped" },
+  };
+
+static void Report(int Bench, int Length, uint64_t Ns, int Result)
+{
+  double Seconds = Ns / 1e9;
+  int Packets = Length / TS_SIZE;
+  printf("%-24s %10.1f MB/s %12.0f packets/s %8.1f ns/packet  %8d %s\n", BenchNames[Bench][0], Length / Seconds / MEGABYTE(1), Packets / Seconds, double(Ns) / Packets, Result, BenchNames[Bench][1]);
+}
+
+static void Usage(void)
+{
+  printf("Usage: remuxbench [OPTIONS]\n\n"
+         "  -v, --video=TYPE       video stream type: 'mpeg2' or 'h264' (default: mpeg2)\n"
+         "  -b, --bitrate=KBIT     video bitrate in kbit/s (default: 6000)\n"
+         "  -a, --ac3=KBIT         AC-3 bitrate in kbit/s, 0 for no AC-3 (default: 448)\n"
+         "  -f, --filler=PERCENT   H.264 filler NALU share of each frame (default: 10)\n"
+         "  -g, --gop=TYPES        frame types of one GOP (default: IBBPBBPBBPBB)\n"
+         "  -n, --no-subtitles     don't generate a DVB subtitle stream\n"
+         "  -s, --seconds=SEC      duration of the generated stream (default: 60)\n"
+         "  -r, --runs=NUM         runs per component, the fastest counts (default: 5)\n"
+         "  -S, --seed=NUM         seed for the payload generator (default: 1)\n"
+         "  -o, --output=FILE      write the generated stream to FILE\n"
+         "  -h, --help             print this help and exit\n"
+         );
+}
+
+int main(int argc, char *argv[])
+{
+  cBenchParams Params;
+  const char *OutputFile = NULL;
+  static struct option long_options[] = {
+      { "video",        required_argument, NULL, 'v' },
+      { "bitrate",      required_argument, NULL, 'b' },
+      { "ac3",          required_argument, NULL, 'a' },
+      { "filler",       required_argument, NULL, 'f' },
+      { "gop",          required_argument, NULL, 'g' },
+      { "no-subtitles", no_argument,       NULL, 'n' },
+      { "seconds",      required_argument, NULL, 's' },
+      { "runs",         required_argument, NULL, 'r' },
+      { "seed",         required_argument, NULL, 'S' },
+      { "output",       required_argument, NULL, 'o' },
+      { "help",         no_argument,       NULL, 'h' },
+      { NULL,           no_argument,       NULL,  0  }
+    };
+  int c;
+  while ((c = getopt_long(argc, argv, "v:b:a:f:g:ns:r:S:o:h", long_options, NULL)) != -1) {
+        switch (c) {
+          case 'v': if (strcmp(optarg, "h264") == 0)
+                       Params.vtype = 0x1B;
+                    else if (strcmp(optarg, "mpeg2") == 0)
+                       Params.vtype = 0x02;
+                    else {
+                       fprintf(stderr, "remuxbench: invalid video type: %s\n", optarg);
+                       return 2;
+                       }
+                    break;
+          case 'b': Params.videoBitrate = atoi(optarg); break;
+          case 'a': Params.ac3Bitrate = atoi(optarg); break;
+          case 'f': Params.fillerPercent = constrain(atoi(optarg), 0, 90); break;
+          case 'g': if (!*optarg || optarg[0] != 'I' || optarg[strspn(optarg, "IPB")]) {
+                       fprintf(stderr, "remuxbench: invalid GOP structure: %s\n", optarg);
+                       return 2;
+                       }
+                    Params.gop = optarg;
+                    break;
+          case 'n': Params.subtitles = false; break;
+          case 's': Params.seconds = max(atoi(optarg), 1); break;
+          case 'r': Params.runs = max(atoi(optarg), 1); break;
+          case 'S': Params.seed = strtoul(optarg, NULL, 10); break;
+          case 'o': OutputFile = optarg; break;
+          case 'h': Usage();
+                    return 0;
+          default:  Usage();
+                    return 2;
+          }
+        }
+  if (Params.videoBitrate < 100) {
+     fprintf(stderr, "remuxbench: video bitrate too low: %d\n", Params.videoBitrate);
+     return 2;
+     }
+
+  cTsGenerator Generator(Params);
+  Generator.Generate();
+  int Length = Generator.Length();
+  printf("stream: %s %d kbit/s, GOP %s%s, AC-3 %d kbit/s, subtitles %s, %d s = %d packets (%.1f MB)\n\n",
+         Params.vtype == 0x1B ? "H.264" : "MPEG-2", Params.videoBitrate, Params.gop,
+         Params.vtype == 0x1B ? *cString::sprintf(" with %d%% filler", Params.fillerPercent) : "",
+         Params.ac3Bitrate, Params.subtitles ? "yes" : "no", Params.seconds, Length / TS_SIZE, double(Length) / MEGABYTE(1));
+  if (OutputFile) {
+     if (FILE *f = fopen(OutputFile, "w")) {
+        if (fwrite(Generator.Data(), Length, 1, f) != 1)
+           fprintf(stderr, "remuxbench: error writing %s: %s\n", OutputFile, strerror(errno));
+        fclose(f);
+        }
+     else
+        fprintf(stderr, "remuxbench: can't open %s: %s\n", OutputFile, strerror(errno));
+     }
+
+  uchar *Copy = MALLOC(uchar, Length);
+  for (int b = 0; b < bCount; b++) {
+      if (b == bFrameDetectorAudio && !Params.ac3Bitrate)
+         continue;
+      uint64_t Best = 0;
+      int Result = 0;
+      for (int r = 0; r < Params.runs; r++) {
+          if (b == bNaluStreamProcessor)
+             memcpy(Copy, Generator.Data(), Length); // the NALU processor modifies the data in place
+          uint64_t t = NowNs();
+          switch (b) {
+            case bTsGetPts:             Result = BenchTsGetPts(Generator.Data(), Length); break;
+            case bPatPmtParser:         Result = BenchPatPmtParser(Generator.Data(), Length); break;
+            case bTsToPes:              Result = BenchTsToPes(Generator.Data(), Length); break;
+            case bFrameDetectorVideo:   Result = BenchFrameDetector(Generator.Data(), Length, BENCH_VPID, Params.vtype); break;
+            case bFrameDetectorAudio:   Result = BenchFrameDetector(Generator.Data(), Length, BENCH_DPID, 0x06); break;
+            case bNaluStreamProcessor:  Result = BenchNaluStreamProcessor(Copy, Length); break;
+            default: ;
+            }
+          t = NowNs() - t;
+          if (!Best || t < Best)
+             Best = t;
+          }
+      Report(b, Length, Best, Result);
+      }
+  free(Copy);
+  return 0;
+}
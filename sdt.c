@@ -45,12 +45,13 @@ void cSdtFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
          channel = Channels.GetByChannelID(tChannelID(Source(), 0, Transponder(), SiSdtService.getServiceId()));
 
       cLinkChannels *LinkChannels = NULL;
-      SI::Descriptor *d;
-      for (SI::Loop::Iterator it2; (d = SiSdtService.serviceDescriptors.getNext(it2)); ) {
-          switch (d->getDescriptorTag()) {
+      SI::DescriptorView d;
+      for (SI::Loop::Iterator it2; SiSdtService.serviceDescriptors.getNext(d, it2); ) {
+          switch (d.getDescriptorTag()) {
             case SI::ServiceDescriptorTag: {
-                 SI::ServiceDescriptor *sd = (SI::ServiceDescriptor *)d;
-                 switch (sd->getServiceType()) {
+                 SI::ServiceDescriptor sd;
+                 d.get(sd);
+                 switch (sd.getServiceType()) {
                    case 0x01: // digital television service
                    case 0x02: // digital radio sound service
                    case 0x04: // NVOD reference service
@@ -61,7 +62,7 @@ void cSdtFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                         char NameBuf[Utf8BufSize(1024)];
                         char ShortNameBuf[Utf8BufSize(1024)];
                         char ProviderNameBuf[Utf8BufSize(1024)];
-                        sd->serviceName.getText(NameBuf, ShortNameBuf, sizeof(NameBuf), sizeof(ShortNameBuf));
+                        sd.serviceName.getText(NameBuf, ShortNameBuf, sizeof(NameBuf), sizeof(ShortNameBuf));
                         char *pn = compactspace(NameBuf);
                         char *ps = compactspace(ShortNameBuf);
                         if (!*ps && cSource::IsCable(Source())) {
@@ -78,7 +79,7 @@ void cSdtFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                             if (*p == ',')
                                *p = '.';
                             }
-                        sd->providerName.getText(ProviderNameBuf, sizeof(ProviderNameBuf));
+                        sd.providerName.getText(ProviderNameBuf, sizeof(ProviderNameBuf));
                         char *pp = compactspace(ProviderNameBuf);
                         if (channel) {
                            channel->SetId(sdt.getOriginalNetworkId(), sdt.getTransportStreamId(), SiSdtService.getServiceId());
@@ -112,9 +113,10 @@ void cSdtFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  break;
             */
             case SI::NVODReferenceDescriptorTag: {
-                 SI::NVODReferenceDescriptor *nrd = (SI::NVODReferenceDescriptor *)d;
+                 SI::NVODReferenceDescriptor nrd;
+                 d.get(nrd);
                  SI::NVODReferenceDescriptor::Service Service;
-                 for (SI::Loop::Iterator it; nrd->serviceLoop.getNext(Service, it); ) {
+                 for (SI::Loop::Iterator it; nrd.serviceLoop.getNext(Service, it); ) {
                      cChannel *link = Channels.GetByChannelID(tChannelID(Source(), Service.getOriginalNetworkId(), Service.getTransportStream(), Service.getServiceId()));
                      if (!link && Setup.UpdateChannels >= 4) {
                         link = Channels.NewChannel(Channel(), "NVOD", "", "", Service.getOriginalNetworkId(), Service.getTransportStream(), Service.getServiceId());
@@ -130,7 +132,6 @@ void cSdtFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
                  break;
             default: ;
             }
-          delete d;
           }
       if (LinkChannels) {
          if (channel)
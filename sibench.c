@@ -0,0 +1,492 @@
+/*
+ * sibench.c: Micro benchmark for decoding the descriptors and texts of EIT data
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+// This program decodes the texts (titles, short texts, descriptions and
+// component descriptions) of all events in a set of EIT sections, as VDR does
+// when it receives EPG data, and measures how long the character table
+// conversion takes. The sections are either taken from a transport stream
+// capture (PID 0x12, for instance recorded with "dvbsnoop -s ts -b 0x12" or
+// "dvbstream 18") or, if no file is given, generated synthetically. In order
+// to check the converters that libsi caches, every string is also converted
+// the old way (opening an iconv descriptor for each string) and the results
+// are compared. Finally it measures how long it takes to just walk through
+// the descriptors, with descriptors allocated by DescriptorLoop::getNext() and
+// with DescriptorView. Build it with "make bench".
+
+#include <errno.h>
+#include <getopt.h>
+#include <iconv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libsi/descriptor.h"
+#include "libsi/section.h"
+#include "libsi/si.h"
+#include "tools.h"
+
+#define TS_SIZE      188
+#define EIT_PID      0x12
+#define MAXSECTION   4096
+#define TEXTBUFSIZE  Utf8BufSize(4096)
+
+// --- cBenchParams ----------------------------------------------------------
+
+struct cBenchParams {
+  const char *fileName;  // transport stream capture, NULL = synthetic data
+  const char *charset;   // the system character table
+  int sections;          // number of synthetic sections
+  int runs;              // number of runs per benchmark (the fastest one counts)
+  cBenchParams(void)
+  {
+    fileName = NULL;
+    charset = "UTF-8";
+    sections = 2000;
+    runs = 5;
+  }
+  };
+
+// --- Input data ------------------------------------------------------------
+
+static cVector<uchar *> Sections;
+
+static void AddSection(const uchar *Data, int Length)
+{
+  if (Length < 3 || Data[0] < 0x4E || Data[0] > 0x6F)
+     return;
+  SI::EIT Eit(Data, false);
+  if (Eit.getLength() != Length || !Eit.CheckCRCAndParse())
+     return;
+  uchar *p = MALLOC(uchar, Length);
+  memcpy(p, Data, Length);
+  Sections.Append(p);
+}
+
+static bool ReadCapture(const char *FileName)
+{
+  FILE *f = fopen(FileName, "r");
+  if (!f) {
+     fprintf(stderr, "can't open %s: %s\n", FileName, strerror(errno));
+     return false;
+     }
+  uchar Packet[TS_SIZE];
+  uchar Section[MAXSECTION + TS_SIZE];
+  int Length = 0;
+  bool Synced = false;
+  while (fread(Packet, TS_SIZE, 1, f) == 1) {
+        if (Packet[0] != 0x47) {
+           fprintf(stderr, "%s is not a transport stream\n", FileName);
+           fclose(f);
+           return false;
+           }
+        if ((((Packet[1] & 0x1F) << 8) | Packet[2]) != EIT_PID || !(Packet[3] & 0x10))
+           continue;
+        int Offset = 4;
+        if (Packet[3] & 0x20)
+           Offset += Packet[4] + 1; // adaptation field
+        if (Offset >= TS_SIZE)
+           continue;
+        if (Packet[1] & 0x40) { // payload unit start
+           int Pointer = Packet[Offset++];
+           if (Synced && Offset + Pointer <= TS_SIZE) {
+              memcpy(Section + Length, Packet + Offset, Pointer);
+              Length += Pointer;
+              }
+           // Handle all complete sections in the buffer:
+           for (int i = 0; Synced && i + 3 <= Length && Section[i] != 0xFF; ) {
+               int l = SI::Section::getLength(Section + i);
+               if (i + l > Length)
+                  break;
+               AddSection(Section + i, l);
+               i += l;
+               }
+           Offset += Pointer;
+           Length = 0;
+           Synced = true;
+           }
+        if (Synced && Offset < TS_SIZE && Length + TS_SIZE - Offset <= MAXSECTION) {
+           memcpy(Section + Length, Packet + Offset, TS_SIZE - Offset);
+           Length += TS_SIZE - Offset;
+           }
+        }
+  fclose(f);
+  return true;
+}
+
+// Some typical texts, in ISO6937 (the default) with the two byte sequences for
+// umlauts, in ISO-8859-15, ISO-8859-5 and UTF-8 (the texts may contain 0 bytes
+// in their character table selection):
+#define TEXT(s) { s, sizeof(s) - 1 }
+
+static struct {
+  const char *text;
+  int length;
+  } SyntheticTexts[] = {
+  TEXT("Tatort"),
+  TEXT("Die Sendung mit der Maus"),
+  TEXT("Sp\xC8" "atfilm: Der gro\xFB" "e Bluff"),
+  TEXT("\x10\x00\x0F" "Nachrichten aus aller Welt, Wetter und B\xF6rsenbericht"),
+  TEXT("\x01" "\xBD\xDE\xD2\xDE\xE1\xE2\xD8"),
+  TEXT("\x15" "Caf\xC3\xA9 Konzert in M\xC3\xBCnchen"),
+  TEXT("Spielfilm, Deutschland 2011. Kommissar M\xC8" "uller ermittelt in einem F\xC8" "all, der ihn an die Grenzen seiner F\xC8" "ahigkeiten bringt. Regie: J\xC8" "urgen Sch\xC8" "afer. Mit: Karl Kr\xC8" "uger, Anna Wei\xFB, Otto Br\xC8" "uckner"),
+  TEXT("\x10\x00\x0F" "Dokumentation \xFC" "ber die sch\xF6nsten Seen \xD6sterreichs und der Schweiz, mit Aufnahmen aus der Luft und unter Wasser."),
+  };
+
+static int AppendDescriptor(uchar *p, uchar Tag, const uchar *Data, int Length)
+{
+  p[0] = Tag;
+  p[1] = Length;
+  memcpy(p + 2, Data, Length);
+  return Length + 2;
+}
+
+static int AppendText(uchar *p, int Index)
+{
+  *p = SyntheticTexts[Index].length;
+  memcpy(p + 1, SyntheticTexts[Index].text, SyntheticTexts[Index].length);
+  return SyntheticTexts[Index].length + 1;
+}
+
+static void MakeSections(int NumSections)
+{
+  for (int n = 0; n < NumSections; n++) {
+      uchar Section[MAXSECTION];
+      int p = 14;
+      for (int e = 0; e < 4; e++) {
+          int EventId = n * 4 + e;
+          int StartTime = 1800 * EventId;
+          Section[p++] = EventId >> 8;
+          Section[p++] = EventId;
+          Section[p++] = (56000 + StartTime / 86400) >> 8;
+          Section[p++] = (56000 + StartTime / 86400) & 0xFF;
+          Section[p++] = 0; Section[p++] = 0; Section[p++] = 0; // BCD times don't matter here
+          Section[p++] = 0; Section[p++] = 0x30; Section[p++] = 0;
+          int DescriptorsStart = p;
+          p += 2;
+          uchar Buffer[256];
+          // short event descriptor:
+          int l = 0;
+          memcpy(Buffer, "deu", 3);
+          l = 3;
+          l += AppendText(Buffer + l, (EventId * 7) % 6);
+          l += AppendText(Buffer + l, (EventId * 3 + 1) % 6);
+          p += AppendDescriptor(Section + p, SI::ShortEventDescriptorTag, Buffer, l);
+          // extended event descriptor:
+          Buffer[0] = 0x00;
+          memcpy(Buffer + 1, "deu", 3);
+          Buffer[4] = 0; // no items
+          l = 5 + AppendText(Buffer + 5, 6 + EventId % 2);
+          p += AppendDescriptor(Section + p, SI::ExtendedEventDescriptorTag, Buffer, l);
+          // component descriptor:
+          Buffer[0] = 0x02;
+          Buffer[1] = 0x03;
+          Buffer[2] = 0;
+          memcpy(Buffer + 3, "deu", 3);
+          memcpy(Buffer + 6, "Stereo", 6);
+          p += AppendDescriptor(Section + p, SI::ComponentDescriptorTag, Buffer, 12);
+          int DescriptorsLength = p - DescriptorsStart - 2;
+          Section[DescriptorsStart] = 0x10 | (DescriptorsLength >> 8);
+          Section[DescriptorsStart + 1] = DescriptorsLength;
+          }
+      int SectionLength = p + 4 - 3;
+      Section[0] = 0x50;
+      Section[1] = 0xF0 | (SectionLength >> 8);
+      Section[2] = SectionLength;
+      Section[3] = (1 + n / 32) >> 8; // service id
+      Section[4] = 1 + n / 32;
+      Section[5] = 0xC1;
+      Section[6] = n % 32 * 8;
+      Section[7] = 0xF8;
+      Section[8] = 0; Section[9] = 1;   // transport stream id
+      Section[10] = 0; Section[11] = 1; // original network id
+      Section[12] = 0xF8;
+      Section[13] = 0x50;
+      uint32_t crc = SI::CRC32::crc32((const char *)Section, p, 0xFFFFFFFF);
+      Section[p++] = crc >> 24;
+      Section[p++] = crc >> 16;
+      Section[p++] = crc >> 8;
+      Section[p++] = crc;
+      AddSection(Section, p);
+      }
+}
+
+// --- Strings ---------------------------------------------------------------
+
+struct cRawString {
+  const char *charset;
+  char *text; // already stripped of the control codes, as String::decodeText() does
+  int length;
+  };
+
+static cVector<cRawString *> RawStrings;
+
+static void AddString(SI::String &s)
+{
+  const uchar *from = s.getData().getData();
+  int len = s.getLength();
+  if (len <= 0)
+     return;
+  cRawString *r = new cRawString;
+  r->charset = SI::getCharacterTable(from, len);
+  r->text = MALLOC(char, len + 1);
+  char *to = r->text;
+  for (int i = 0; i < len && from[i]; i++) {
+      if (' ' <= from[i] && from[i] <= '~' || from[i] == '\n' || 0xA0 <= from[i])
+         *to++ = from[i];
+      else if (from[i] == 0x8A)
+         *to++ = '\n';
+      }
+  *to = 0;
+  r->length = to - r->text;
+  RawStrings.Append(r);
+}
+
+template<class F> static void ForEachStringIn(SI::ShortEventDescriptor &sed, F &Function)
+{
+  Function(sed.name);
+  Function(sed.text);
+}
+
+template<class F> static void ForEachStringIn(SI::ExtendedEventDescriptor &eed, F &Function)
+{
+  SI::ExtendedEventDescriptor::Item Item;
+  for (SI::Loop::Iterator it; eed.itemLoop.getNext(Item, it); ) {
+      Function(Item.itemDescription);
+      Function(Item.item);
+      }
+  Function(eed.text);
+}
+
+template<class F> static void ForEachStringIn(SI::ComponentDescriptor &cd, F &Function)
+{
+  Function(cd.description);
+}
+
+// Calls Function for every string in the EIT sections. If Allocate is true,
+// the descriptors are taken from DescriptorLoop::getNext(Iterator &it), which
+// allocates each of them, as VDR did before it used DescriptorView:
+template<class F> static void ForEachString(F Function, bool Allocate = false)
+{
+  for (int i = 0; i < Sections.Size(); i++) {
+      SI::EIT Eit(Sections[i], false);
+      Eit.CheckParse();
+      SI::EIT::Event Event;
+      for (SI::Loop::Iterator it; Eit.eventLoop.getNext(Event, it); ) {
+          if (Allocate) {
+             SI::Descriptor *d;
+             for (SI::Loop::Iterator it2; (d = Event.eventDescriptors.getNext(it2)); ) {
+                 switch (d->getDescriptorTag()) {
+                   case SI::ShortEventDescriptorTag:
+                        ForEachStringIn(*(SI::ShortEventDescriptor *)d, Function);
+                        break;
+                   case SI::ExtendedEventDescriptorTag:
+                        ForEachStringIn(*(SI::ExtendedEventDescriptor *)d, Function);
+                        break;
+                   case SI::ComponentDescriptorTag:
+                        ForEachStringIn(*(SI::ComponentDescriptor *)d, Function);
+                        break;
+                   default: ;
+                   }
+                 delete d;
+                 }
+             }
+          else {
+             SI::DescriptorView d;
+             for (SI::Loop::Iterator it2; Event.eventDescriptors.getNext(d, it2); ) {
+                 switch (d.getDescriptorTag()) {
+                   case SI::ShortEventDescriptorTag: {
+                        SI::ShortEventDescriptor sed;
+                        ForEachStringIn(d.get(sed), Function);
+                        }
+                        break;
+                   case SI::ExtendedEventDescriptorTag: {
+                        SI::ExtendedEventDescriptor eed;
+                        ForEachStringIn(d.get(eed), Function);
+                        }
+                        break;
+                   case SI::ComponentDescriptorTag: {
+                        SI::ComponentDescriptor cd;
+                        ForEachStringIn(d.get(cd), Function);
+                        }
+                        break;
+                   default: ;
+                   }
+                 }
+             }
+          }
+      }
+}
+
+// --- Benchmarks ------------------------------------------------------------
+
+static const char *SystemCharset = NULL;
+
+// This is how libsi used to convert strings before it cached its converters:
+static void ConvertUncached(const char *from, size_t fromLength, char *to, size_t toLength, const char *fromCode)
+{
+  *to = 0;
+  iconv_t cd = iconv_open(SystemCharset, fromCode);
+  if (cd != (iconv_t)-1) {
+     char *fromPtr = (char *)from;
+     toLength--; // for the terminating 0
+     while (fromLength > 0 && toLength > 0) {
+           if (iconv(cd, &fromPtr, &fromLength, &to, &toLength) == size_t(-1)) {
+              if (errno == EILSEQ) {
+                 fromPtr++;
+                 fromLength--;
+                 *to++ = '?';
+                 toLength--;
+                 }
+              else
+                 break;
+              }
+           }
+     *to = 0;
+     iconv_close(cd);
+     }
+}
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+enum eBench { bUncached, bCached, bDecode, bAllocate, bView, bCount };
+
+static const char *BenchNames[bCount] = {
+  "iconv per string",
+  "cached converters",
+  "String::getText()",
+  "getNext() + new",
+  "DescriptorView",
+  };
+
+static char Buffer[TEXTBUFSIZE];
+
+struct cDecoder {
+  void operator() (SI::String &s) { s.getText(Buffer, sizeof(Buffer)); }
+  };
+
+// Only sets up the descriptors, without converting their texts:
+static int TotalLength = 0;
+
+struct cCounter {
+  void operator() (SI::String &s) { TotalLength += s.getLength(); }
+  };
+
+static void Bench(int b)
+{
+  switch (b) {
+    case bUncached: for (int i = 0; i < RawStrings.Size(); i++)
+                        ConvertUncached(RawStrings[i]->text, RawStrings[i]->length, Buffer, sizeof(Buffer), RawStrings[i]->charset);
+                    break;
+    case bCached:   for (int i = 0; i < RawStrings.Size(); i++)
+                        SI::convertCharacterTable(RawStrings[i]->text, RawStrings[i]->length, Buffer, sizeof(Buffer), RawStrings[i]->charset);
+                    break;
+    case bDecode:   ForEachString(cDecoder());
+                    break;
+    case bAllocate: ForEachString(cCounter(), true);
+                    break;
+    case bView:     ForEachString(cCounter());
+                    break;
+    default: ;
+    }
+}
+
+static int Verify(void)
+{
+  int Errors = 0;
+  char Expected[TEXTBUFSIZE];
+  for (int i = 0; i < RawStrings.Size(); i++) {
+      ConvertUncached(RawStrings[i]->text, RawStrings[i]->length, Expected, sizeof(Expected), RawStrings[i]->charset);
+      SI::convertCharacterTable(RawStrings[i]->text, RawStrings[i]->length, Buffer, sizeof(Buffer), RawStrings[i]->charset);
+      if (strcmp(Expected, Buffer) != 0) {
+         if (Errors++ < 10)
+            fprintf(stderr, "mismatch (%s): '%s' != '%s'\n", RawStrings[i]->charset, Buffer, Expected);
+         }
+      }
+  return Errors;
+}
+
+static void Usage(void)
+{
+  printf("Usage: sibench [OPTIONS] [FILE]\n\n"
+         "FILE is a transport stream that contains EIT data (PID 0x12). If no FILE is\n"
+         "given, synthetic EIT sections are used.\n\n"
+         "  -c CS, --charset=CS  the system character table (default: UTF-8)\n"
+         "  -s N,  --sections=N  number of synthetic sections (default: 2000)\n"
+         "  -r N,  --runs=N      runs per benchmark, the fastest one counts (default: 5)\n"
+         "  -h,    --help        print this help and exit\n"
+         );
+}
+
+int main(int argc, char *argv[])
+{
+  cBenchParams Params;
+  static struct option long_options[] = {
+      { "charset",  required_argument, NULL, 'c' },
+      { "sections", required_argument, NULL, 's' },
+      { "runs",     required_argument, NULL, 'r' },
+      { "help",     no_argument,       NULL, 'h' },
+      { NULL,       no_argument,       NULL,  0  }
+    };
+  int c;
+  while ((c = getopt_long(argc, argv, "c:s:r:h", long_options, NULL)) != -1) {
+        switch (c) {
+          case 'c': Params.charset = optarg; break;
+          case 's': Params.sections = max(atoi(optarg), 1); break;
+          case 'r': Params.runs = max(atoi(optarg), 1); break;
+          case 'h': Usage();
+                    return 0;
+          default:  Usage();
+                    return 2;
+          }
+        }
+  if (optind < argc)
+     Params.fileName = argv[optind];
+
+  if (!SI::SetSystemCharacterTable(Params.charset)) {
+     fprintf(stderr, "unknown character table: %s\n", Params.charset);
+     return 2;
+     }
+  SystemCharset = Params.charset;
+  if (Params.fileName) {
+     if (!ReadCapture(Params.fileName))
+        return 1;
+     }
+  else
+     MakeSections(Params.sections);
+  ForEachString(AddString);
+  size_t Bytes = 0;
+  for (int i = 0; i < RawStrings.Size(); i++)
+      Bytes += RawStrings[i]->length;
+  printf("%s: %d EIT sections, %d strings, %zd bytes, system character table %s\n\n", Params.fileName ? Params.fileName : "synthetic data", Sections.Size(), RawStrings.Size(), Bytes, Params.charset);
+  if (!RawStrings.Size())
+     return 1;
+
+  int Errors = Verify();
+  if (Errors)
+     printf("%d of %d strings are converted differently than with iconv!\n\n", Errors, RawStrings.Size());
+
+  printf("%-20s %12s %12s %12s\n", "benchmark", "ms", "ns/string", "MB/s");
+  for (int b = 0; b < bCount; b++) {
+      uint64_t Best = 0;
+      for (int r = 0; r < Params.runs; r++) {
+          uint64_t t = NowNs();
+          Bench(b);
+          t = NowNs() - t;
+          if (!Best || t < Best)
+             Best = t;
+          }
+      printf("%-20s %12.1f %12.0f %12.1f\n", BenchNames[b], Best / 1e6, double(Best) / RawStrings.Size(), Bytes * 1e3 / Best);
+      }
+  return Errors ? 1 : 0;
+}
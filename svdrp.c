@@ -203,10 +203,13 @@ const char *HelpPages[] = {
   "    RECORDING - BE SURE YOU KNOW WHAT YOU ARE DOING!",
   "DELT <number>\n"
   "    Delete timer.",
-  "EDIT <number>\n"
+  "EDIT [ <number> ]\n"
   "    Edit the recording with the given number. Before a recording can be\n"
   "    edited, an LSTR command must have been executed in order to retrieve\n"
-  "    the recording numbers.",
+  "    the recording numbers. If other recordings are currently being edited,\n"
+  "    the recording may be queued and edited later. Without option, the\n"
+  "    queued and running editing processes are listed, together with their\n"
+  "    progress.",
   "GRAB <filename> [ <quality> [ <sizex> <sizey> ] ]\n"
   "    Grab the current frame and save it to the given file. Images can\n"
   "    be stored as JPEG or PNM, depending on the given file name extension.\n"
@@ -307,8 +310,21 @@ const char *HelpPages[] = {
   "SCAN\n"
   "    Forces an EPG scan. If this is a single DVB device system, the scan\n"
   "    will be done on the primary device unless it is currently recording.",
+  "SRCH [ channel <channel> ] [ from <time> ] [ to <time> ] <query>\n"
+  "    Search the EPG data. All events that contain every word of the query\n"
+  "    in their title, short text or description are listed in the same\n"
+  "    format as with LSTE: one block per channel (in the order of the channel\n"
+  "    numbers), with the events ordered by their start times. Words are\n"
+  "    matched as a whole and regardless of case; words enclosed in double\n"
+  "    quotes must occur as a phrase. If a channel is given (either by number\n"
+  "    or by channel ID), only events of that channel are listed. 'from' and\n"
+  "    'to' restrict the result to events that overlap with the given time\n"
+  "    range (in time_t form). To search for one of the option keywords,\n"
+  "    put it in double quotes.",
   "STAT disk\n"
-  "    Return information about disk usage (total, free, percent).",
+  "    Return information about disk usage (total, free, percent).\n"
+  "STAT epg\n"
+  "    Return information about the memory used by the EPG data.",
   "UPDT <settings>\n"
   "    Updates a timer. Settings must be in the same format as returned\n"
   "    by the LSTT command. If a timer with the same channel, day, start\n"
@@ -627,9 +643,9 @@ void cSVDRP::CmdDELC(const char *Option)
               int CurrentChannelNr = cDevice::CurrentChannel();
               cChannel *CurrentChannel = Channels.GetByNumber(CurrentChannelNr);
               if (CurrentChannel && channel == CurrentChannel) {
-                 int n = Channels.GetNextNormal(CurrentChannel->Index());
+                 int n = Channels.GetNextNormal(Channels.Index(CurrentChannel));
                  if (n < 0)
-                    n = Channels.GetPrevNormal(CurrentChannel->Index());
+                    n = Channels.GetPrevNormal(Channels.Index(CurrentChannel));
                  CurrentChannel = Channels.Get(n);
                  CurrentChannelNr = 0; // triggers channel switch below
                  }
@@ -727,9 +743,9 @@ void cSVDRP::CmdEDIT(const char *Option)
         if (recording) {
            cMarks Marks;
            if (Marks.Load(recording->FileName(), recording->FramesPerSecond(), recording->IsPesRecording()) && Marks.Count()) {
-              if (!cCutter::Active()) {
+              if (!cCutter::Active(recording->FileName())) {
                  if (cCutter::Start(recording->FileName()))
-                    Reply(250, "Editing recording \"%s\" [%s]", Option, recording->Title());
+                    Reply(250, "%s recording \"%s\" [%s]", cCutter::Waiting(recording->FileName()) ? "Queued" : "Editing", Option, recording->Title());
                  else
                     Reply(554, "Can't start editing process");
                  }
@@ -745,8 +761,15 @@ void cSVDRP::CmdEDIT(const char *Option)
      else
         Reply(501, "Error in recording number \"%s\"", Option);
      }
-  else
-     Reply(501, "Missing recording number");
+  else {
+     cStringList Status;
+     if (cCutter::Status(Status)) {
+        for (int i = 0; i < Status.Size(); i++)
+            Reply(i < Status.Size() - 1 ? -250 : 250, "%d %s", i + 1, Status[i]);
+        }
+     else
+        Reply(550, "No editing processes");
+     }
 }
 
 void cSVDRP::CmdGRAB(const char *Option)
@@ -993,85 +1016,101 @@ void cSVDRP::CmdLSTC(const char *Option)
 
 void cSVDRP::CmdLSTE(const char *Option)
 {
-  cSchedulesLock SchedulesLock;
-  const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
-  if (Schedules) {
-     const cSchedule* Schedule = NULL;
-     eDumpMode DumpMode = dmAll;
-     time_t AtTime = 0;
-     if (*Option) {
-        char buf[strlen(Option) + 1];
-        strcpy(buf, Option);
-        const char *delim = " \t";
-        char *strtok_next;
-        char *p = strtok_r(buf, delim, &strtok_next);
-        while (p && DumpMode == dmAll) {
-              if (strcasecmp(p, "NOW") == 0)
-                 DumpMode = dmPresent;
-              else if (strcasecmp(p, "NEXT") == 0)
-                 DumpMode = dmFollowing;
-              else if (strcasecmp(p, "AT") == 0) {
-                 DumpMode = dmAtTime;
-                 if ((p = strtok_r(NULL, delim, &strtok_next)) != NULL) {
-                    if (isnumber(p))
-                       AtTime = strtol(p, NULL, 10);
-                    else {
-                       Reply(501, "Invalid time");
-                       return;
-                       }
-                    }
-                 else {
-                    Reply(501, "Missing time");
-                    return;
-                    }
-                 }
-              else if (!Schedule) {
-                 cChannel* Channel = NULL;
+  cChannel *Channel = NULL;
+  eDumpMode DumpMode = dmAll;
+  time_t AtTime = 0;
+  if (*Option) {
+     char buf[strlen(Option) + 1];
+     strcpy(buf, Option);
+     const char *delim = " \t";
+     char *strtok_next;
+     char *p = strtok_r(buf, delim, &strtok_next);
+     while (p && DumpMode == dmAll) {
+           if (strcasecmp(p, "NOW") == 0)
+              DumpMode = dmPresent;
+           else if (strcasecmp(p, "NEXT") == 0)
+              DumpMode = dmFollowing;
+           else if (strcasecmp(p, "AT") == 0) {
+              DumpMode = dmAtTime;
+              if ((p = strtok_r(NULL, delim, &strtok_next)) != NULL) {
                  if (isnumber(p))
-                    Channel = Channels.GetByNumber(strtol(Option, NULL, 10));
-                 else
-                    Channel = Channels.GetByChannelID(tChannelID::FromString(Option));
-                 if (Channel) {
-                    Schedule = Schedules->GetSchedule(Channel);
-                    if (!Schedule) {
-                       Reply(550, "No schedule found");
-                       return;
-                       }
-                    }
+                    AtTime = strtol(p, NULL, 10);
                  else {
-                    Reply(550, "Channel \"%s\" not defined", p);
+                    Reply(501, "Invalid time");
                     return;
                     }
                  }
               else {
-                 Reply(501, "Unknown option: \"%s\"", p);
+                 Reply(501, "Missing time");
                  return;
                  }
-              p = strtok_r(NULL, delim, &strtok_next);
               }
-        }
-     int fd = dup(file);
-     if (fd) {
-        FILE *f = fdopen(fd, "w");
-        if (f) {
-           if (Schedule)
-              Schedule->Dump(f, "215-", DumpMode, AtTime);
-           else
-              Schedules->Dump(f, "215-", DumpMode, AtTime);
-           fflush(f);
-           Reply(215, "End of EPG data");
-           fclose(f);
-           }
-        else {
-           Reply(451, "Can't open file connection");
-           close(fd);
+           else if (!Channel) {
+              if (isnumber(p))
+                 Channel = Channels.GetByNumber(strtol(Option, NULL, 10));
+              else
+                 Channel = Channels.GetByChannelID(tChannelID::FromString(Option));
+              if (!Channel) {
+                 Reply(550, "Channel \"%s\" not defined", p);
+                 return;
+                 }
+              }
+           else {
+              Reply(501, "Unknown option: \"%s\"", p);
+              return;
+              }
+           p = strtok_r(NULL, delim, &strtok_next);
            }
+     }
+  // The data is formatted while holding the schedules lock, but the
+  // client may take its time reading it, so it is sent afterwards:
+  char *Buffer = NULL;
+  size_t Size = 0;
+  {
+    cSchedulesLock SchedulesLock;
+    const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
+    if (!Schedules) {
+       Reply(451, "Can't get EPG data");
+       return;
+       }
+    const cSchedule *Schedule = NULL;
+    if (Channel) {
+       Schedule = Schedules->GetSchedule(Channel);
+       if (!Schedule) {
+          Reply(550, "No schedule found");
+          return;
+          }
+       }
+    FILE *f = open_memstream(&Buffer, &Size);
+    if (!f) {
+       Reply(451, "Can't open memory stream");
+       return;
+       }
+    if (Schedule)
+       Schedule->Dump(f, "215-", DumpMode, AtTime);
+    else {
+       for (const cSchedule *p = Schedules->First(); p; p = Schedules->Next(p))
+           p->Dump(f, "215-", DumpMode, AtTime);
+       }
+    fclose(f);
+  }
+  int fd = dup(file);
+  if (fd >= 0) {
+     FILE *f = fdopen(fd, "w");
+     if (f) {
+        fwrite(Buffer, Size, 1, f);
+        fflush(f);
+        Reply(215, "End of EPG data");
+        fclose(f);
+        }
+     else {
+        Reply(451, "Can't open file connection");
+        close(fd);
         }
-     else
-        Reply(451, "Can't dup stream descriptor");
      }
   else
-     Reply(451, "Can't get EPG data");
+     Reply(451, "Can't dup stream descriptor");
+  free(Buffer);
 }
 
 void cSVDRP::CmdLSTR(const char *Option)
@@ -1519,6 +1558,146 @@ void cSVDRP::CmdSCAN(const char *Option)
   Reply(250, "EPG scan triggered");
 }
 
+// cSchedules::Search() orders the events by their start times, but SRCH lists
+// them in one block per channel, like LSTE does:
+
+struct tSrchResult {
+  const cEvent *event;
+  const cChannel *channel;
+  int number; // the channel's number (INT_MAX if the channel is unknown)
+  int index; // in the result of cSchedules::Search()
+  };
+
+static int CompareSrchResults(const void *a, const void *b)
+{
+  const tSrchResult *r1 = (const tSrchResult *)a;
+  const tSrchResult *r2 = (const tSrchResult *)b;
+  if (r1->number != r2->number)
+     return r1->number < r2->number ? -1 : 1;
+  if (r1->event->Schedule() != r2->event->Schedule()) // different unknown channels
+     return r1->event->Schedule() < r2->event->Schedule() ? -1 : 1;
+  return r1->index - r2->index;
+}
+
+void cSVDRP::CmdSRCH(const char *Option)
+{
+  tChannelID ChannelID = tChannelID::InvalidID;
+  time_t From = 0;
+  time_t To = 0;
+  // The options come first, the rest is the query:
+  const char *Query = skipspace(Option);
+  for (;;) {
+      const char *p = Query;
+      while (*p && !isspace(*p))
+            p++;
+      char Keyword[p - Query + 1];
+      strn0cpy(Keyword, Query, sizeof(Keyword));
+      if (strcasecmp(Keyword, "CHANNEL") && strcasecmp(Keyword, "FROM") && strcasecmp(Keyword, "TO"))
+         break;
+      const char *v = skipspace(p);
+      p = v;
+      while (*p && !isspace(*p))
+            p++;
+      char Value[p - v + 1];
+      strn0cpy(Value, v, sizeof(Value));
+      if (!*Value) {
+         Reply(501, "Missing value for \"%s\"", Keyword);
+         return;
+         }
+      if (strcasecmp(Keyword, "CHANNEL") == 0) {
+         cChannel *Channel = isnumber(Value) ? Channels.GetByNumber(strtol(Value, NULL, 10)) : Channels.GetByChannelID(tChannelID::FromString(Value));
+         if (!Channel) {
+            Reply(550, "Channel \"%s\" not defined", Value);
+            return;
+            }
+         ChannelID = Channel->GetChannelID();
+         }
+      else if (!isnumber(Value)) {
+         Reply(501, "Invalid time");
+         return;
+         }
+      else if (strcasecmp(Keyword, "FROM") == 0)
+         From = strtol(Value, NULL, 10);
+      else
+         To = strtol(Value, NULL, 10);
+      Query = skipspace(p);
+      }
+  if (!*Query) {
+     Reply(501, "Missing query");
+     return;
+     }
+  // The events are formatted while holding the schedules lock, but the
+  // client may take its time reading them, so they are sent afterwards:
+  char *Buffer = NULL;
+  size_t Size = 0;
+  int Found = 0;
+  {
+    cSchedulesLock SchedulesLock;
+    const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
+    if (!Schedules) {
+       Reply(451, "Can't get EPG data");
+       return;
+       }
+    cVector<const cEvent *> Events;
+    Found = Schedules->Search(Query, Events, ChannelID, From, To);
+    if (Found) {
+       FILE *f = open_memstream(&Buffer, &Size);
+       if (!f) {
+          Reply(451, "Can't open memory stream");
+          return;
+          }
+       tSrchResult *Results = MALLOC(tSrchResult, Events.Size());
+       if (!Results) {
+          fclose(f);
+          free(Buffer);
+          Reply(451, "Out of memory");
+          return;
+          }
+       for (int i = 0; i < Events.Size(); i++) {
+           Results[i].event = Events[i];
+           Results[i].channel = Channels.GetByChannelID(Events[i]->ChannelID(), true);
+           Results[i].number = Results[i].channel ? Results[i].channel->Number() : INT_MAX;
+           Results[i].index = i;
+           }
+       qsort(Results, Events.Size(), sizeof(tSrchResult), CompareSrchResults);
+       for (int i = 0; i < Events.Size(); i++) {
+           const cEvent *Event = Results[i].event;
+           if (i == 0 || Event->Schedule() != Results[i - 1].event->Schedule()) {
+              if (i)
+                 fprintf(f, "215-c\n");
+              const cChannel *Channel = Results[i].channel;
+              fprintf(f, "215-C %s %s\n", *(Channel ? Channel->GetChannelID() : Event->ChannelID()).ToString(), Channel ? Channel->Name() : "");
+              }
+           Event->Dump(f, "215-");
+           }
+       fprintf(f, "215-c\n");
+       fclose(f);
+       free(Results);
+       }
+  }
+  if (!Found) {
+     Reply(550, "No matching events found");
+     return;
+     }
+  int fd = dup(file);
+  if (fd >= 0) {
+     FILE *f = fdopen(fd, "w");
+     if (f) {
+        fwrite(Buffer, Size, 1, f);
+        fflush(f);
+        Reply(215, "End of EPG data");
+        fclose(f);
+        }
+     else {
+        Reply(451, "Can't open file connection");
+        close(fd);
+        }
+     }
+  else
+     Reply(451, "Can't dup stream descriptor");
+  free(Buffer);
+}
+
 void cSVDRP::CmdSTAT(const char *Option)
 {
   if (*Option) {
@@ -1527,6 +1706,8 @@ void cSVDRP::CmdSTAT(const char *Option)
         int Percent = VideoDiskSpace(&FreeMB, &UsedMB);
         Reply(250, "%dMB %dMB %d%%", FreeMB + UsedMB, FreeMB, Percent);
         }
+     else if (strcasecmp(Option, "EPG") == 0)
+        Reply(250, "%s", *cSchedules::MemoryStats());
      else
         Reply(501, "Invalid Option \"%s\"", Option);
      }
@@ -1641,6 +1822,7 @@ void cSVDRP::Execute(char *Cmd)
   else if (CMD("PUTE"))  CmdPUTE(s);
   else if (CMD("REMO"))  CmdREMO(s);
   else if (CMD("SCAN"))  CmdSCAN(s);
+  else if (CMD("SRCH"))  CmdSRCH(s);
   else if (CMD("STAT"))  CmdSTAT(s);
   else if (CMD("UPDR"))  CmdUPDR(s);
   else if (CMD("UPDT"))  CmdUPDT(s);
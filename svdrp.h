@@ -79,6 +79,7 @@ private:
   void CmdPUTE(const char *Option);
   void CmdREMO(const char *Option);
   void CmdSCAN(const char *Option);
+  void CmdSRCH(const char *Option);
   void CmdSTAT(const char *Option);
   void CmdUPDT(const char *Option);
   void CmdUPDR(const char *Option);
@@ -524,7 +524,7 @@ void cTimer::SetEventFromSchedule(const cSchedules *Schedules)
               return; // let the recording end first
            // VPS timers only match if their start time exactly matches the event's VPS time:
            for (const cEvent *e = Schedule->Events()->First(); e; e = Schedule->Events()->Next(e)) {
-               if (e->StartTime() && e->RunningStatus() != SI::RunningStatusNotRunning) { // skip outdated events
+               if (e->Vps() && e->StartTime() && e->RunningStatus() != SI::RunningStatusNotRunning) { // only events with VPS can match, and outdated ones are skipped
                   int overlap = 0;
                   Matches(e, &overlap);
                   if (overlap > FULLMATCH) {
@@ -543,11 +543,10 @@ void cTimer::SetEventFromSchedule(const cSchedules *Schedules)
            Matches(0, true);
            time_t TimeFrameBegin = StartTime() - EPGLIMITBEFORE;
            time_t TimeFrameEnd   = StopTime()  + EPGLIMITAFTER;
-           for (const cEvent *e = Schedule->Events()->First(); e; e = Schedule->Events()->Next(e)) {
-               if (e->EndTime() < TimeFrameBegin)
-                  continue; // skip events way before the timer starts
-               if (e->StartTime() > TimeFrameEnd)
-                  break; // the rest is way after the timer ends
+           cVector<const cEvent *> Events;
+           Schedule->GetEvents(TimeFrameBegin, TimeFrameEnd, Events);
+           for (int i = 0; i < Events.Size(); i++) {
+               const cEvent *e = Events[i];
                int overlap = 0;
                Matches(e, &overlap);
                if (overlap && overlap >= Overlap) {
@@ -683,6 +682,62 @@ void cTimer::OnOff(void)
 
 // --- cTimers ---------------------------------------------------------------
 
+// The schedule menus look up the matching timer of every event they display,
+// so GetMatch(const cEvent *) only checks the timers on the event's channel.
+// For this the timers are kept in an index that is sorted by channel (and by
+// their position in the list, so that the result is the same as if all timers
+// were checked). The index is rebuilt whenever the timers have been modified.
+// Plugins may call GetMatch() from their own threads, so the index is protected
+// by a mutex, and building it doesn't modify the timers.
+// Since cTimer::Matches() has to do quite some calculations with local times,
+// the index also holds the times of each timer, which allow ruling out most
+// events right away.
+
+#define TIMERINDEXSLACK 3600 // seconds a timer's times may be off, since mktime() isn't consistent around DST changes
+
+struct tTimerIndexEntry {
+  const cChannel *channel;
+  int position; // in the list of timers
+  cTimer *timer;
+  time_t start; // the start and stop time of a single event timer, 0 for a repeating timer
+  time_t stop;
+  int begin;    // a repeating timer's start time in seconds from midnight...
+  int length;   // ...and its length in seconds
+  bool MayMatch(const cEvent *Event, int &EventBegin) const;
+       ///< Returns false if timer->Matches(Event) would certainly return tmNone.
+       ///< EventBegin is the Event's (VPS) start time in seconds from midnight,
+       ///< which is calculated the first time it is needed (-1 = not yet).
+  };
+
+bool tTimerIndexEntry::MayMatch(const cEvent *Event, int &EventBegin) const
+{
+  bool UseVps = timer->HasFlags(tfVps) && Event->Vps();
+  if (start) {
+     if (UseVps)
+        return abs(int(Event->Vps() - start)) <= TIMERINDEXSLACK;
+     return start - TIMERINDEXSLACK <= Event->EndTime() && Event->StartTime() <= stop + TIMERINDEXSLACK;
+     }
+  if (EventBegin < 0) {
+     time_t t = UseVps ? Event->Vps() : Event->StartTime();
+     struct tm tm_r;
+     localtime_r(&t, &tm_r);
+     EventBegin = tm_r.tm_hour * 3600 + tm_r.tm_min * 60 + tm_r.tm_sec;
+     }
+  // The event and the timer must overlap on a 24 hour clock:
+  int Duration = UseVps ? 0 : Event->Duration();
+  int Delta = ((EventBegin - begin) % SECSINDAY + SECSINDAY) % SECSINDAY;
+  return Delta <= length + TIMERINDEXSLACK || Delta >= SECSINDAY - Duration - TIMERINDEXSLACK;
+}
+
+static int CompareTimerIndexEntries(const void *a, const void *b)
+{
+  const tTimerIndexEntry *e1 = (const tTimerIndexEntry *)a;
+  const tTimerIndexEntry *e2 = (const tTimerIndexEntry *)b;
+  if (e1->channel != e2->channel)
+     return e1->channel < e2->channel ? -1 : 1;
+  return e1->position - e2->position;
+}
+
 cTimers Timers;
 
 cTimers::cTimers(void)
@@ -691,6 +746,69 @@ cTimers::cTimers(void)
   beingEdited = 0;;
   lastSetEvents = 0;
   lastDeleteExpired = 0;
+  index = NULL;
+  indexSize = 0;
+  indexState = 0;
+  indexCount = -1;
+}
+
+cTimers::~cTimers()
+{
+  free(index);
+}
+
+void cTimers::UpdateIndex(void)
+{
+  if (indexState == state && indexCount == Count())
+     return;
+  indexSize = 0;
+  if (Count() > 0) {
+     tTimerIndexEntry *NewIndex = (tTimerIndexEntry *)realloc(index, Count() * sizeof(tTimerIndexEntry));
+     if (!NewIndex) {
+        esyslog("ERROR: out of memory");
+        return;
+        }
+     index = NewIndex;
+     }
+  for (cTimer *ti = First(); ti; ti = Next(ti)) {
+      tTimerIndexEntry *e = &index[indexSize];
+      e->channel = ti->Channel();
+      e->position = indexSize++;
+      e->timer = ti;
+      e->start = e->stop = 0;
+      e->begin = cTimer::TimeToInt(ti->Start());
+      e->length = cTimer::TimeToInt(ti->Stop()) - e->begin;
+      if (e->length < 0)
+         e->length += SECSINDAY;
+      if (ti->IsSingleEvent()) {
+         // the same times as cTimer::Matches() would calculate:
+         e->start = cTimer::SetTime(ti->Day(), e->begin);
+         e->stop = e->start + e->length;
+         }
+      }
+  qsort(index, indexSize, sizeof(tTimerIndexEntry), CompareTimerIndexEntries);
+  indexState = state;
+  indexCount = Count();
+}
+
+void cTimers::InvalidateIndex(void)
+{
+  cMutexLock MutexLock(&indexMutex);
+  indexCount = -1;
+}
+
+int cTimers::FirstIndexEntry(const cChannel *Channel)
+{
+  int Low = 0;
+  int High = indexSize;
+  while (Low < High) {
+        int Mid = (Low + High) / 2;
+        if (index[Mid].channel < Channel)
+           Low = Mid + 1;
+        else
+           High = Mid;
+        }
+  return Low;
 }
 
 cTimer *cTimers::GetTimer(cTimer *Timer)
@@ -730,15 +848,22 @@ cTimer *cTimers::GetMatch(const cEvent *Event, int *Match)
 {
   cTimer *t = NULL;
   int m = tmNone;
-  for (cTimer *ti = First(); ti; ti = Next(ti)) {
-      int tm = ti->Matches(Event);
-      if (tm > m) {
-         t = ti;
-         m = tm;
-         if (m == tmFull)
-            break;
+  cMutexLock MutexLock(&indexMutex);
+  UpdateIndex();
+  if (const cChannel *Channel = Channels.GetByChannelID(Event->ChannelID())) { // cTimer::Matches() requires exactly the same channel id
+     int EventBegin = -1;
+     for (int i = FirstIndexEntry(Channel); i < indexSize && index[i].channel == Channel; i++) {
+         if (index[i].MayMatch(Event, EventBegin)) {
+            int tm = index[i].timer->Matches(Event);
+            if (tm > m) {
+               t = index[i].timer;
+               m = tm;
+               if (m == tmFull)
+                  break;
+               }
+            }
          }
-      }
+     }
   if (Match)
      *Match = m;
   return t;
@@ -763,18 +888,21 @@ void cTimers::SetModified(void)
 
 void cTimers::Add(cTimer *Timer, cTimer *After)
 {
+  InvalidateIndex();
   cConfig<cTimer>::Add(Timer, After);
   cStatus::MsgTimerChange(Timer, tcAdd);
 }
 
 void cTimers::Ins(cTimer *Timer, cTimer *Before)
 {
+  InvalidateIndex();
   cConfig<cTimer>::Ins(Timer, Before);
   cStatus::MsgTimerChange(Timer, tcAdd);
 }
 
 void cTimers::Del(cTimer *Timer, bool DeleteObject)
 {
+  InvalidateIndex();
   cStatus::MsgTimerChange(Timer, tcDel);
   cConfig<cTimer>::Del(Timer, DeleteObject);
 }
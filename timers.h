@@ -106,17 +106,35 @@ public:
   static cString PrintDay(time_t Day, int WeekDays, bool SingleByteChars);
   };
 
+struct tTimerIndexEntry;
+
 class cTimers : public cConfig<cTimer> {
 private:
   int state;
   int beingEdited;
   time_t lastSetEvents;
   time_t lastDeleteExpired;
+  cMutex indexMutex; // GetMatch(const cEvent *) may be called from any thread
+  tTimerIndexEntry *index; // the timers, sorted by channel, see UpdateIndex()
+  int indexSize;
+  int indexState;
+  int indexCount;
+  void UpdateIndex(void);
+       ///< Sorts the timers by their channels, unless they haven't been modified
+       ///< since the last call. The caller must hold indexMutex.
+  void InvalidateIndex(void);
+  int FirstIndexEntry(const cChannel *Channel);
+       ///< Returns the first entry in the index that belongs to the given Channel
+       ///< (or the position where it would be).
 public:
   cTimers(void);
+  virtual ~cTimers();
   cTimer *GetTimer(cTimer *Timer);
   cTimer *GetMatch(time_t t);
   cTimer *GetMatch(const cEvent *Event, int *Match = NULL);
+      ///< Returns the timer that matches the given Event best (see
+      ///< cTimer::Matches()), and the kind of match in Match. Only the timers
+      ///< on the Event's channel are checked.
   cTimer *GetNextActiveTimer(void);
   int BeingEdited(void) { return beingEdited; }
   void IncBeingEdited(void) { beingEdited++; }
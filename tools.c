@@ -19,6 +19,7 @@ extern "C" {
 #undef boolean
 }
 #include <stdlib.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/vfs.h>
 #include <time.h>
@@ -1739,6 +1740,46 @@ ssize_t cUnbufferedFile::Write(const void *Data, size_t Size)
   return -1;
 }
 
+ssize_t cUnbufferedFile::CopyFrom(cUnbufferedFile *Source, off_t Offset, size_t Size)
+{
+  if (fd >= 0 && Source && Source->fd >= 0) {
+#ifdef __NR_copy_file_range
+     off_t From = Offset;
+     size_t Copied = 0;
+     while (Copied < Size) {
+           ssize_t r = syscall(__NR_copy_file_range, Source->fd, &From, fd, NULL, Size - Copied, 0);
+           if (r < 0) {
+              if (errno == EINTR)
+                 continue;
+              if (Copied)
+                 break; // report what has been copied so far
+              return -1;
+              }
+           if (r == 0)
+              break; // end of source file
+           Copied += r;
+           }
+     curpos += Copied;
+#ifdef USE_FADVISE
+     // The data didn't pass through our own buffers, and if the file system
+     // shares the blocks (reflinks) it may never enter the page cache at all.
+     // Anything that did get cached is of no further use:
+     if (Copied) {
+        Source->FadviseDrop(Offset, Copied);
+        FadviseDrop(curpos - Copied, Copied);
+        totwritten += Copied;
+        }
+#endif
+     return Copied;
+#else
+     errno = ENOSYS;
+#endif
+     }
+  else
+     errno = EBADF;
+  return -1;
+}
+
 cUnbufferedFile *cUnbufferedFile::Create(const char *FileName, int Flags, mode_t Mode)
 {
   cUnbufferedFile *File = new cUnbufferedFile;
@@ -1818,6 +1859,7 @@ void cLockFile::Unlock(void)
 cListObject::cListObject(void)
 {
   prev = next = NULL;
+  index = -1;
 }
 
 cListObject::~cListObject()
@@ -1863,11 +1905,58 @@ cListBase::cListBase(void)
 {
   objects = lastObject = NULL;
   count = 0;
+  index = NULL;
+  indexSize = 0;
+  indexValid = false;
 }
 
 cListBase::~cListBase()
 {
   Clear();
+  free(index);
+}
+
+void cListBase::AppendIndex(cListObject *Object)
+{
+  if (indexValid) {
+     if (count > indexSize) {
+        int NewSize = max(count, 2 * indexSize);
+        if (cListObject **NewIndex = (cListObject **)realloc(index, NewSize * sizeof(cListObject *))) {
+           index = NewIndex;
+           indexSize = NewSize;
+           }
+        else {
+           indexValid = false;
+           return;
+           }
+        }
+     Object->index = count - 1;
+     index[Object->index] = Object;
+     }
+}
+
+static cMutex ListIndexMutex; // several threads may read the same list (like cChannels) at the same time
+
+void cListBase::UpdateIndex(void) const
+{
+  if (!indexValid) {
+     cMutexLock MutexLock(&ListIndexMutex);
+     if (!indexValid) {
+        if (count > indexSize) {
+           cListObject **NewIndex = (cListObject **)realloc(index, count * sizeof(cListObject *));
+           if (!NewIndex)
+              return;
+           index = NewIndex;
+           indexSize = count;
+           }
+        int i = 0;
+        for (cListObject *Object = objects; Object && i < count; Object = Object->Next()) {
+            Object->index = i;
+            index[i++] = Object;
+            }
+        indexValid = i == count;
+        }
+     }
 }
 
 void cListBase::Add(cListObject *Object, cListObject *After)
@@ -1875,6 +1964,7 @@ void cListBase::Add(cListObject *Object, cListObject *After)
   if (After && After != lastObject) {
      After->Next()->Insert(Object);
      After->Append(Object);
+     indexValid = false;
      }
   else {
      if (lastObject)
@@ -1884,6 +1974,8 @@ void cListBase::Add(cListObject *Object, cListObject *After)
      lastObject = Object;
      }
   count++;
+  if (Object == lastObject)
+     AppendIndex(Object);
 }
 
 void cListBase::Ins(cListObject *Object, cListObject *Before)
@@ -1900,6 +1992,7 @@ void cListBase::Ins(cListObject *Object, cListObject *Before)
      objects = Object;
      }
   count++;
+  indexValid = false;
 }
 
 void cListBase::Del(cListObject *Object, bool DeleteObject)
@@ -1908,6 +2001,8 @@ void cListBase::Del(cListObject *Object, bool DeleteObject)
      objects = Object->Next();
   if (Object == lastObject)
      lastObject = Object->Prev();
+  else
+     indexValid = false;
   Object->Unlink();
   if (DeleteObject)
      delete Object;
@@ -1922,8 +2017,9 @@ void cListBase::Move(int From, int To)
 void cListBase::Move(cListObject *From, cListObject *To)
 {
   if (From && To && From != To) {
-     if (From->Index() < To->Index())
+     if (Index(From) < Index(To))
         To = To->Next();
+     indexValid = false;
      if (From == objects)
         objects = From->Next();
      if (From == lastObject)
@@ -1952,18 +2048,30 @@ void cListBase::Clear(void)
         }
   objects = lastObject = NULL;
   count = 0;
+  indexValid = false;
 }
 
 cListObject *cListBase::Get(int Index) const
 {
-  if (Index < 0)
+  if (Index < 0 || Index >= count)
      return NULL;
+  UpdateIndex();
+  if (indexValid)
+     return index[Index];
   cListObject *object = objects;
   while (object && Index-- > 0)
         object = object->Next();
   return object;
 }
 
+int cListBase::Index(const cListObject *Object) const
+{
+  UpdateIndex();
+  if (indexValid && Object->index >= 0 && Object->index < count && index[Object->index] == Object)
+     return Object->index;
+  return Object->Index();
+}
+
 static int CompareListObjects(const void *a, const void *b)
 {
   const cListObject *la = *(const cListObject **)a;
@@ -1983,6 +2091,7 @@ void cListBase::Sort(void)
         }
   qsort(a, n, sizeof(cListObject *), CompareListObjects);
   objects = lastObject = NULL;
+  indexValid = false;
   for (i = 0; i < n; i++) {
       a[i]->Unlink();
       count--;
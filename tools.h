@@ -398,6 +398,17 @@ public:
   off_t Seek(off_t Offset, int Whence);
   ssize_t Read(void *Data, size_t Size);
   ssize_t Write(const void *Data, size_t Size);
+  ssize_t CopyFrom(cUnbufferedFile *Source, off_t Offset, size_t Size);
+       ///< Copies Size bytes, starting at Offset in Source, to the current position
+       ///< of this file, without passing the data through user space (the file
+       ///< system may even just share the data blocks, if it supports reflinks).
+       ///< The current position of Source is not changed.
+       ///< Returns the number of bytes actually copied, which may be less than Size
+       ///< if the end of Source has been reached or an error occurred after some
+       ///< data has already been copied. Returns -1 in case of an error before any
+       ///< data has been copied. If errno is ENOSYS, EXDEV, EINVAL or EOPNOTSUPP,
+       ///< the kernel or file system can't do this kind of copy, and the caller
+       ///< should fall back to Read() and Write().
   static cUnbufferedFile *Create(const char *FileName, int Flags, mode_t Mode = DEFFILEMODE);
   };
 
@@ -413,8 +424,10 @@ public:
   };
 
 class cListObject {
+  friend class cListBase;
 private:
   cListObject *prev, *next;
+  mutable int index; // position in the list, valid only as long as the list's index is
 public:
   cListObject(void);
   virtual ~cListObject();
@@ -430,6 +443,12 @@ public:
   };
 
 class cListBase {
+private:
+  mutable cListObject **index;
+  mutable int indexSize;
+  mutable bool indexValid;
+  void AppendIndex(cListObject *Object);
+  void UpdateIndex(void) const;
 protected:
   cListObject *objects, *lastObject;
   cListBase(void);
@@ -443,6 +462,15 @@ public:
   void Move(cListObject *From, cListObject *To);
   virtual void Clear(void);
   cListObject *Get(int Index) const;
+       ///< Returns the object at the given Index, or NULL if there is no such
+       ///< object. The list maintains an index of its objects, which is built
+       ///< when this function is first called and kept up to date when objects
+       ///< are appended to or removed from the end of the list, so that random
+       ///< access is O(1). Any other modification causes the index to be rebuilt
+       ///< on the next call.
+  int Index(const cListObject *Object) const;
+       ///< Returns the position of the given Object within this list, just like
+       ///< Object->Index(), but in O(1) (using the same index as Get()).
   int Count(void) const { return count; }
   void Sort(void);
   };
@@ -608,6 +608,7 @@ int main(int argc, char *argv[])
 
   Recordings.Update();
   DeletedRecordings.Update();
+  WatchVideoDirectory();
 
   // EPG data:
 
@@ -905,6 +906,8 @@ int main(int argc, char *argv[])
            // Delete expired timers:
            Timers.DeleteExpired();
            }
+        if (!Menu)
+           ApplyVideoDirectoryChanges();
         if (!Menu && Recordings.NeedsUpdate()) {
            Recordings.Update();
            DeletedRecordings.Update();
@@ -1214,10 +1217,11 @@ int main(int argc, char *argv[])
              default:    break;
              }
            }
+        cCutter::Active(); // cleans up finished editing processes and starts queued ones
         if (!Menu) {
            if (!InhibitEpgScan)
               EITScanner.Process();
-           if (!cCutter::Active() && cCutter::Ended()) {
+           if (cCutter::Ended()) {
               if (cCutter::Error())
                  Skins.Message(mtError, tr("Editing process failed!"));
               else
@@ -15,34 +15,42 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
 #include "recording.h"
+#include "thread.h"
 #include "tools.h"
 
+#define DISKSPACEREFRESH    10 // seconds between two statfs() calls on the video file systems
+#define PLACEMENTHORIZON  3600 // seconds of recording a new file's placement looks ahead
+#define PLACEMENTMINFREE  1024 // MB that shall remain free on a file system a new file is placed on
+#define DEFAULTTHROUGHPUT   50 // MB/s assumed for disks whose write throughput can't be measured
+#define MINBUSYTIME        100 // ms a disk must have been busy for its throughput to be measured
+
+#define REMOVALPAUSE       100 // ms to pause after each step of gradually removing a file
+#define REMOVALBACKOFF    5000 // ms to suspend gradual removal after a recorder has reported a backlog
+#define REMOVALMAXSUSPEND  300 // seconds a gradual removal may be suspended in total because of recorder backlogs
+#define REMOVALREPORTDELTA  10 // seconds between progress reports while gradually removing files
+
 const char *VideoDirectory = VIDEODIR;
 
 class cVideoDirectory {
 private:
-  char *name, *stored, *adjusted;
+  char *name;
   int length, number, digits;
 public:
   cVideoDirectory(void);
   ~cVideoDirectory();
-  int FreeMB(int *UsedMB = NULL);
   const char *Name(void) { return name ? name : VideoDirectory; }
-  const char *Stored(void) { return stored; }
   int Length(void) { return length; }
   bool IsDistributed(void) { return name != NULL; }
   bool Next(void);
-  void Store(void);
-  const char *Adjust(const char *FileName);
   };
 
 cVideoDirectory::cVideoDirectory(void)
 {
   length = strlen(VideoDirectory);
   name = (VideoDirectory[length - 1] == '0') ? strdup(VideoDirectory) : NULL;
-  stored = adjusted = NULL;
   number = -1;
   digits = 0;
 }
@@ -50,13 +58,6 @@ cVideoDirectory::cVideoDirectory(void)
 cVideoDirectory::~cVideoDirectory()
 {
   free(name);
-  free(stored);
-  free(adjusted);
-}
-
-int cVideoDirectory::FreeMB(int *UsedMB)
-{
-  return FreeDiskSpaceMB(name ? name : VideoDirectory, UsedMB);
 }
 
 bool cVideoDirectory::Next(void)
@@ -85,24 +86,483 @@ bool cVideoDirectory::Next(void)
   return false;
 }
 
-void cVideoDirectory::Store(void)
+// --- cVideoFileSystem -----------------------------------------------------
+
+class cVideoFileSystem : public cListObject {
+public:
+  char *name; // the (first) video directory on this file system
+  dev_t dev;
+  bool present; // false if none of the video directories is on this file system any more
+  int freeMB, usedMB; // as reported by the last statfs()
+  int writers; // the number of files currently being written to this file system
+  double rate; // the number of bytes per second currently being written to this file system
+  uint64_t sectors, ticks; // sectors written and ms busy, according to the disk's statistics
+  double throughput; // measured bytes per second the disk writes while it is busy, 0 = unknown
+  double utilization; // the fraction of the time the disk was busy since the last refresh
+  int placed; // the sequence number of the last file placed on this file system
+  cVideoFileSystem(const char *Name, dev_t Dev);
+  virtual ~cVideoFileSystem();
+  int FreeMB(time_t Since) const;
+       ///< Returns the estimated free space, taking into account what has been
+       ///< written since the last statfs() at the given time.
+  void UpdateDiskStats(int Elapsed);
+       ///< Updates the throughput and utilization from the kernel's statistics of
+       ///< the disk this file system is on, which have been read Elapsed seconds
+       ///< ago. Nothing is measured for file systems that aren't on a block device
+       ///< (like NFS).
+  double SpareThroughput(void) const;
+       ///< Returns the write throughput (in bytes per second) this disk has left.
+  };
+
+cVideoFileSystem::cVideoFileSystem(const char *Name, dev_t Dev)
+{
+  name = strdup(Name);
+  dev = Dev;
+  present = true;
+  freeMB = usedMB = 0;
+  writers = 0;
+  rate = 0;
+  sectors = ticks = 0;
+  throughput = 0;
+  utilization = 0;
+  placed = 0;
+}
+
+cVideoFileSystem::~cVideoFileSystem()
 {
-  if (name) {
-     free(stored);
-     stored = strdup(name);
-     }
+  free(name);
+}
+
+int cVideoFileSystem::FreeMB(time_t Since) const
+{
+  return max(0, freeMB - int(rate * max(0, int(time(NULL) - Since)) / MEGABYTE(1)));
 }
 
-const char *cVideoDirectory::Adjust(const char *FileName)
+void cVideoFileSystem::UpdateDiskStats(int Elapsed)
 {
-  if (stored) {
-     free(adjusted);
-     adjusted = strdup(FileName);
-     return strncpy(adjusted, stored, length);
+  if (!major(dev))
+     return; // not a block device
+  cString FileName = cString::sprintf("/sys/dev/block/%u:%u/stat", major(dev), minor(dev));
+  FILE *f = fopen(FileName, "r");
+  if (!f)
+     return;
+  unsigned long long s[10];
+  int n = fscanf(f, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", &s[0], &s[1], &s[2], &s[3], &s[4], &s[5], &s[6], &s[7], &s[8], &s[9]);
+  fclose(f);
+  if (n != 10)
+     return; // older kernels report only four values for partitions
+  // s[6] is the number of sectors written, s[9] the number of milliseconds spent doing I/O:
+  if (Elapsed > 0 && (sectors || ticks) && s[6] >= sectors && s[9] >= ticks) {
+     uint64_t Busy = s[9] - ticks;
+     utilization = min(1.0, double(Busy) / (Elapsed * 1000));
+     if (Busy >= MINBUSYTIME) {
+        double Measured = double(s[6] - sectors) * 512 * 1000 / Busy;
+        throughput = throughput ? 0.7 * throughput + 0.3 * Measured : Measured;
+        }
      }
+  sectors = s[6];
+  ticks = s[9];
+}
+
+double cVideoFileSystem::SpareThroughput(void) const
+{
+  if (throughput > 0)
+     return max(throughput * (1 - utilization), 0.0);
+  return MEGABYTE(DEFAULTTHROUGHPUT) * (1 - utilization);
+}
+
+// --- cVideoFileWriter ------------------------------------------------------
+
+class cVideoFileWriter : public cListObject {
+public:
+  cUnbufferedFile *file;
+  char *fileName;
+  cVideoFileSystem *fileSystem;
+  off_t size; // the size of the file at the last refresh
+  cVideoFileWriter(cUnbufferedFile *File, const char *FileName);
+  virtual ~cVideoFileWriter();
+  };
+
+cVideoFileWriter::cVideoFileWriter(cUnbufferedFile *File, const char *FileName)
+{
+  file = File;
+  fileName = strdup(FileName);
+  fileSystem = NULL;
+  size = -1;
+}
+
+cVideoFileWriter::~cVideoFileWriter()
+{
+  free(fileName);
+}
+
+// --- cVideoFileSystems -----------------------------------------------------
+
+// A model of the free space on all file systems of the (distributed) video
+// directory. statfs() is called at most every DISKSPACEREFRESH seconds, and
+// in between the free space is estimated from the rate at which the files
+// that are currently being recorded grow.
+
+class cVideoFileSystems {
+private:
+  cMutex mutex;
+  cList<cVideoFileSystem> fileSystems;
+  cList<cVideoFileWriter> writers;
+  time_t lastRefresh;
+  bool distributed;
+  int placements;
+  void Refresh(void);
+  cVideoFileSystem *Get(dev_t Dev);
+public:
+  cVideoFileSystems(void);
+  void Invalidate(void);
+       ///< Makes the next access call statfs() again, for instance because a
+       ///< file has been removed.
+  bool Place(char *FileName);
+       ///< Selects the video directory a new file shall be created in, preferring
+       ///< the file system with the fewest files currently being written to it,
+       ///< and out of those the one that will have the most free space left after
+       ///< PLACEMENTHORIZON seconds at the current rate of writing. If that
+       ///< is not the base video directory, the beginning of FileName is replaced
+       ///< with the name of the selected directory and true is returned.
+  void AddWriter(cUnbufferedFile *File, const char *FileName);
+  void DelWriter(cUnbufferedFile *File);
+  bool SpaceAvailable(int SizeMB);
+  void DiskSpace(int &FreeMB, int &UsedMB);
+  int FreeMB(const char *FileName);
+  bool Contains(const char *FileName);
+  };
+
+static cVideoFileSystems VideoFileSystems;
+
+cVideoFileSystems::cVideoFileSystems(void)
+{
+  lastRefresh = 0;
+  distributed = false;
+  placements = 0;
+}
+
+cVideoFileSystem *cVideoFileSystems::Get(dev_t Dev)
+{
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      if (fs->dev == Dev)
+         return fs;
+      }
   return NULL;
 }
 
+void cVideoFileSystems::Refresh(void)
+{
+  time_t Now = time(NULL);
+  if (lastRefresh && Now - lastRefresh < DISKSPACEREFRESH && Now >= lastRefresh)
+     return;
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      fs->present = false;
+      fs->writers = 0;
+      fs->rate = 0;
+      }
+  cVideoDirectory Dir;
+  distributed = Dir.IsDistributed();
+  do {
+     struct stat st;
+     if (stat(Dir.Name(), &st) == 0) {
+        cVideoFileSystem *fs = Get(st.st_dev);
+        if (!fs)
+           fileSystems.Add(fs = new cVideoFileSystem(Dir.Name(), st.st_dev));
+        else if (fs->present)
+           continue; // several video directories on the same file system
+        else if (strcmp(fs->name, Dir.Name()) != 0) {
+           free(fs->name);
+           fs->name = strdup(Dir.Name());
+           }
+        fs->present = true;
+        fs->freeMB = FreeDiskSpaceMB(fs->name, &fs->usedMB);
+        }
+     else
+        LOG_ERROR_STR(Dir.Name());
+     } while (Dir.Next());
+  int Elapsed = lastRefresh && Now > lastRefresh ? Now - lastRefresh : 0;
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      if (fs->present)
+         fs->UpdateDiskStats(Elapsed);
+      }
+  for (cVideoFileWriter *w = writers.First(); w; w = writers.Next(w)) {
+      struct stat st;
+      if (stat(w->fileName, &st) == 0) {
+         if ((w->fileSystem = Get(st.st_dev)) != NULL) {
+            w->fileSystem->writers++;
+            if (Elapsed && w->size >= 0 && st.st_size > w->size)
+               w->fileSystem->rate += double(st.st_size - w->size) / Elapsed;
+            }
+         w->size = st.st_size;
+         }
+      else
+         w->fileSystem = NULL;
+      }
+  lastRefresh = Now;
+}
+
+void cVideoFileSystems::Invalidate(void)
+{
+  cMutexLock MutexLock(&mutex);
+  lastRefresh = 0;
+}
+
+static dev_t PreviousSegmentDevice(const char *FileName)
+{
+  // Video files are named like ".../00001.ts", so the previous segment of
+  // a recording is the file with the next lower number in the same directory:
+  const char *p = strrchr(FileName, '/');
+  if (p++) {
+     int Digits = strspn(p, "0123456789");
+     int Number = atoi(p);
+     if (Digits && Number > 1) {
+        cString Previous = cString::sprintf("%.*s%0*d%s", int(p - FileName), FileName, Digits, Number - 1, p + Digits);
+        struct stat st;
+        if (stat(Previous, &st) == 0)
+           return st.st_dev;
+        }
+     }
+  return 0;
+}
+
+bool cVideoFileSystems::Place(char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  Refresh();
+  dev_t Previous = Setup.StripeVideoFiles ? PreviousSegmentDevice(FileName) : 0;
+  cVideoFileSystem *Best = NULL;
+  int BestFree = 0;
+  bool BestOk = false;
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      if (!fs->present)
+         continue;
+      int Free = fs->FreeMB(lastRefresh) - int(fs->rate * PLACEMENTHORIZON / MEGABYTE(1));
+      // When striping, the disk the previous segment of this recording has been
+      // written to is only used if no other one can take the file:
+      bool Ok = Free >= PLACEMENTMINFREE && (!Previous || fs->dev != Previous);
+      if (Best) {
+         if (Ok != BestOk) {
+            if (!Ok)
+               continue;
+            }
+         else if (Ok && Setup.StripeVideoFiles) {
+            // Put the file where the most write throughput is left per writer,
+            // taking turns among disks that are equally good:
+            double Spare = fs->SpareThroughput() / (fs->writers + 1);
+            double BestSpare = Best->SpareThroughput() / (Best->writers + 1);
+            if (Spare < BestSpare || Spare == BestSpare && fs->placed >= Best->placed)
+               continue;
+            }
+         else if (Ok && fs->writers != Best->writers) {
+            if (fs->writers > Best->writers)
+               continue;
+            }
+         else if (Free <= BestFree)
+            continue;
+         }
+      Best = fs;
+      BestFree = Free;
+      BestOk = Ok;
+      }
+  if (Best)
+     Best->placed = ++placements;
+  if (Best && strcmp(Best->name, VideoDirectory) != 0) {
+     memcpy(FileName, Best->name, strlen(Best->name));
+     return true;
+     }
+  return false;
+}
+
+void cVideoFileSystems::AddWriter(cUnbufferedFile *File, const char *FileName)
+{
+  cMutexLock MutexLock(&mutex);
+  cVideoFileWriter *w = new cVideoFileWriter(File, FileName);
+  struct stat st;
+  if (stat(FileName, &st) == 0) {
+     if ((w->fileSystem = Get(st.st_dev)) != NULL)
+        w->fileSystem->writers++; // so that concurrent recordings are spread even before the next refresh
+     w->size = st.st_size;
+     }
+  writers.Add(w);
+}
+
+void cVideoFileSystems::DelWriter(cUnbufferedFile *File)
+{
+  cMutexLock MutexLock(&mutex);
+  for (cVideoFileWriter *w = writers.First(); w; w = writers.Next(w)) {
+      if (w->file == File) {
+         if (w->fileSystem && w->fileSystem->writers > 0)
+            w->fileSystem->writers--;
+         writers.Del(w);
+         break;
+         }
+      }
+}
+
+bool cVideoFileSystems::SpaceAvailable(int SizeMB)
+{
+  cMutexLock MutexLock(&mutex);
+  Refresh();
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      if (fs->present) {
+         if (distributed && strcmp(fs->name, VideoDirectory) == 0) {
+            if (fs->FreeMB(lastRefresh) >= SizeMB * 2) // base directory needs additional space
+               return true;
+            }
+         else if (fs->FreeMB(lastRefresh) >= SizeMB)
+            return true;
+         }
+      }
+  return false;
+}
+
+void cVideoFileSystems::DiskSpace(int &FreeMB, int &UsedMB)
+{
+  cMutexLock MutexLock(&mutex);
+  Refresh();
+  FreeMB = UsedMB = 0;
+  for (cVideoFileSystem *fs = fileSystems.First(); fs; fs = fileSystems.Next(fs)) {
+      if (fs->present) {
+         int Free = fs->FreeMB(lastRefresh);
+         FreeMB += Free;
+         UsedMB += fs->usedMB + fs->freeMB - Free;
+         }
+      }
+}
+
+int cVideoFileSystems::FreeMB(const char *FileName)
+{
+  struct stat st;
+  if (stat(FileName, &st) == 0) {
+     cMutexLock MutexLock(&mutex);
+     Refresh();
+     if (cVideoFileSystem *fs = Get(st.st_dev)) {
+        if (fs->present)
+           return fs->FreeMB(lastRefresh);
+        }
+     }
+  return FreeDiskSpaceMB(FileName);
+}
+
+bool cVideoFileSystems::Contains(const char *FileName)
+{
+  struct stat st;
+  if (stat(FileName, &st) == 0) {
+     cMutexLock MutexLock(&mutex);
+     Refresh();
+     cVideoFileSystem *fs = Get(st.st_dev);
+     return fs && fs->present;
+     }
+  LOG_ERROR_STR(FileName);
+  return false;
+}
+
+// --- Gradual removal -------------------------------------------------------
+
+static cMutex RemovalMutex;
+static uint64_t RemovalBudgetNext = 0; // the time (in ms) at which the next step may be taken
+static uint64_t LastWriteBacklog = 0; // the time (in ms) a recorder last reported a backlog
+
+void VideoFileWriteBacklog(void)
+{
+  cMutexLock MutexLock(&RemovalMutex);
+  LastWriteBacklog = cTimeMs::Now();
+}
+
+static bool ThrottleRemoval(off_t Bytes, cGradualRemoval *Gradually, int &SuspendedMs)
+{
+  // Stay out of the way of recorders that can't keep up (but only for so long):
+  bool Suspended = false;
+  while (SuspendedMs < REMOVALMAXSUSPEND * 1000 && !Gradually->Urgent()) {
+        RemovalMutex.Lock();
+        bool Backlog = LastWriteBacklog && cTimeMs::Now() - LastWriteBacklog < REMOVALBACKOFF;
+        RemovalMutex.Unlock();
+        if (!Backlog)
+           break;
+        if (!Suspended)
+           dsyslog("recorder backlog - suspending removal of deleted recordings");
+        Suspended = true;
+        if (Gradually->Cancelled())
+           return false;
+        cCondWait::SleepMs(REMOVALPAUSE);
+        SuspendedMs += REMOVALPAUSE;
+        if (SuspendedMs >= REMOVALMAXSUSPEND * 1000)
+           isyslog("removal of deleted recording suspended for %d seconds - ignoring recorder backlog", REMOVALMAXSUSPEND);
+        }
+  if (Suspended)
+     dsyslog("resuming removal of deleted recordings");
+  // Stay within the global budget:
+  int Wait = REMOVALPAUSE;
+  if (Setup.RemovalBandwidth > 0) {
+     RemovalMutex.Lock();
+     uint64_t Now = cTimeMs::Now();
+     if (RemovalBudgetNext < Now)
+        RemovalBudgetNext = Now;
+     Wait = max(Wait, int(RemovalBudgetNext - Now));
+     RemovalBudgetNext += uint64_t(Bytes) * 1000 / MEGABYTE(Setup.RemovalBandwidth);
+     RemovalMutex.Unlock();
+     }
+  for (; Wait > 0; Wait -= REMOVALPAUSE) {
+      if (Gradually->Cancelled())
+         return false;
+      cCondWait::SleepMs(min(Wait, REMOVALPAUSE));
+      }
+  return !Gradually->Cancelled();
+}
+
+static bool TruncateVideoFiles(const char *DirName, cGradualRemoval *Gradually, off_t &Reclaimed)
+{
+  off_t Step = MEGABYTE(off_t(Setup.RemovalStep));
+  off_t Total = 0;
+  cStringList FileNames;
+  cReadDir d(DirName);
+  if (d.Ok()) {
+     struct dirent *e;
+     while ((e = d.Next()) != NULL) {
+           cString FileName = AddDirectory(DirName, e->d_name);
+           struct stat st;
+           if (stat(FileName, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > Step) { // small files are removed at once
+              FileNames.Append(strdup(FileName));
+              Total += st.st_size;
+              }
+           }
+     }
+  int SuspendedMs = 0;
+  time_t LastReport = time(NULL);
+  for (int i = 0; i < FileNames.Size(); i++) {
+      int f = open(FileNames[i], O_WRONLY);
+      struct stat st;
+      if (f < 0 || fstat(f, &st) < 0) {
+         LOG_ERROR_STR(FileNames[i]);
+         if (f >= 0)
+            close(f);
+         continue;
+         }
+      for (off_t Size = st.st_size; Size > 0; ) {
+          off_t NewSize = max(Size - Step, off_t(0));
+          if (!ThrottleRemoval(Size - NewSize, Gradually, SuspendedMs)) {
+             close(f);
+             return false;
+             }
+          if (ftruncate(f, NewSize) < 0) {
+             LOG_ERROR_STR(FileNames[i]);
+             break;
+             }
+          Reclaimed += Size - NewSize;
+          Size = NewSize;
+          if (time(NULL) - LastReport >= REMOVALREPORTDELTA) {
+             dsyslog("removing %s: %d of %d MB reclaimed", DirName, int(Reclaimed / MEGABYTE(1)), int(Total / MEGABYTE(1)));
+             LastReport = time(NULL);
+             }
+          }
+      close(f);
+      }
+  return true;
+}
+
+// --- Video files -----------------------------------------------------------
+
 cUnbufferedFile *OpenVideoFile(const char *FileName, int Flags)
 {
   const char *ActualFileName = FileName;
@@ -117,28 +577,26 @@ cUnbufferedFile *OpenVideoFile(const char *FileName, int Flags)
   if ((Flags & O_CREAT) != 0) {
      cVideoDirectory Dir;
      if (Dir.IsDistributed()) {
-        // Find the directory with the most free space:
-        int MaxFree = Dir.FreeMB();
-        while (Dir.Next()) {
-              int Free = FreeDiskSpaceMB(Dir.Name());
-              if (Free > MaxFree) {
-                 Dir.Store();
-                 MaxFree = Free;
-                 }
-              }
-        if (Dir.Stored()) {
-           ActualFileName = Dir.Adjust(FileName);
-           if (!MakeDirs(ActualFileName, false))
+        char *Adjusted = strdup(FileName);
+        if (VideoFileSystems.Place(Adjusted)) {
+           ActualFileName = Adjusted;
+           if (!MakeDirs(ActualFileName, false)) {
+              free(Adjusted);
               return NULL; // errno has been set by MakeDirs()
+              }
            if (symlink(ActualFileName, FileName) < 0) {
               LOG_ERROR_STR(FileName);
+              free(Adjusted);
               return NULL;
               }
-           ActualFileName = strdup(ActualFileName); // must survive Dir!
            }
+        else
+           free(Adjusted);
         }
      }
   cUnbufferedFile *File = cUnbufferedFile::Create(ActualFileName, Flags, DEFFILEMODE);
+  if (File && (Flags & O_CREAT) != 0)
+     VideoFileSystems.AddWriter(File, FileName);
   if (ActualFileName != FileName)
      free((char *)ActualFileName);
   return File;
@@ -146,6 +604,7 @@ cUnbufferedFile *OpenVideoFile(const char *FileName, int Flags)
 
 int CloseVideoFile(cUnbufferedFile *File)
 {
+  VideoFileSystems.DelWriter(File);
   int Result = File->Close();
   delete File;
   return Result;
@@ -163,36 +622,40 @@ bool RenameVideoFile(const char *OldName, const char *NewName)
   return true;
 }
 
-bool RemoveVideoFile(const char *FileName)
+bool RemoveVideoFile(const char *FileName, cGradualRemoval *Gradually)
 {
-  return RemoveFileOrDir(FileName, true);
+  if (Gradually && Setup.RemovalStep > 0 && DirectoryOk(FileName)) {
+     time_t Start = time(NULL);
+     off_t Reclaimed = 0;
+     bool Completed = TruncateVideoFiles(FileName, Gradually, Reclaimed);
+     if (Reclaimed)
+        isyslog("truncated %s gradually: %d MB reclaimed in %d seconds", FileName, int(Reclaimed / MEGABYTE(1)), int(time(NULL) - Start));
+     if (!Completed) {
+        isyslog("removal of %s cancelled", FileName);
+        VideoFileSystems.Invalidate();
+        return false;
+        }
+     }
+  bool Result = RemoveFileOrDir(FileName, true);
+  VideoFileSystems.Invalidate();
+  return Result;
 }
 
 bool VideoFileSpaceAvailable(int SizeMB)
 {
-  cVideoDirectory Dir;
-  if (Dir.IsDistributed()) {
-     if (Dir.FreeMB() >= SizeMB * 2) // base directory needs additional space
-        return true;
-     while (Dir.Next()) {
-           if (Dir.FreeMB() >= SizeMB)
-              return true;
-           }
-     return false;
-     }
-  return Dir.FreeMB() >= SizeMB;
+  return VideoFileSystems.SpaceAvailable(SizeMB);
+}
+
+int VideoFileFreeMB(const char *FileName)
+{
+  return VideoFileSystems.FreeMB(FileName);
 }
 
 int VideoDiskSpace(int *FreeMB, int *UsedMB)
 {
   int free = 0, used = 0;
   int deleted = DeletedRecordings.TotalFileSizeMB();
-  cVideoDirectory Dir;
-  do {
-     int u;
-     free += Dir.FreeMB(&u);
-     used += u;
-     } while (Dir.Next());
+  VideoFileSystems.DiskSpace(free, used);
   if (deleted > used)
      deleted = used; // let's not get beyond 100%
   free += deleted;
@@ -234,10 +697,5 @@ void RemoveEmptyVideoDirectories(void)
 
 bool IsOnVideoDirectoryFileSystem(const char *FileName)
 {
-  cVideoDirectory Dir;
-  do {
-     if (EntriesOnSameFileSystem(Dir.Name(), FileName))
-        return true;
-     } while (Dir.Next());
-  return false;
+  return VideoFileSystems.Contains(FileName);
 }
@@ -18,8 +18,34 @@ extern const char *VideoDirectory;
 cUnbufferedFile *OpenVideoFile(const char *FileName, int Flags);
 int CloseVideoFile(cUnbufferedFile *File);
 bool RenameVideoFile(const char *OldName, const char *NewName);
-bool RemoveVideoFile(const char *FileName);
+class cGradualRemoval {
+public:
+  virtual ~cGradualRemoval() {}
+  virtual bool Urgent(void) = 0;
+       ///< Returns true if the space is needed right away, in which case the
+       ///< removal is not suspended because of a recorder's backlog.
+  virtual bool Cancelled(void) = 0;
+       ///< Returns true if the removal shall be stopped (for instance because
+       ///< the calling thread is being cancelled).
+  };
+
+bool RemoveVideoFile(const char *FileName, cGradualRemoval *Gradually = NULL);
+     ///< Removes the given video file or directory. If Gradually is given and
+     ///< Setup.RemovalStep is set, large files are first truncated step by step
+     ///< within the I/O budget of Setup.RemovalBandwidth, which may take quite
+     ///< a while, so this should only be done in a background thread.
+     ///< If Gradually is cancelled, the remaining files are left in place and
+     ///< false is returned.
+void VideoFileWriteBacklog(void);
+     ///< Tells the video directory functions that a recorder can't write its
+     ///< data fast enough, so any gradual removal of files that isn't urgent is
+     ///< suspended for a while.
 bool VideoFileSpaceAvailable(int SizeMB);
+int VideoFileFreeMB(const char *FileName);
+     ///< Returns the free space (in MB) on the file system FileName is on. For
+     ///< the video file systems this is taken from a model that calls statfs()
+     ///< only every few seconds and estimates the space used by the ongoing
+     ///< recordings in between.
 int VideoDiskSpace(int *FreeMB = NULL, int *UsedMB = NULL); // returns the used disk space in percent
 cString PrefixVideoFileName(const char *FileName, char Prefix);
 void RemoveEmptyVideoDirectories(void);